@@ -0,0 +1,305 @@
+/* app-cds.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "format2str.h"
+#include "path-concat.h"
+#include "log.h"
+#include "proc-stats.h"
+#include "app-cds.h"
+
+using namespace logger;
+
+// FileMapHeader magic numbers of HotSpot CDS archives
+static const uint32_t static_archive_magic = 0xf00baba2;
+static const uint32_t dynamic_archive_magic = 0xf00baba8;
+
+static const char archive_prefix[] = "app-";
+
+uint64_t app_cds::fnv1a(const void *data, size_t len, uint64_t hash) {
+  const auto *bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < len; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static uint64_t hash_str(const std::string &str, uint64_t hash) {
+  return app_cds::fnv1a(str.c_str(), str.size() + 1, hash); // the terminator separates adjacent strings
+}
+
+bool app_cds::is_valid_archive(const std::string &path) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return false;
+  uint32_t magic = 0;
+  struct stat statbuf{};
+  const bool is_valid = pread(fd, &magic, sizeof(magic), 0) == sizeof(magic) && fstat(fd, &statbuf) == 0 &&
+                        statbuf.st_size >= 4096 && (magic == static_archive_magic || magic == dynamic_archive_magic);
+  close(fd);
+  return is_valid;
+}
+
+// removes the least recently used archives beyond keep and leftovers of watchdogs no longer running
+static void prune_archives(const std::string &dir_path, unsigned keep) {
+  std::vector<std::pair<time_t, std::string>> archives;
+  DIR * const dir = opendir(dir_path.c_str());
+  if (dir == nullptr) return;
+  for (const struct dirent *ent = readdir(dir); ent != nullptr; ent = readdir(dir)) {
+    if (strncmp(ent->d_name, archive_prefix, sizeof(archive_prefix) - 1) != 0) continue;
+    auto path = path_concat(dir_path, ent->d_name);
+    const size_t len = strlen(ent->d_name);
+    if (len > 4 && strcmp(ent->d_name + len - 4, ".jsa") == 0) {
+      struct stat statbuf{};
+      if (stat(path.c_str(), &statbuf) == 0) archives.emplace_back(statbuf.st_mtime, std::move(path));
+      continue;
+    }
+    // app-<key>.<pid>.tmp or app-<key>.<pid>.classlist of the watchdog that is dumping it
+    const char * const dot = strchr(ent->d_name, '.');
+    const long pid = dot == nullptr ? 0 : strtol(dot + 1, nullptr, 10);
+    if (pid > 0 && kill((pid_t) pid, 0) == -1 && errno == ESRCH) {
+      unlink(path.c_str());
+    }
+  }
+  closedir(dir);
+  if (archives.size() <= keep) return;
+  std::sort(archives.begin(), archives.end());
+  for (size_t i = 0; i < archives.size() - keep; i++) {
+    log(LL::DEBUG, "removing least recently used AppCDS archive \"%s\"", archives[i].second.c_str());
+    unlink(archives[i].second.c_str());
+  }
+}
+
+app_cds::app_cds(const cds_settings &cfg, const jdk_info &jdk) : cfg{cfg}, jdk{jdk},
+    archive_dir{!cfg.archive_dir.empty() ? cfg.archive_dir : format2str("/tmp/java-watchdog-cds-%u", geteuid())} {}
+
+bool app_cds::is_private_dir() const {
+  // the JVM maps the archives it is given, so only a directory no other user can plant files in will do
+  if (mkdir(archive_dir.c_str(), 0700) == -1 && errno != EEXIST) {
+    log(LL::WARN, "could not create AppCDS archive directory \"%s\": %s", archive_dir.c_str(), strerror(errno));
+    return false;
+  }
+  struct stat statbuf{};
+  if (lstat(archive_dir.c_str(), &statbuf) == -1) {
+    log(LL::WARN, "could not stat AppCDS archive directory \"%s\": %s", archive_dir.c_str(), strerror(errno));
+    return false;
+  }
+  if (!S_ISDIR(statbuf.st_mode) || statbuf.st_uid != geteuid() || (statbuf.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+    log(LL::WARN, "AppCDS archive directory \"%s\" is not a directory of uid %u writable by it alone - AppCDS "
+        "archive not managed", archive_dir.c_str(), geteuid());
+    return false;
+  }
+  return true;
+}
+
+void app_cds::inject(jvm_args &args, std::string option) {
+  injected.push_back(option);
+  args.inject(std::move(option));
+}
+
+void app_cds::prepare(jvm_args &args) {
+  if (!injected.empty()) {
+    // the options of the previous launch, e.g. the ArchiveClassesAtExit of a dump since installed
+    // (each removed once: the first occurrence is the injected one, ahead of those of the user)
+    args.remove_options([this](const std::string_view option) {
+      const auto found = std::find(injected.begin(), injected.end(), option);
+      if (found == injected.end()) return false;
+      injected.erase(found);
+      return true;
+    });
+    injected.clear();
+  }
+  stage = STAGE::NONE;
+  if (!cfg.enabled) return;
+  if (jdk.version.empty()) {
+    log(LL::DEBUG, "JDK version of \"%s\" undetermined - AppCDS archive not managed", jdk.java_path.c_str());
+    return;
+  }
+  for (const char * const option : { "-XX:SharedArchiveFile=", "-XX:ArchiveClassesAtExit=", "-Xshare:" }) {
+    if (args.has_option(option)) {
+      log(LL::DEBUG, "class data sharing configured on the command line (%s) - AppCDS archive not managed", option);
+      return;
+    }
+  }
+  if (!is_private_dir()) return;
+  prune_archives(archive_dir, cfg.max_archives);
+
+  uint64_t key = hash_str(jdk.java_path, fnv1a(nullptr, 0));
+  key = hash_str(jdk.version, key);
+  if (!is_keyed) {
+    // (the options a relaunch is tuned with - see jvm_tuner - would otherwise select another archive)
+    const auto end = std::min(args.main_index() + 1, args.size());
+    for (size_t i = 1; i < end; i++) {
+      options.push_back(args[i]);
+    }
+    is_keyed = true;
+  }
+  for (const auto &option : options) {
+    key = hash_str(option, key);
+  }
+  std::string joined;
+  for (const auto &path : args.classpath()) {
+    struct stat statbuf{};
+    if (stat(path.c_str(), &statbuf) == 0) {
+      const int64_t stamp[] = { (int64_t) statbuf.st_size, (int64_t) statbuf.st_mtim.tv_sec, statbuf.st_mtim.tv_nsec };
+      key = fnv1a(stamp, sizeof(stamp), key);
+    }
+    key = hash_str(path, key);
+    if (!joined.empty()) joined += ':';
+    joined += path;
+  }
+  const auto base_path = path_concat(archive_dir, format2str("%s%016lx", archive_prefix, (unsigned long) key));
+  archive_path = base_path + ".jsa";
+
+  if (is_valid_archive(archive_path)) {
+    if (jdk.feature < 10) {
+      inject(args, "-XX:+UnlockDiagnosticVMOptions"); // SharedArchiveFile is a diagnostic option of JDK 8
+    }
+    inject(args, "-XX:SharedArchiveFile=" + archive_path);
+    inject(args, "-Xshare:auto"); // the JVM falls back to loading classes should it reject the archive
+    utimensat(AT_FDCWD, archive_path.c_str(), nullptr, 0); // marks it most recently used
+    stage = STAGE::USE;
+    log(LL::INFO, "using AppCDS archive \"%s\"", archive_path.c_str());
+    return;
+  }
+  if (access(archive_path.c_str(), F_OK) == 0) {
+    log(LL::WARN, "discarding invalid AppCDS archive \"%s\"", archive_path.c_str());
+    unlink(archive_path.c_str());
+  }
+
+  tmp_path = format2str("%s.%d.tmp", base_path.c_str(), getpid());
+  if (jdk.feature >= 13) {
+    inject(args, "-XX:ArchiveClassesAtExit=" + tmp_path);
+    stage = STAGE::DUMP_AT_EXIT;
+  } else if (jdk.feature >= 10) {
+    class_list_path = format2str("%s.%d.classlist", base_path.c_str(), getpid());
+    inject(args, "-XX:DumpLoadedClassList=" + class_list_path);
+    classpath = std::move(joined);
+    stage = STAGE::DUMP_CLASS_LIST;
+  } else {
+    stage = STAGE::DUMP_BOOT;
+  }
+  log(LL::INFO, "AppCDS archive \"%s\" to be created for JDK %s", archive_path.c_str(), jdk.version.c_str());
+}
+
+app_cds::~app_cds() {
+  if (dump_pid <= 0) return;
+  // (the watchdog exits without waiting on the dump)
+  if (dump_timer != -1) loop->cancel_timer(dump_timer);
+  kill(-dump_pid, SIGKILL);
+  waitpid(dump_pid, nullptr, 0);
+  unlink(tmp_path.c_str());
+}
+
+bool app_cds::start_dump(const std::vector<std::string> &dump_args) {
+  std::vector<const char*> argv;
+  argv.reserve(dump_args.size() + 2);
+  argv.push_back(jdk.java_path.c_str());
+  for (const auto &arg : dump_args) {
+    argv.push_back(arg.c_str());
+  }
+  argv.push_back(nullptr);
+
+  dump_ns = monotonic_ns();
+  const pid_t pid = fork();
+  if (pid == -1) {
+    log(LL::WARN, "fork() of AppCDS archive dump failed: %s", strerror(errno));
+    return false;
+  }
+  if (pid == 0) {
+    setpgid(0, 0); // a process group of its own, killed as a whole on timeout
+    sigset_t no_signals;
+    sigemptyset(&no_signals);
+    sigprocmask(SIG_SETMASK, &no_signals, nullptr);
+    const int null_fd = open("/dev/null", O_RDWR);
+    dup2(null_fd, STDOUT_FILENO);
+    dup2(null_fd, STDERR_FILENO);
+    execv(argv[0], (char**) argv.data());
+    _exit(127);
+  }
+  setpgid(pid, pid); // (either side may run first)
+  dump_pid = pid;
+  // the dump is reaped along with the watchdog's other children, so it is only ever sent SIGKILL here
+  dump_timer = loop->add_timer(cfg.dump_timeout, [this]() {
+    dump_timer = -1;
+    log(LL::WARN, "AppCDS archive dump (pid:%d) exceeded %ld ms - killing it", dump_pid,
+        (long) cfg.dump_timeout.count());
+    kill(-dump_pid, SIGKILL);
+  }, false);
+  return true;
+}
+
+bool app_cds::reaped(pid_t pid, int status) {
+  if (pid != dump_pid || dump_pid <= 0) return false;
+  if (dump_timer != -1) loop->cancel_timer(dump_timer);
+  dump_timer = -1;
+  dump_pid = 0;
+  log(LL::DEBUG, "AppCDS archive dump (pid:%d) exit status %d after %ld ms", pid, status,
+      (long) ((monotonic_ns() - dump_ns) / 1000000));
+  // (a killed dump may have left an incomplete archive)
+  is_orderly = is_orderly && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  install();
+  return true;
+}
+
+void app_cds::finish(event_loop &event_loop, bool is_orderly_exit, std::function<void()> on_finished) {
+  loop = &event_loop;
+  is_orderly = is_orderly_exit;
+  this->on_finished = std::move(on_finished);
+  struct stat statbuf{};
+  if (stage == STAGE::DUMP_CLASS_LIST && is_orderly_exit && stat(class_list_path.c_str(), &statbuf) == 0 &&
+      statbuf.st_size > 0)
+  {
+    if (start_dump({ "-Xshare:dump", "-XX:SharedClassListFile=" + class_list_path, "-XX:SharedArchiveFile=" + tmp_path,
+                     "-cp", classpath })) return;
+  } else if (stage == STAGE::DUMP_BOOT && is_orderly_exit) {
+    if (start_dump({ "-XX:+UnlockDiagnosticVMOptions", "-Xshare:dump", "-XX:SharedArchiveFile=" + tmp_path })) return;
+  }
+  install();
+}
+
+// installs the dumped archive (if any), then reports the finish
+void app_cds::install() {
+  if (stage != STAGE::NONE && stage != STAGE::USE) {
+    if (stage == STAGE::DUMP_CLASS_LIST) {
+      unlink(class_list_path.c_str());
+    }
+    stage = STAGE::NONE;
+    // an archive of a JVM that was killed may be incomplete so only that of an orderly exit is installed
+    if (is_orderly && is_valid_archive(tmp_path) && rename(tmp_path.c_str(), archive_path.c_str()) == 0) {
+      log(LL::INFO, "installed AppCDS archive \"%s\"", archive_path.c_str());
+    } else {
+      log(LL::DEBUG, "no AppCDS archive installed for \"%s\"", archive_path.c_str());
+      unlink(tmp_path.c_str());
+    }
+  }
+  const auto handler = std::move(this->on_finished);
+  this->on_finished = nullptr;
+  if (handler) handler();
+}
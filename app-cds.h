@@ -0,0 +1,98 @@
+/* app-cds.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __APP_CDS_H__
+#define __APP_CDS_H__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+#include "jdk-info.h"
+#include "jvm-args.h"
+
+/**
+ * Manages an application class data sharing (AppCDS) archive per distinct
+ * JVM launch, keyed by a hash of the resolved java launcher, the JDK version,
+ * the JVM options and the class path jars (paths, sizes and mtimes). A change
+ * of any of these selects a different archive, so a stale one is never used.
+ * <p>
+ * Without a valid archive the launch is set up to produce one: JDK 13+ dumps
+ * a dynamic archive at JVM exit (-XX:ArchiveClassesAtExit); JDK 10 to 12 dump
+ * the loaded class list, from which -Xshare:dump builds the archive once the
+ * JVM has exited; older JDKs get an -Xshare:dump of the boot classes. Such a
+ * dump runs as a child of the watchdog, watched from its event loop. The
+ * archive is written under a temporary name and only installed if valid.
+ * <p>
+ * As the JVM maps the archives it is given, their directory must be owned by
+ * the watchdog's effective uid and writable by it alone, else CDS is left
+ * unmanaged.
+ */
+class app_cds {
+private:
+  enum class STAGE : char { NONE, USE, DUMP_AT_EXIT, DUMP_CLASS_LIST, DUMP_BOOT };
+  const cds_settings &cfg;
+  const jdk_info &jdk;
+  const std::string archive_dir;      // that of the settings, or else a directory private to the effective uid
+  STAGE stage{STAGE::NONE};
+  std::string archive_path;
+  std::string tmp_path;
+  std::string class_list_path;
+  std::string classpath;
+  std::vector<std::string> options;   // JVM options of the first launch, keying the archive of every launch
+  bool is_keyed{false};
+  std::vector<std::string> injected;  // options prepare() injected, removed again by the next prepare()
+  event_loop *loop{nullptr};
+  pid_t dump_pid{0};                  // of the -Xshare:dump run in progress
+  int64_t dump_ns{0};
+  int dump_timer{-1};
+  bool is_orderly{false};
+  std::function<void()> on_finished;
+  void inject(jvm_args &args, std::string option);
+  bool is_private_dir() const;
+  bool start_dump(const std::vector<std::string> &dump_args);
+  void install();
+public:
+  app_cds(const cds_settings &cfg, const jdk_info &jdk);
+  app_cds(const app_cds &) = delete;
+  app_cds& operator=(const app_cds &) = delete;
+  ~app_cds();
+
+  // injects the CDS options into the JVM command line (replacing those of the previous launch); call prior to
+  // fork() of each launch
+  void prepare(jvm_args &args);
+  // installs an archive dumped by (or on behalf of) the terminated JVM (only after an orderly exit) and then calls
+  // on_finished - at once or, should an -Xshare:dump be run first, once reaped() reports it done
+  void finish(event_loop &event_loop, bool is_orderly_exit, std::function<void()> on_finished);
+  // true if pid, reaped by the watchdog, is the -Xshare:dump run in progress (whose archive is then installed)
+  bool reaped(pid_t pid, int status);
+
+  bool is_archive_in_use() const { return stage == STAGE::USE; }
+  const std::string& archive() const { return archive_path; }
+
+  // true if the file starts with the magic number of a static or dynamic CDS archive
+  static bool is_valid_archive(const std::string &path);
+  // FNV-1a 64-bit hash
+  static uint64_t fnv1a(const void *data, size_t len, uint64_t hash = 0xcbf29ce484222325ULL);
+};
+
+#endif //__APP_CDS_H__
@@ -0,0 +1,533 @@
+/* arbiter.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "format2str.h"
+#include "log.h"
+#include "arbiter.h"
+
+//#define TEST_ARBITER // uncomment to enable the test code below
+
+using namespace logger;
+
+namespace {
+
+  const int jcmd_timeout_ms = 2 * 60 * 1000; // GC.run of a large heap takes a while
+  const int64_t election_warn_interval_ns = 60LL * 1000000000LL;
+  const unsigned stale_reports = 3;     // a member silent for this many report intervals is dropped
+
+  // the node's total and available memory per /proc/meminfo
+  bool read_meminfo(uint64_t &total_kb, uint64_t &available_kb) {
+    char buf[512];
+    const int fd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    const ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return false;
+    buf[n] = '\0';
+    const char * const total = strstr(buf, "MemTotal:");
+    const char * const available = strstr(buf, "MemAvailable:");
+    if (total == nullptr || available == nullptr) return false;
+    total_kb = strtoull(total + 9, nullptr, 10);
+    available_kb = strtoull(available + 13, nullptr, 10);
+    return total_kb > 0;
+  }
+
+  sockaddr_un socket_address(const std::string &path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+  }
+
+  // a message per datagram; false if the peer is gone (a full socket buffer just drops the message)
+  bool send_message(int fd, const std::string &msg) {
+    return send(fd, msg.data(), msg.size(), MSG_DONTWAIT | MSG_NOSIGNAL) != -1 || errno == EAGAIN;
+  }
+
+  // the free committed heap a GC can hand back; lacking heap counters, a tenth of the RSS
+  uint64_t expected_savings_kb(const arbiter_usage &usage) {
+    if (usage.heap_committed_kb > usage.heap_used_kb) return usage.heap_committed_kb - usage.heap_used_kb;
+    return usage.heap_committed_kb == 0 ? usage.rss_kb / 10 : 0;
+  }
+
+}
+
+void memory_arbiter::attach(event_loop &event_loop, pid_t child_pid) {
+  if (!cfg.enabled) return;
+  sampler.attach(child_pid);
+  attach_client.reset(child_pid);
+  attach(event_loop, child_pid, [this](arbiter_usage &usage) { return sample_jvm(usage); },
+         [this](uint64_t kb) { shed_jvm(kb); });
+}
+
+void memory_arbiter::attach(event_loop &event_loop, pid_t child_pid, usage_source_t source, shed_handler_t handler) {
+  if (!cfg.enabled) return;
+  loop = &event_loop;
+  pid = child_pid;
+  usage_source = std::move(source);
+  shed_handler = std::move(handler);
+  if (cfg.name.empty()) {
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    name = format2str("%s:%d", host, pid);
+  } else {
+    name = cfg.name;
+  }
+  report_timer = loop->add_timer(cfg.report_interval, [this]() { report(); });
+}
+
+void memory_arbiter::detach() {
+  if (loop != nullptr) {
+    if (report_timer != -1) loop->cancel_timer(report_timer);
+    if (listener_timer != -1) loop->cancel_timer(listener_timer);
+    leave();
+    loop = nullptr;
+  }
+  report_timer = listener_timer = -1;
+  shed_queue.clear();
+  if (lock_fd != -1) {
+    close(lock_fd);
+    lock_fd = -1;
+  }
+  attach_client.reset(0);
+}
+
+void memory_arbiter::report() {
+  arbiter_usage usage;
+  if (!usage_source(usage)) return;
+  if (role == ROLE::NONE && !join()) return;
+  if (role == ROLE::MEMBER) {
+    const auto msg = format2str("report %d %" PRIu64 " %" PRIu64 " %" PRIu64 " %s", cfg.priority, usage.rss_kb,
+                                usage.heap_used_kb, usage.heap_committed_kb, name.c_str());
+    if (!send_message(sock_fd, msg)) {
+      log(LL::INFO, "lost the node's memory arbiter coordinator: %s", strerror(errno));
+      leave(); // the next report holds an election
+    }
+    return;
+  }
+  members.front().usage = usage;
+  members.front().report_ns = monotonic_ns();
+  arbitrate();
+}
+
+bool memory_arbiter::join() {
+  const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == -1) return false;
+  const auto addr = socket_address(cfg.socket);
+  if (connect(fd, (const struct sockaddr*) &addr, sizeof(addr)) == 0) {
+    role = ROLE::MEMBER;
+    sock_fd = fd;
+    loop->add_fd(sock_fd, EPOLLIN, [this](uint32_t events) { on_coordinator_event(events); });
+    log(LL::INFO, "joined the node's memory arbitration at \"%s\" as \"%s\" (priority %d)", cfg.socket.c_str(),
+        name.c_str(), cfg.priority);
+    return true;
+  }
+  close(fd);
+  return lead();
+}
+
+bool memory_arbiter::lead() {
+  // only a would-be coordinator needs the lock file; flock() takes no write access, so any user can lock it
+  if (lock_fd == -1) {
+    const auto slash = cfg.socket.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+      mkdir(cfg.socket.substr(0, slash).c_str(), 0755); // (the directory usually exists - bind-mounted)
+    }
+    const auto lock_path = cfg.socket + ".lock";
+    lock_fd = open(lock_path.c_str(), O_RDONLY | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0666);
+    if (lock_fd == -1) {
+      const int64_t now_ns = monotonic_ns();
+      if (now_ns - last_election_warn_ns >= election_warn_interval_ns) {
+        last_election_warn_ns = now_ns;
+        log(LL::WARN, "could not open memory arbiter lock file \"%s\": %s", lock_path.c_str(), strerror(errno));
+      }
+      return false;
+    }
+    fchmod(lock_fd, 0644); // whatever the umask (only its creator may): readable is all other users need
+  }
+  // the coordinator holds the lock for as long as it lives, so a socket file found unlocked is a stale one
+  if (flock(lock_fd, LOCK_EX | LOCK_NB) != 0) return false;
+  const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  const auto addr = socket_address(cfg.socket);
+  unlink(cfg.socket.c_str());
+  if (fd == -1 || bind(fd, (const struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+    const int64_t now_ns = monotonic_ns();
+    if (now_ns - last_election_warn_ns >= election_warn_interval_ns) {
+      last_election_warn_ns = now_ns;
+      log(LL::WARN, "could not listen on memory arbiter socket \"%s\": %s", cfg.socket.c_str(), strerror(errno));
+    }
+    if (fd != -1) close(fd);
+    flock(lock_fd, LOCK_UN);
+    return false;
+  }
+  chmod(cfg.socket.c_str(), 0666); // watchdogs of other containers may run as other users
+  role = ROLE::COORDINATOR;
+  sock_fd = fd;
+  members.clear();
+  members.push_back(member{-1, name, cfg.priority, {}, 0, 0, 0, 0});
+  loop->add_fd(sock_fd, EPOLLIN, [this](uint32_t) {
+    int member_fd;
+    while ((member_fd = accept4(sock_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+      members.push_back(member{member_fd, std::string(), 0, {}, 0, 0, 0, 0});
+      loop->add_fd(member_fd, EPOLLIN, [this, member_fd](uint32_t events) { on_member_event(member_fd, events); });
+    }
+  });
+  log(LL::INFO, "coordinating the node's memory arbitration at \"%s\" as \"%s\" (priority %d)", cfg.socket.c_str(),
+      name.c_str(), cfg.priority);
+  return true;
+}
+
+void memory_arbiter::leave() {
+  if (sock_fd == -1) return;
+  if (role == ROLE::COORDINATOR) {
+    for (const auto &m : members) {
+      if (m.fd == -1) continue;
+      loop->remove_fd(m.fd);
+      close(m.fd);
+    }
+    members.clear();
+    unlink(cfg.socket.c_str());
+    flock(lock_fd, LOCK_UN);
+  }
+  loop->remove_fd(sock_fd);
+  close(sock_fd);
+  sock_fd = -1;
+  role = ROLE::NONE;
+}
+
+void memory_arbiter::on_coordinator_event(uint32_t events) {
+  char buf[512];
+  ssize_t n;
+  while ((n = recv(sock_fd, buf, sizeof(buf) - 1, MSG_DONTWAIT)) > 0) {
+    buf[n] = '\0';
+    uint64_t kb = 0;
+    if (sscanf(buf, "shed %" SCNu64, &kb) == 1) {
+      log(LL::INFO, "the node's memory arbiter asks \"%s\" to shed memory (~%" PRIu64 " MB)", name.c_str(), kb / 1024);
+      shed_handler(kb);
+    }
+  }
+  if (n == 0 || (n == -1 && errno != EAGAIN) || (events & (EPOLLHUP | EPOLLERR)) != 0) {
+    log(LL::INFO, "lost the node's memory arbiter coordinator");
+    leave(); // the next report holds an election
+  }
+}
+
+void memory_arbiter::on_member_event(int fd, uint32_t events) {
+  const auto it = std::find_if(members.begin(), members.end(), [fd](const member &m) { return m.fd == fd; });
+  if (it == members.end()) return;
+  char buf[512];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf) - 1, MSG_DONTWAIT)) > 0) {
+    buf[n] = '\0';
+    int priority = 0;
+    int name_pos = 0;
+    arbiter_usage usage;
+    if (sscanf(buf, "report %d %" SCNu64 " %" SCNu64 " %" SCNu64 " %n", &priority, &usage.rss_kb, &usage.heap_used_kb,
+               &usage.heap_committed_kb, &name_pos) < 4 || name_pos == 0) {
+      continue;
+    }
+    if (it->report_ns == 0) {
+      log(LL::INFO, "\"%s\" (priority %d) joined the node's memory arbitration", buf + name_pos, priority);
+    }
+    it->name = buf + name_pos;
+    it->priority = priority;
+    it->usage = usage;
+    it->report_ns = monotonic_ns();
+  }
+  if (n == 0 || (n == -1 && errno != EAGAIN) || (events & (EPOLLHUP | EPOLLERR)) != 0) {
+    remove_member(fd);
+  }
+}
+
+void memory_arbiter::remove_member(int fd) {
+  const auto it = std::find_if(members.begin(), members.end(), [fd](const member &m) { return m.fd == fd; });
+  if (it == members.end()) return;
+  if (it->report_ns != 0) {
+    log(LL::INFO, "\"%s\" left the node's memory arbitration", it->name.c_str());
+  }
+  loop->remove_fd(fd);
+  close(fd);
+  members.erase(it);
+}
+
+void memory_arbiter::arbitrate() {
+  const int64_t now_ns = monotonic_ns();
+  const int64_t stale_ns = (int64_t) cfg.report_interval.count() * 1000000 * stale_reports;
+  std::vector<int> stale_fds;
+  for (const auto &m : members) {
+    if (m.fd != -1 && m.report_ns != 0 && now_ns - m.report_ns > stale_ns) stale_fds.push_back(m.fd);
+  }
+  for (const int fd : stale_fds) {
+    remove_member(fd);
+  }
+
+  uint64_t limit_kb = 0, used_kb = 0;
+  if (cfg.memory_limit > 0) {
+    limit_kb = cfg.memory_limit / 1024;
+    for (const auto &m : members) {
+      used_kb += m.usage.rss_kb;
+    }
+  } else {
+    uint64_t available_kb = 0;
+    if (!read_meminfo(limit_kb, available_kb)) return;
+    used_kb = limit_kb > available_kb ? limit_kb - available_kb : 0;
+  }
+  // savings still expected of the JVMs asked to shed memory recently, less what their reports show was shed since
+  const int64_t shed_interval_ns = (int64_t) cfg.shed_interval.count() * 1000000;
+  uint64_t pending_kb = 0;
+  for (const auto &m : members) {
+    if (m.shed_ns == 0 || now_ns - m.shed_ns >= shed_interval_ns) continue;
+    const uint64_t shed_so_far_kb = m.shed_rss_kb > m.usage.rss_kb ? m.shed_rss_kb - m.usage.rss_kb : 0;
+    pending_kb += m.shed_kb - std::min(m.shed_kb, shed_so_far_kb);
+  }
+  used_kb -= std::min(used_kb, pending_kb);
+  const uint64_t high_kb = limit_kb * cfg.high_pct / 100;
+  const uint64_t low_kb = limit_kb * std::min(cfg.low_pct, cfg.high_pct) / 100;
+  if (limit_kb == 0 || used_kb < high_kb) return;
+
+  // lowest priority first, and within a priority the JVMs expected to give back the most first
+  std::vector<member*> candidates;
+  for (auto &m : members) {
+    if (m.report_ns == 0 || (m.shed_ns != 0 && now_ns - m.shed_ns < shed_interval_ns)) {
+      continue;
+    }
+    candidates.push_back(&m);
+  }
+  if (candidates.empty()) {
+    log(LL::DEBUG, "node memory at %" PRIu64 "%% of the limit - every JVM was asked to shed memory recently",
+        used_kb * 100 / limit_kb);
+    return;
+  }
+  std::stable_sort(candidates.begin(), candidates.end(), [](const member *a, const member *b) {
+    return a->priority != b->priority ? a->priority < b->priority :
+           expected_savings_kb(a->usage) > expected_savings_kb(b->usage);
+  });
+  const uint64_t need_kb = used_kb - low_kb;
+  uint64_t expected_kb = 0;
+  std::string asked;
+  for (auto *m : candidates) {
+    const uint64_t savings_kb = std::min(need_kb - std::min(need_kb, expected_kb), expected_savings_kb(m->usage));
+    ask_to_shed(*m, savings_kb, now_ns);
+    asked += format2str("%s\"%s\"", asked.empty() ? "" : ", ", m->name.c_str());
+    expected_kb += savings_kb;
+    if (expected_kb >= need_kb) break;
+  }
+  log(LL::WARN, "node memory at %" PRIu64 "%% of the limit (%" PRIu64 " of %" PRIu64 " MB) - asked %s to shed memory "
+      "(~%" PRIu64 " of the %" PRIu64 " MB needed)", used_kb * 100 / limit_kb, used_kb / 1024, limit_kb / 1024,
+      asked.c_str(), std::min(expected_kb, need_kb) / 1024, need_kb / 1024);
+}
+
+void memory_arbiter::ask_to_shed(member &m, uint64_t kb, int64_t now_ns) {
+  m.shed_ns = now_ns;
+  m.shed_kb = kb;
+  m.shed_rss_kb = m.usage.rss_kb;
+  if (m.fd == -1) {
+    shed_handler(kb);
+  } else {
+    send_message(m.fd, format2str("shed %" PRIu64, kb)); // (a member gone away is removed on its hang up)
+  }
+}
+
+bool memory_arbiter::sample_jvm(arbiter_usage &usage) {
+  // reports start once the JVM's heap counters are up, i.e. well past its startup
+  if (!sampler.sample(values) || !sampler.jvm_counters().is_attached()) return false;
+  auto &hsperf = sampler.jvm_counters();
+  usage.rss_kb = (uint64_t) at(values, METRIC::RSS_KB);
+  usage.heap_used_kb = (uint64_t) at(values, METRIC::HEAP_USED_KB);
+  usage.heap_committed_kb = (uint64_t) ((std::max<int64_t>(0, hsperf.get("sun.gc.generation.0.capacity")) +
+                                         std::max<int64_t>(0, hsperf.get("sun.gc.generation.1.capacity"))) / 1024);
+  return true;
+}
+
+void memory_arbiter::shed_jvm(uint64_t) {
+  if (attach_client.is_busy() || !shed_queue.empty()) return; // still shedding as asked before
+  if (!attach_client.is_listening()) {
+    if (listener_timer == -1 && attach_client.request_listener()) {
+      // the listener comes up within moments of the request
+      listener_timer = loop->add_timer(milliseconds(2000), [this]() {
+        listener_timer = -1;
+        if (attach_client.is_listening()) shed_jvm(0);
+      }, false);
+    }
+    return;
+  }
+  size_t pos = 0;
+  while (pos < cfg.shed_commands.size()) {
+    auto end = cfg.shed_commands.find(',', pos);
+    if (end == std::string::npos) end = cfg.shed_commands.size();
+    const auto first = cfg.shed_commands.find_first_not_of(' ', pos);
+    const auto last = cfg.shed_commands.find_last_not_of(' ', end - 1);
+    pos = end + 1;
+    if (first >= end || last == std::string::npos || last < first) continue;
+    shed_queue.push_back(cfg.shed_commands.substr(first, last - first + 1));
+  }
+  shed_next();
+}
+
+// sends the JVM the next of the shed_commands once the one before is done
+void memory_arbiter::shed_next() {
+  if (shed_queue.empty()) return;
+  const auto command = std::move(shed_queue.front());
+  shed_queue.erase(shed_queue.begin());
+  const bool is_started = attach_client.jcmd(*loop, command, jcmd_timeout_ms,
+                                             [this, command](bool is_ok, const std::string &) {
+    if (is_ok) {
+      log(LL::INFO, "ran \"%s\" on child process (pid:%d) to shed memory", command.c_str(), pid);
+    } else {
+      log(LL::WARN, "failed running \"%s\" on child process (pid:%d) to shed memory", command.c_str(), pid);
+    }
+    shed_next();
+  });
+  if (!is_started) {
+    log(LL::WARN, "failed running \"%s\" on child process (pid:%d) to shed memory", command.c_str(), pid);
+    shed_next();
+  }
+}
+
+#if defined(TEST_ARBITER)
+
+#include <csignal>
+#include <set>
+#include <sys/wait.h>
+
+static int failures = 0;
+
+static void expect(bool condition, const char *what) {
+  printf("%s: %s\n", condition ? "PASS" : "FAIL", what);
+  if (!condition) failures++;
+}
+
+// a stand-in participant: a watchdog whose "JVM" reports a fixed RSS and halves it when asked to shed memory
+static void stand_in(const arbiter_settings &cfg, int priority, int report_fd) {
+  arbiter_settings settings = cfg;
+  settings.priority = priority;
+  settings.name = format2str("stand-in-%d", priority);
+  arbiter_usage usage{400 * 1024, 100 * 1024, 300 * 1024};
+  event_loop loop;
+  memory_arbiter arbiter(settings);
+  arbiter.attach(loop, getpid(), [&usage](arbiter_usage &u) { u = usage; return true; },
+                 [&usage, priority, report_fd](uint64_t) {
+                   usage.rss_kb /= 2;
+                   dprintf(report_fd, "S%d\n", priority);
+                 });
+  bool was_coordinator = false;
+  loop.add_timer(milliseconds(50), [&]() {
+    if (arbiter.is_coordinator() && !was_coordinator) dprintf(report_fd, "C%d\n", priority);
+    was_coordinator = arbiter.is_coordinator();
+  });
+  loop.run();
+}
+
+// the lines the stand-ins wrote within the time allowed
+static std::vector<std::string> read_lines(int fd, int timeout_ms) {
+  std::vector<std::string> lines;
+  std::string pending;
+  const int64_t deadline_ns = monotonic_ns() + (int64_t) timeout_ms * 1000000;
+  while (monotonic_ns() < deadline_ns) {
+    char buf[256];
+    const ssize_t n = read(fd, buf, sizeof(buf));
+    if (n <= 0) {
+      usleep(10000);
+      continue;
+    }
+    pending.append(buf, (size_t) n);
+    size_t eol;
+    while ((eol = pending.find('\n')) != std::string::npos) {
+      lines.push_back(pending.substr(0, eol));
+      pending.erase(0, eol + 1);
+    }
+  }
+  return lines;
+}
+
+int main(int argc, char **argv) {
+  const auto dir = format2str("/tmp/test-arbiter-%d", getpid());
+  arbiter_settings cfg;
+  cfg.enabled = true;
+  cfg.socket = dir + "/arbiter.sock";
+  cfg.report_interval = milliseconds(100);
+  cfg.memory_limit = 1000ULL * 1024 * 1024;   // three stand-ins of 400 MB each exceed the 900 MB high mark
+  cfg.shed_interval = milliseconds(1000);
+
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) == -1) {
+    perror("pipe2");
+    return EXIT_FAILURE;
+  }
+  pid_t pids[3];
+  for (int priority = 0; priority < 3; priority++) {
+    pids[priority] = fork();
+    if (pids[priority] == 0) {
+      close(fds[0]);
+      stand_in(cfg, priority, fds[1]);
+      _exit(EXIT_SUCCESS);
+    }
+  }
+  close(fds[1]);
+
+  auto lines = read_lines(fds[0], 1500);
+  std::set<int> shed;
+  int coordinator = -1;
+  for (const auto &line : lines) {
+    printf("  %s\n", line.c_str());
+    if (line[0] == 'S') shed.insert(atoi(line.c_str() + 1));
+    if (line[0] == 'C') coordinator = atoi(line.c_str() + 1);
+  }
+  expect(coordinator != -1 && std::count_if(lines.begin(), lines.end(), [](auto &l) { return l[0] == 'C'; }) == 1,
+         "one stand-in is elected coordinator");
+  // each expects to free 200 MB and 400 MB is needed to get down to 800 MB
+  expect(shed == std::set<int>{0, 1}, "the two lowest priorities are asked to shed memory, and no more");
+
+  // the coordinator dies without cleaning up (its socket file is left behind)
+  if (coordinator != -1) {
+    kill(pids[coordinator], SIGKILL);
+    waitpid(pids[coordinator], nullptr, 0);
+    lines = read_lines(fds[0], 1000);
+    int successor = -1;
+    for (const auto &line : lines) {
+      printf("  %s\n", line.c_str());
+      if (line[0] == 'C') successor = atoi(line.c_str() + 1);
+    }
+    expect(successor != -1 && successor != coordinator, "a surviving stand-in takes over as coordinator");
+  }
+
+  for (int priority = 0; priority < 3; priority++) {
+    if (priority == coordinator) continue;
+    kill(pids[priority], SIGKILL);
+    waitpid(pids[priority], nullptr, 0);
+  }
+  close(fds[0]);
+  unlink(cfg.socket.c_str());
+  unlink((cfg.socket + ".lock").c_str());
+  rmdir(dir.c_str());
+
+  printf("%s: %d failure(s)\n", argv[0], failures);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
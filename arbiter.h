@@ -0,0 +1,122 @@
+/* arbiter.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __ARBITER_H__
+#define __ARBITER_H__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+#include "jvm-attach.h"
+#include "proc-stats.h"
+
+// memory usage of a JVM as reported to the arbiter
+struct arbiter_usage {
+  uint64_t rss_kb{0};
+  uint64_t heap_used_kb{0};
+  uint64_t heap_committed_kb{0};
+};
+
+/**
+ * Node-wide memory arbitration among co-located watchdogs, so that JVMs
+ * ballooning together under a burst shed memory in priority order instead of
+ * the kernel OOM killing one of them.
+ * <p>
+ * The watchdogs of a node share a unix socket (its directory bind-mounted
+ * into each container). The first to find no coordinator listening on it
+ * becomes the coordinator and holds a lock file for as long as it lives;
+ * the others connect as members. Should the coordinator go away, the
+ * members hold a new election at their next report.
+ * <p>
+ * Each watchdog reports its JVM's RSS, heap occupancy and priority every
+ * report_interval. The coordinator compares the total against memory_limit
+ * (or the node's memory in use against its total) and, once usage reaches
+ * high_pct, asks JVMs - lowest priority first, the ones with the most free
+ * committed heap first within a priority - to shed memory until the expected
+ * savings bring usage down to low_pct. A JVM asked to shed memory is sent
+ * the shed_commands (e.g. GC.run, which also lets the heap shrink) via the
+ * attach mechanism, and is asked again at most once per shed_interval.
+ */
+class memory_arbiter {
+public:
+  // samples the participant's memory usage; false while there is nothing to report yet
+  using usage_source_t = std::function<bool(arbiter_usage &usage)>;
+  // sheds memory as asked by the coordinator (the amount it hopes to reclaim)
+  using shed_handler_t = std::function<void(uint64_t kb)>;
+private:
+  enum class ROLE : char { NONE, MEMBER, COORDINATOR };
+  struct member {
+    int fd;                     // connection of the member (-1 for the coordinator's own JVM)
+    std::string name;
+    int priority;
+    arbiter_usage usage;
+    int64_t report_ns;
+    int64_t shed_ns;
+    uint64_t shed_kb;           // savings expected of the last request to shed memory
+    uint64_t shed_rss_kb;       // RSS as of that request
+  };
+  const arbiter_settings &cfg;
+  event_loop *loop{nullptr};
+  ROLE role{ROLE::NONE};
+  int sock_fd{-1};              // connection to the coordinator, or the listening socket of the coordinator
+  int lock_fd{-1};              // the coordinator holds an exclusive lock of <socket>.lock
+  int report_timer{-1};
+  int listener_timer{-1};       // awaits the attach listener the JVM was asked to start
+  std::string name;
+  pid_t pid{0};
+  usage_source_t usage_source;
+  shed_handler_t shed_handler;
+  std::vector<member> members;  // the coordinator's view of the node (its own JVM first)
+  int64_t last_election_warn_ns{0};
+  proc_sampler sampler;
+  metric_values values{};
+  jvm_attach_client attach_client;
+  std::vector<std::string> shed_queue; // shed_commands still to be sent the JVM, one at a time
+  void report();
+  bool join();
+  bool lead();
+  void leave();
+  void on_coordinator_event(uint32_t events);
+  void on_member_event(int fd, uint32_t events);
+  void remove_member(int fd);
+  void arbitrate();
+  void ask_to_shed(member &m, uint64_t kb, int64_t now_ns);
+  bool sample_jvm(arbiter_usage &usage);
+  void shed_jvm(uint64_t kb);
+  void shed_next();
+public:
+  explicit memory_arbiter(const arbiter_settings &cfg) : cfg{cfg} {}
+  memory_arbiter(const memory_arbiter &) = delete;
+  memory_arbiter& operator=(const memory_arbiter &) = delete;
+  ~memory_arbiter() { detach(); }
+
+  // joins the node's arbitration on behalf of the child JVM; call in the parent after fork()
+  void attach(event_loop &loop, pid_t pid);
+  // joins on behalf of a participant other than a JVM watched via procfs and hsperfdata (e.g. a stand-in)
+  void attach(event_loop &loop, pid_t pid, usage_source_t usage_source, shed_handler_t shed_handler);
+  void detach();
+
+  bool is_coordinator() const { return role == ROLE::COORDINATOR; }
+};
+
+#endif //__ARBITER_H__
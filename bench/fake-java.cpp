@@ -0,0 +1,169 @@
+/* fake-java.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+/**
+ * A scriptable stand-in for the java launcher: placed ahead of any real JDK on
+ * PATH (the default accept_ordinal=first_found picks it), it plays the JVM the
+ * watchdog supervises. Its behavior is chosen by -Dfake.* options, the rest of
+ * the command line being ignored:
+ * <p>
+ * -Dfake.mode=run          runs until SIGTERM (exit status 143) or fake.life ms
+ * -Dfake.mode=exit         exits with fake.code after fake.after ms
+ * -Dfake.mode=crash        raises signal fake.signal (default SIGSEGV) after fake.after ms
+ * -Dfake.mode=hang         blocks forever without output or CPU use (terminated by SIGTERM)
+ * -Dfake.mode=ignore-term  blocks forever, ignoring SIGTERM
+ * -Dfake.mode=leak         like run, touching fake.leak_mb more memory every second
+ * -Dfake.mode=spew         writes fake.bytes of output lines to stdout, then exits
+ * <p>
+ * As a JVM prints a thread dump on SIGQUIT and keeps running, so does this
+ * stand-in (a line of output in place of the dump), whatever its mode.
+ * <p>
+ * With -Dfake.marker=FILE, "<event> <CLOCK_MONOTONIC ns> <pid>" lines are
+ * appended to FILE as events happen (start, exit, crash, term, quit), which the
+ * benchmark harness times the watchdog's reactions against.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+static std::string s_marker;
+
+static int64_t monotonic_ns() {
+  struct timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// (also called from the SIGTERM handler, which interrupts nothing but a sleep)
+static void mark(const char *event) {
+  if (s_marker.empty()) return;
+  char line[96];
+  const int len = snprintf(line, sizeof(line), "%s %lld %d\n", event, (long long) monotonic_ns(), (int) getpid());
+  const int fd = open(s_marker.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+  if (fd == -1) return;
+  if (write(fd, line, (size_t) len) != len) {
+    // nothing more to do about it
+  }
+  close(fd);
+}
+
+static void sleep_ms(long ms) {
+  struct timespec ts{ ms / 1000, (ms % 1000) * 1000000L };
+  while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {}
+}
+
+static void on_term(int) {
+  mark("term");
+  _exit(143);
+}
+
+static void on_quit(int) {
+  static const char dump[] = "Full thread dump (fake java)\n";
+  if (write(STDOUT_FILENO, dump, sizeof(dump) - 1) == -1) {
+    // nothing more to do about it
+  }
+  mark("quit");
+}
+
+int main(int argc, char **argv) {
+  std::string mode{"run"};
+  long code = 0, after_ms = 0, life_ms = 0, leak_mb = 16, sig = SIGSEGV;
+  long long bytes = 64LL * 1024 * 1024;
+  for (int i = 1; i < argc; i++) {
+    const char * const arg = argv[i];
+    if (strncmp(arg, "-Dfake.", 7) != 0 || strchr(arg, '=') == nullptr) continue;
+    const std::string name{arg + 7, strchr(arg, '=')};
+    const char * const value = strchr(arg, '=') + 1;
+    if (name == "mode") mode = value;
+    else if (name == "code") code = strtol(value, nullptr, 10);
+    else if (name == "after") after_ms = strtol(value, nullptr, 10);
+    else if (name == "life") life_ms = strtol(value, nullptr, 10);
+    else if (name == "leak_mb") leak_mb = strtol(value, nullptr, 10);
+    else if (name == "signal") sig = strtol(value, nullptr, 10);
+    else if (name == "bytes") bytes = strtoll(value, nullptr, 10);
+    else if (name == "marker") s_marker = value;
+  }
+  mark("start");
+  signal(SIGTERM, mode == "ignore-term" ? SIG_IGN : on_term);
+  signal(SIGQUIT, on_quit);
+
+  if (mode == "exit") {
+    sleep_ms(after_ms);
+    mark("exit");
+    return (int) code;
+  }
+  if (mode == "crash") {
+    sleep_ms(after_ms);
+    const struct rlimit no_core{0, 0};
+    setrlimit(RLIMIT_CORE, &no_core);
+    mark("crash");
+    signal((int) sig, SIG_DFL);
+    raise((int) sig);
+    return EXIT_FAILURE;
+  }
+  if (mode == "spew") {
+    // lines of a typical log line length
+    std::string chunk;
+    while (chunk.size() < 64 * 1024) {
+      chunk += "2026-10-18 12:00:00.000 INFO  [main] com.example.Service - processed request id=0123456789abcdef\n";
+    }
+    long long written = 0;
+    while (written < bytes) {
+      const auto n = write(STDOUT_FILENO, chunk.data(), (size_t) std::min<long long>(chunk.size(), bytes - written));
+      if (n <= 0) {
+        if (n == -1 && errno == EINTR) continue;
+        break;
+      }
+      written += n;
+    }
+    mark("exit");
+    return EXIT_SUCCESS;
+  }
+  if (mode == "leak") {
+    std::vector<char*> blocks;
+    for (long elapsed_ms = 0; life_ms == 0 || elapsed_ms < life_ms; elapsed_ms += 1000) {
+      char * const block = static_cast<char*>(malloc((size_t) leak_mb * 1024 * 1024));
+      if (block != nullptr) {
+        memset(block, 1, (size_t) leak_mb * 1024 * 1024);
+        blocks.push_back(block);
+      }
+      sleep_ms(1000);
+    }
+    mark("exit");
+    return EXIT_SUCCESS;
+  }
+  if (mode == "run" && life_ms > 0) {
+    sleep_ms(life_ms);
+    mark("exit");
+    return EXIT_SUCCESS;
+  }
+  // run, hang and ignore-term
+  for (;;) {
+    pause();
+  }
+}
@@ -0,0 +1,325 @@
+/* micro-bench.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+/**
+ * Microbenchmarks of the watchdog's hot helpers: logger::vlog (log lines go
+ * to /dev/null, unbuffered as the watchdog has them), vformat2str and the
+ * sink formatting functions (format_to, format_append, format_tls), ini_parse
+ * and process_config over a large config, find_program_path over a PATH of
+ * hundreds of entries, and path_concat. Messages over 256 bytes take the
+ * second vsnprintf() pass of vlog and vformat2str.
+ * <p>
+ * Each benchmark grows its iteration count until a run takes --min-time ms,
+ * then repeats that run --repetitions times, printing one JSON line of the
+ * min, median and max nanoseconds per operation.
+ * <p>
+ * usage: micro-bench [--filter SUBSTRING] [--min-time MS] [--repetitions N]
+ */
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "format2str.h"
+#include "path-concat.h"
+#include "cfgparse.h"
+#include "program-path.h"
+#include "log.h"
+
+using namespace logger;
+
+namespace {
+
+  struct bench_options {
+    std::string filter;
+    long min_time_ms = 200;
+    int repetitions = 5;
+  };
+
+  bench_options opts;
+  FILE *results = stdout;       // (stdout and stderr themselves are /dev/null for the logger)
+  std::string work_dir;
+  volatile size_t sink;         // keeps results of benchmarked calls from being optimized away
+
+  int64_t monotonic_ns() {
+    struct timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+
+  // a benchmark body performs the given count of operations
+  using bench_body_t = std::function<void(size_t iterations)>;
+
+  void run(const std::string &name, const bench_body_t &body) {
+    if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos) return;
+    size_t iterations = 1;
+    for (;;) {
+      const int64_t start_ns = monotonic_ns();
+      body(iterations);
+      const int64_t elapsed_ns = monotonic_ns() - start_ns;
+      if (elapsed_ns >= opts.min_time_ms * 1000000 || iterations >= ((size_t) 1 << 40)) break;
+      // aim past the minimum time, growing at most tenfold per try
+      const double scale = elapsed_ns > 0 ? 1.4 * (double) opts.min_time_ms * 1e6 / (double) elapsed_ns : 10.0;
+      iterations = std::max(iterations + 1, (size_t) ((double) iterations * std::min(scale, 10.0)));
+    }
+    std::vector<double> samples;
+    for (int i = 0; i < opts.repetitions; i++) {
+      const int64_t start_ns = monotonic_ns();
+      body(iterations);
+      samples.push_back((double) (monotonic_ns() - start_ns) / (double) iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    fprintf(results, "{\"bench\":\"%s\",\"unit\":\"ns/op\",\"iterations\":%zu,\"min\":%.1f,\"median\":%.1f,\"max\":%.1f}\n",
+            name.c_str(), iterations, samples.front(), samples[samples.size() / 2], samples.back());
+    fflush(results);
+  }
+
+  // a message of about len bytes for the %s of a format string
+  std::string message(size_t len) {
+    std::string msg;
+    while (msg.size() < len) {
+      msg += "child process exited with status 137 after 3 restarts; ";
+    }
+    msg.resize(len);
+    return msg;
+  }
+
+  std::string call_format2str(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    auto str = vformat2str(fmt, ap);
+    va_end(ap);
+    return str;
+  }
+
+  void bench_format2str() {
+    for (const size_t len : { 32, 200, 300, 1024, 4096 }) {
+      const auto msg = message(len);
+      run("vformat2str/msg_" + std::to_string(len), [&msg](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+          sink = sink + call_format2str("pid %d: %s (%zu)", 4242, msg.c_str(), i).size();
+        }
+      });
+      run("format_append/msg_" + std::to_string(len), [&msg](size_t iterations) {
+        std::string out;
+        for (size_t i = 0; i < iterations; i++) {
+          out.clear();
+          sink = sink + format_append(out, "pid %d: %s (%zu)", 4242, msg.c_str(), i).size();
+        }
+      });
+      run("format_tls/msg_" + std::to_string(len), [&msg](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+          sink = sink + format_tls("pid %d: %s (%zu)", 4242, msg.c_str(), i).size();
+        }
+      });
+    }
+    run("format_to/proc_path", [](size_t iterations) {
+      char path[48];
+      for (size_t i = 0; i < iterations; i++) {
+        sink = sink + format_to(path, "/proc/%d/smaps_rollup", (int) i).size();
+      }
+    });
+    run("vformat2str/proc_path", [](size_t iterations) {
+      for (size_t i = 0; i < iterations; i++) {
+        sink = sink + format2str("/proc/%d/smaps_rollup", (int) i).size();
+      }
+    });
+  }
+
+  void bench_vlog() {
+    for (const size_t len : { 32, 200, 300, 1024, 4096 }) {
+      const auto msg = message(len);
+      run("vlog/msg_" + std::to_string(len), [&msg](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+          log(LL::INFO, "pid %d: %s (%zu)", 4242, msg.c_str(), i);
+        }
+      });
+    }
+    run("vlog/below_level", [](size_t iterations) {
+      for (size_t i = 0; i < iterations; i++) {
+        log(LL::TRACE, "pid %d: %s (%zu)", 4242, "filtered out", i);
+      }
+    });
+    // contention: the iterations (log lines) are split among the threads, so ns/op is per line of wall time
+    const auto msg = message(120);
+    for (const unsigned threads : { 2u, 4u, 8u, 16u }) {
+      run("vlog/threads_" + std::to_string(threads), [&msg, threads](size_t iterations) {
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+          const size_t count = iterations / threads + (t < iterations % threads ? 1 : 0);
+          workers.emplace_back([&msg, count, t]() {
+            for (size_t i = 0; i < count; i++) {
+              log(LL::INFO, "thread %u: %s (%zu)", t, msg.c_str(), i);
+            }
+          });
+        }
+        for (auto &worker : workers) {
+          worker.join();
+        }
+      });
+    }
+  }
+
+  void bench_path_concat() {
+    run("path_concat/plain", [](size_t iterations) {
+      for (size_t i = 0; i < iterations; i++) {
+        sink = sink + path_concat("/home/dremio/.config/java-watchdog", "config.ini").size();
+      }
+    });
+    run("path_concat/trailing_separator", [](size_t iterations) {
+      for (size_t i = 0; i < iterations; i++) {
+        sink = sink + path_concat("/home/dremio/.config/java-watchdog/", "config.ini").size();
+      }
+    });
+  }
+
+  // writes a config of the given count of sections of 20 settings each; returns its path
+  std::string write_config(const char *name, int sections, size_t value_len) {
+    const auto path = path_concat(work_dir, name);
+    FILE * const file = fopen(path.c_str(), "we");
+    if (file == nullptr) return path;
+    const auto value = message(value_len);
+    fputs("; generated by micro-bench\n[settings]\nlogging_level=info\naccept_ordinal=first_found\n", file);
+    for (int s = 0; s < sections; s++) {
+      fprintf(file, "\n[process.service_%d]\n", s);
+      for (int k = 0; k < 20; k++) {
+        fprintf(file, "setting_%d = %s\n", k, value.c_str());
+      }
+    }
+    fclose(file);
+    return path;
+  }
+
+  void bench_config() {
+    const cfg_parse_handler_t handler = [](const std::string_view section, const std::string_view name,
+                                           const std::string_view value) {
+      sink = sink + section.size() + name.size() + value.size();
+      return 1;
+    };
+    const err_code_handler_t err_handler = [](int, const std::string_view, int) {};
+    for (const int sections : { 10, 250 }) {
+      const auto path = write_config(("config_" + std::to_string(sections) + ".ini").c_str(), sections, 40);
+      run("ini_parse/sections_" + std::to_string(sections), [&](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+          sink = sink + (size_t) ini_parse(path, handler, err_handler);
+        }
+      });
+      run("process_config/sections_" + std::to_string(sections), [&](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+          sink = sink + (size_t) process_config(path, handler);
+        }
+      });
+    }
+    // values near the INI_MAX_LINE limit
+    const auto path = write_config("config_long_values.ini", 250, 400);
+    run("ini_parse/sections_250_long_values", [&](size_t iterations) {
+      for (size_t i = 0; i < iterations; i++) {
+        sink = sink + (size_t) ini_parse(path, handler, err_handler);
+      }
+    });
+  }
+
+  void bench_find_program_path() {
+    // directories holding java at every 50th entry, with entries that don't exist in between
+    for (const int entries : { 10, 100, 500 }) {
+      std::string path_var;
+      for (int i = 0; i < entries; i++) {
+        const auto dir = path_concat(work_dir, "path_" + std::to_string(i));
+        if (i % 2 == 0) mkdir(dir.c_str(), 0755);
+        if (i % 50 == 49 || i == entries - 1) {
+          const auto java = path_concat(dir, "java");
+          mkdir(dir.c_str(), 0755);
+          close(open(java.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0755));
+        }
+        path_var += (path_var.empty() ? "" : ":") + dir;
+      }
+      setenv("MICRO_BENCH_PATH", path_var.c_str(), 1);
+      const auto entries_str = std::to_string(entries);
+      run("find_program_path/entries_" + entries_str + "_first_found", [](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+          sink = sink + find_program_path("java", "MICRO_BENCH_PATH", AO::FIRST_FOUND).size();
+        }
+      });
+      run("find_program_path/entries_" + entries_str + "_last_found", [](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+          sink = sink + find_program_path("java", "MICRO_BENCH_PATH", AO::LAST_FOUND).size();
+        }
+      });
+    }
+  }
+
+}
+
+int main(int argc, char **argv) {
+  static const struct option long_options[] = {
+      { "filter",      required_argument, nullptr, 'f' },
+      { "min-time",    required_argument, nullptr, 't' },
+      { "repetitions", required_argument, nullptr, 'r' },
+      { nullptr, 0, nullptr, 0 },
+  };
+  int opt;
+  while ((opt = getopt_long(argc, argv, "f:t:r:", long_options, nullptr)) != -1) {
+    switch (opt) {
+      case 'f': opts.filter = optarg; break;
+      case 't': opts.min_time_ms = std::max(1L, atol(optarg)); break;
+      case 'r': opts.repetitions = std::max(1, atoi(optarg)); break;
+      default:
+        fprintf(stderr, "usage: %s [--filter SUBSTRING] [--min-time MS] [--repetitions N]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  char dir[] = "/tmp/micro-bench-XXXXXX";
+  if (mkdtemp(dir) == nullptr) {
+    perror("mkdtemp");
+    return EXIT_FAILURE;
+  }
+  work_dir = dir;
+
+  // results go to the original stdout; the logger writes to /dev/null
+  results = fdopen(dup(STDOUT_FILENO), "w");
+  const int dev_null = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (results == nullptr || dev_null == -1) {
+    perror("micro-bench");
+    return EXIT_FAILURE;
+  }
+  dup2(dev_null, STDOUT_FILENO);
+  dup2(dev_null, STDERR_FILENO);
+  set_progname("java-watchdog");
+  set_syslogging(false);
+  set_to_unbuffered();
+  set_level(LL::INFO);
+
+  bench_format2str();
+  bench_vlog();
+  bench_path_concat();
+  bench_config();
+  bench_find_program_path();
+
+  const auto rm_cmd = format2str("rm -rf '%s'", work_dir.c_str());
+  return system(rm_cmd.c_str()) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,583 @@
+/* supervision-bench.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+/**
+ * Measures the reaction times and overhead of java-watchdog supervising the
+ * fake-java stand-in JVM, printing a JSON line of results per benchmark:
+ * <p>
+ * launch              exec of the watchdog to the start of the child, plus binary size and RSS
+ * crash_detect        child crash (SIGSEGV) to watchdog exit
+ * restart             child exit to the start of its relaunch ([process.NAME] restart=always)
+ * shutdown            SIGTERM to the watchdog to watchdog exit
+ * shutdown_deadline   the same with a child ignoring SIGTERM (100 ms deadline + 50 ms thread dump wait, then SIGKILL)
+ * output_throughput   relaying captured output versus the child writing into a drained pipe
+ * overhead            CPU and RSS of a watchdog supervising an idle child
+ * density             start, footprint and stop of hundreds of concurrent watchdogs
+ * control_ping        round trip of a ping command over the control socket (also control_status)
+ * <p>
+ * Each watchdog runs in a scratch directory holding its config.ini (HOME is
+ * pointed there too, so no user config interferes), with the fake-java
+ * directory first on PATH.
+ * <p>
+ * usage: supervision-bench [--watchdog PATH] [--fake-dir DIR] [--iterations N] [--density N]
+ *                          [--seconds N] [--only NAME,...]
+ */
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+namespace {
+
+  struct bench_options {
+    std::string watchdog;
+    std::string fake_dir;
+    std::string work_dir;
+    int iterations = 20;
+    int density = 200;
+    int seconds = 3;
+    std::string only;
+  };
+
+  bench_options opts;
+  int failures = 0;
+
+  int64_t monotonic_ns() {
+    struct timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+
+  void sleep_ms(long ms) {
+    struct timespec ts{ ms / 1000, (ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {}
+  }
+
+  bool is_selected(const char *name) {
+    if (opts.only.empty()) return true;
+    const std::string list = "," + opts.only + ",";
+    return list.find(std::string(",") + name + ",") != std::string::npos;
+  }
+
+  void write_file(const std::string &path, const std::string &content) {
+    FILE * const file = fopen(path.c_str(), "we");
+    if (file == nullptr) return;
+    fputs(content.c_str(), file);
+    fclose(file);
+  }
+
+  // the config.ini common to every benchmark ahead of its own sections
+  std::string base_config() {
+    return "[settings]\nlogging_level=warn\naccept_ordinal=first_found\n[syslog]\nenabled=false\n";
+  }
+
+  /**
+   * Launches a watchdog in the scratch directory.
+   *
+   * @param args the command line handed to the watchdog (i.e., the java command line)
+   * @param out_path where the watchdog's stdout goes
+   * @return pid of the watchdog (-1 on failure)
+   */
+  pid_t launch_watchdog(const std::vector<std::string> &args, const char *out_path = "/dev/null") {
+    const pid_t pid = fork();
+    if (pid != 0) return pid;
+    if (chdir(opts.work_dir.c_str()) != 0) _exit(126);
+    setenv("HOME", opts.work_dir.c_str(), 1);
+    const char * const path = getenv("PATH");
+    setenv("PATH", (opts.fake_dir + ":" + (path != nullptr ? path : "/usr/bin:/bin")).c_str(), 1);
+    const int out = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    const int err = open((opts.work_dir + "/watchdog.log").c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (out != -1) dup2(out, STDOUT_FILENO);
+    if (err != -1) dup2(err, STDERR_FILENO);
+    std::vector<const char*> argv{ opts.watchdog.c_str() };
+    for (const auto &arg : args) {
+      argv.push_back(arg.c_str());
+    }
+    argv.push_back(nullptr);
+    execv(argv[0], (char**) argv.data());
+    _exit(127);
+  }
+
+  // the times of the events of a marker file: event name -> CLOCK_MONOTONIC ns (in order of occurrence)
+  std::multimap<std::string, int64_t> read_marker(const std::string &path) {
+    std::multimap<std::string, int64_t> events;
+    FILE * const file = fopen(path.c_str(), "re");
+    if (file == nullptr) return events;
+    char event[32];
+    long long ns = 0;
+    int pid = 0;
+    while (fscanf(file, "%31s %lld %d", event, &ns, &pid) == 3) {
+      events.emplace(event, (int64_t) ns);
+    }
+    fclose(file);
+    return events;
+  }
+
+  size_t count_events(const std::string &path, const char *event) {
+    return read_marker(path).count(event);
+  }
+
+  // waits until the marker file has count occurrences of an event (false on timeout)
+  bool await_events(const std::string &path, const char *event, size_t count, long timeout_ms) {
+    const int64_t deadline_ns = monotonic_ns() + (int64_t) timeout_ms * 1000000;
+    while (count_events(path, event) < count) {
+      if (monotonic_ns() >= deadline_ns) return false;
+      sleep_ms(1);
+    }
+    return true;
+  }
+
+  // waits for a watchdog to exit; returns the CLOCK_MONOTONIC ns of noticing it (0 on timeout)
+  int64_t await_exit(pid_t pid, long timeout_ms, int *status = nullptr) {
+    const int64_t deadline_ns = monotonic_ns() + (int64_t) timeout_ms * 1000000;
+    int wstatus = 0;
+    for (;;) {
+      const pid_t rc = waitpid(pid, &wstatus, WNOHANG);
+      const int64_t now_ns = monotonic_ns();
+      if (rc == pid) {
+        if (status != nullptr) *status = wstatus;
+        return now_ns;
+      }
+      if (rc == -1 || now_ns >= deadline_ns) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        return 0;
+      }
+      struct timespec ts{ 0, 100000L }; // (100 us polling granularity)
+      nanosleep(&ts, nullptr);
+    }
+  }
+
+  // prints the distribution of latency samples (in microseconds) as a JSON line
+  void report_latencies(const char *bench, std::vector<int64_t> samples_ns, int expected) {
+    if (samples_ns.empty()) {
+      printf("{\"bench\":\"%s\",\"error\":\"no samples\"}\n", bench);
+      failures++;
+      return;
+    }
+    std::sort(samples_ns.begin(), samples_ns.end());
+    const auto pct = [&samples_ns](double p) {
+      return (double) samples_ns[std::min(samples_ns.size() - 1, (size_t) (p * (double) samples_ns.size()))] / 1000.0;
+    };
+    double sum = 0.0;
+    for (const auto ns : samples_ns) {
+      sum += (double) ns / 1000.0;
+    }
+    printf("{\"bench\":\"%s\",\"unit\":\"us\",\"n\":%zu,\"failed\":%d,\"min\":%.1f,\"p50\":%.1f,\"p90\":%.1f,"
+           "\"p99\":%.1f,\"max\":%.1f,\"mean\":%.1f}\n", bench, samples_ns.size(), expected - (int) samples_ns.size(),
+           pct(0.0), pct(0.5), pct(0.9), pct(0.99), (double) samples_ns.back() / 1000.0, sum / (double) samples_ns.size());
+    if ((int) samples_ns.size() < expected) failures++;
+    fflush(stdout);
+  }
+
+  // utime + stime of a process in clock ticks
+  uint64_t cpu_ticks(pid_t pid) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return 0;
+    const ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    const char *p = strrchr(buf, ')');
+    if (p == nullptr) return 0;
+    unsigned long long utime = 0, stime = 0;
+    sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime);
+    return utime + stime;
+  }
+
+  // a "Name:   1234 kB" field of /proc/<pid>/status or /proc/<pid>/smaps_rollup
+  uint64_t proc_kb(pid_t pid, const char *file, const char *field) {
+    char path[64], buf[4096];
+    snprintf(path, sizeof(path), "/proc/%d/%s", pid, file);
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return 0;
+    const ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    const char * const p = strstr(buf, field);
+    return p != nullptr ? strtoull(p + strlen(field), nullptr, 10) : 0;
+  }
+
+  void bench_launch() {
+    write_file(opts.work_dir + "/config.ini", base_config());
+    std::vector<int64_t> samples;
+    uint64_t rss_kb = 0, hwm_kb = 0;
+    for (int i = 0; i < opts.iterations; i++) {
+      const auto marker = opts.work_dir + "/launch.marker";
+      unlink(marker.c_str());
+      const int64_t exec_ns = monotonic_ns();
+      const pid_t pid = launch_watchdog({ "-Dfake.mode=run", "-Dfake.marker=" + marker });
+      if (await_events(marker, "start", 1, 10000)) {
+        samples.push_back(read_marker(marker).find("start")->second - exec_ns);
+        // the watchdog's footprint while supervising (the largest seen over the launches)
+        rss_kb = std::max(rss_kb, proc_kb(pid, "status", "VmRSS:"));
+        hwm_kb = std::max(hwm_kb, proc_kb(pid, "status", "VmHWM:"));
+      }
+      kill(pid, SIGTERM);
+      await_exit(pid, 10000);
+    }
+    report_latencies("launch", samples, opts.iterations);
+    struct stat statbuf{};
+    stat(opts.watchdog.c_str(), &statbuf);
+    printf("{\"bench\":\"launch_footprint\",\"binary_bytes\":%lld,\"rss_kb\":%lu,\"hwm_kb\":%lu}\n",
+           (long long) statbuf.st_size, (unsigned long) rss_kb, (unsigned long) hwm_kb);
+    fflush(stdout);
+  }
+
+  void bench_crash_detect() {
+    write_file(opts.work_dir + "/config.ini", base_config());
+    std::vector<int64_t> samples;
+    for (int i = 0; i < opts.iterations; i++) {
+      const auto marker = opts.work_dir + "/crash.marker";
+      unlink(marker.c_str());
+      const pid_t pid = launch_watchdog({ "-Dfake.mode=crash", "-Dfake.after=20", "-Dfake.marker=" + marker });
+      const int64_t exit_ns = await_exit(pid, 10000);
+      const auto events = read_marker(marker);
+      const auto crash = events.find("crash");
+      if (exit_ns != 0 && crash != events.end()) samples.push_back(exit_ns - crash->second);
+    }
+    report_latencies("crash_detect", samples, opts.iterations);
+  }
+
+  void bench_restart() {
+    const auto marker = opts.work_dir + "/restart.marker";
+    unlink(marker.c_str());
+    write_file(opts.work_dir + "/config.ini", base_config() +
+               "[process.bench]\nargs=-Dfake.mode=exit -Dfake.marker=" + marker + "\nrestart=always\n"
+               "restart_delay=0\nmax_restarts=" + std::to_string(opts.iterations) + "\n");
+    const pid_t pid = launch_watchdog({});
+    await_exit(pid, 10000 + opts.iterations * 1000L);
+    // each relaunch starts after the prior exit
+    std::vector<int64_t> starts, exits, samples;
+    for (const auto &event : read_marker(marker)) {
+      (event.first == "start" ? starts : exits).push_back(event.second);
+    }
+    std::sort(starts.begin(), starts.end());
+    std::sort(exits.begin(), exits.end());
+    for (size_t i = 0; i + 1 < starts.size() && i < exits.size(); i++) {
+      samples.push_back(starts[i + 1] - exits[i]);
+    }
+    report_latencies("restart", samples, opts.iterations);
+  }
+
+  // with is_kill_expected, a sample only counts if the child was sent SIGKILL after its thread dump wait
+  void bench_shutdown(const char *bench, const char *mode, const std::string &config, bool is_kill_expected = false) {
+    write_file(opts.work_dir + "/config.ini", base_config() + config);
+    std::vector<int64_t> samples;
+    for (int i = 0; i < opts.iterations; i++) {
+      const auto marker = opts.work_dir + "/shutdown.marker";
+      unlink(marker.c_str());
+      const pid_t pid = launch_watchdog({ std::string("-Dfake.mode=") + mode, "-Dfake.marker=" + marker });
+      if (!await_events(marker, "start", 1, 10000)) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        continue;
+      }
+      sleep_ms(20); // (past the watchdog's setup following the fork)
+      const int64_t signal_ns = monotonic_ns();
+      kill(pid, SIGTERM);
+      const int64_t exit_ns = await_exit(pid, 10000);
+      if (exit_ns == 0) continue;
+      if (is_kill_expected) {
+        // the child survived SIGTERM and the thread dump's SIGQUIT without exiting, so SIGKILL ended it
+        const auto events = read_marker(marker);
+        if (events.count("quit") != 1 || events.count("term") != 0 || events.count("exit") != 0) {
+          fprintf(stderr, "%s: the child was not killed past its thread dump wait\n", bench);
+          continue;
+        }
+      }
+      samples.push_back(exit_ns - signal_ns);
+    }
+    report_latencies(bench, samples, opts.iterations);
+  }
+
+  // seconds to write the bytes, from the child's start to the exit of the watchdog (or of the child itself)
+  double time_output(bool is_relayed, long long bytes) {
+    const auto marker = opts.work_dir + "/output.marker";
+    unlink(marker.c_str());
+    const std::vector<std::string> args{ "-Dfake.mode=spew", "-Dfake.bytes=" + std::to_string(bytes),
+                                         "-Dfake.marker=" + marker };
+    pid_t pid, reader = -1;
+    if (is_relayed) {
+      pid = launch_watchdog(args);
+    } else {
+      // the child writes into a pipe drained by a reader, as it would without capture under a shell pipeline
+      int fds[2];
+      if (pipe(fds) != 0) return 0.0;
+      reader = fork();
+      if (reader == 0) {
+        close(fds[1]);
+        static char buf[64 * 1024];
+        while (read(fds[0], buf, sizeof(buf)) > 0) {}
+        _exit(0);
+      }
+      pid = fork();
+      if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        const auto java = opts.fake_dir + "/java";
+        std::vector<const char*> argv{ java.c_str() };
+        for (const auto &arg : args) {
+          argv.push_back(arg.c_str());
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], (char**) argv.data());
+        _exit(127);
+      }
+      close(fds[0]);
+      close(fds[1]);
+    }
+    const int64_t exit_ns = await_exit(pid, 120000);
+    if (reader > 0) waitpid(reader, nullptr, 0);
+    const auto events = read_marker(marker);
+    const auto start = events.find("start");
+    if (exit_ns == 0 || start == events.end()) return 0.0;
+    return (double) (exit_ns - start->second) / 1e9;
+  }
+
+  void bench_output_throughput() {
+    write_file(opts.work_dir + "/config.ini", base_config() + "[output]\ncapture=true\n");
+    const long long bytes = 256LL * 1024 * 1024;
+    double relayed_secs = 1e9, direct_secs = 1e9;
+    // best of a few runs of each
+    for (int i = 0; i < 3; i++) {
+      const double relayed = time_output(true, bytes);
+      const double direct = time_output(false, bytes);
+      if (relayed > 0.0) relayed_secs = std::min(relayed_secs, relayed);
+      if (direct > 0.0) direct_secs = std::min(direct_secs, direct);
+    }
+    if (relayed_secs == 1e9 || direct_secs == 1e9) {
+      printf("{\"bench\":\"output_throughput\",\"error\":\"spew run failed\"}\n");
+      failures++;
+      return;
+    }
+    const double mb = (double) bytes / (1024.0 * 1024.0);
+    printf("{\"bench\":\"output_throughput\",\"unit\":\"MB/s\",\"bytes\":%lld,\"relayed\":%.1f,\"direct\":%.1f,"
+           "\"relayed_pct_of_direct\":%.1f}\n", bytes, mb / relayed_secs, mb / direct_secs,
+           100.0 * direct_secs / relayed_secs);
+    fflush(stdout);
+  }
+
+  void bench_overhead() {
+    write_file(opts.work_dir + "/config.ini", base_config());
+    const auto marker = opts.work_dir + "/overhead.marker";
+    unlink(marker.c_str());
+    const pid_t pid = launch_watchdog({ "-Dfake.mode=run", "-Dfake.marker=" + marker });
+    if (!await_events(marker, "start", 1, 10000)) {
+      printf("{\"bench\":\"overhead\",\"error\":\"child did not start\"}\n");
+      failures++;
+      kill(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+      return;
+    }
+    const uint64_t ticks_start = cpu_ticks(pid);
+    const int64_t start_ns = monotonic_ns();
+    sleep_ms(opts.seconds * 1000L);
+    const uint64_t ticks = cpu_ticks(pid) - ticks_start;
+    const double secs = (double) (monotonic_ns() - start_ns) / 1e9;
+    const uint64_t rss_kb = proc_kb(pid, "status", "VmRSS:");
+    const uint64_t hwm_kb = proc_kb(pid, "status", "VmHWM:");
+    const uint64_t pss_kb = proc_kb(pid, "smaps_rollup", "Pss:");
+    kill(pid, SIGTERM);
+    await_exit(pid, 10000);
+    printf("{\"bench\":\"overhead\",\"seconds\":%.1f,\"cpu_pct\":%.3f,\"rss_kb\":%lu,\"hwm_kb\":%lu,\"pss_kb\":%lu}\n",
+           secs, 100.0 * (double) ticks / (double) sysconf(_SC_CLK_TCK) / secs, (unsigned long) rss_kb,
+           (unsigned long) hwm_kb, (unsigned long) pss_kb);
+    fflush(stdout);
+  }
+
+  void bench_density() {
+    write_file(opts.work_dir + "/config.ini", base_config());
+    const auto marker = opts.work_dir + "/density.marker";
+    unlink(marker.c_str());
+    std::vector<pid_t> pids;
+    const int64_t launch_ns = monotonic_ns();
+    for (int i = 0; i < opts.density; i++) {
+      const pid_t pid = launch_watchdog({ "-Dfake.mode=run", "-Dfake.marker=" + marker });
+      if (pid > 0) pids.push_back(pid);
+    }
+    const bool is_started = await_events(marker, "start", pids.size(), 60000);
+    const int64_t started_ns = monotonic_ns();
+
+    std::vector<uint64_t> ticks_start;
+    for (const pid_t pid : pids) {
+      ticks_start.push_back(cpu_ticks(pid));
+    }
+    const int64_t sample_ns = monotonic_ns();
+    sleep_ms(opts.seconds * 1000L);
+    uint64_t ticks = 0, rss_kb = 0, pss_kb = 0;
+    for (size_t i = 0; i < pids.size(); i++) {
+      ticks += cpu_ticks(pids[i]) - ticks_start[i];
+      rss_kb += proc_kb(pids[i], "status", "VmRSS:");
+      pss_kb += proc_kb(pids[i], "smaps_rollup", "Pss:");
+    }
+    const double secs = (double) (monotonic_ns() - sample_ns) / 1e9;
+
+    const int64_t stop_ns = monotonic_ns();
+    for (const pid_t pid : pids) {
+      kill(pid, SIGTERM);
+    }
+    size_t stopped = 0;
+    for (const pid_t pid : pids) {
+      if (await_exit(pid, 30000) != 0) stopped++;
+    }
+    const int64_t stopped_ns = monotonic_ns();
+    printf("{\"bench\":\"density\",\"watchdogs\":%zu,\"started\":%s,\"start_ms\":%.1f,\"stop_ms\":%.1f,"
+           "\"stopped\":%zu,\"cpu_pct_total\":%.3f,\"rss_kb_avg\":%lu,\"pss_kb_total\":%lu}\n", pids.size(),
+           is_started ? "true" : "false", (double) (started_ns - launch_ns) / 1e6, (double) (stopped_ns - stop_ns) / 1e6,
+           stopped, 100.0 * (double) ticks / (double) sysconf(_SC_CLK_TCK) / secs,
+           (unsigned long) (pids.empty() ? 0 : rss_kb / pids.size()), (unsigned long) pss_kb);
+    if (!is_started || stopped < pids.size() || (int) pids.size() < opts.density) failures++;
+    fflush(stdout);
+  }
+
+  void bench_control() {
+    const auto socket_path = opts.work_dir + "/control.sock";
+    write_file(opts.work_dir + "/config.ini", base_config() + "[control]\nenabled=true\nsocket=" + socket_path + "\n");
+    const auto marker = opts.work_dir + "/control.marker";
+    unlink(marker.c_str());
+    const pid_t pid = launch_watchdog({ "-Dfake.mode=run", "-Dfake.marker=" + marker });
+    const int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    const sockaddr_un autobind{ AF_UNIX, {} };
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    const struct timeval timeout{ 1, 0 };
+    if (!await_events(marker, "start", 1, 10000) || fd == -1 ||
+        bind(fd, reinterpret_cast<const sockaddr*>(&autobind), sizeof(sa_family_t)) == -1 ||
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == -1)
+    {
+      printf("{\"bench\":\"control\",\"error\":\"no control socket\"}\n");
+      failures++;
+    } else {
+      const int requests = opts.iterations * 50;
+      for (const char *command : { "ping", "status" }) {
+        std::vector<int64_t> samples;
+        char reply[512];
+        for (int i = 0; i < requests; i++) {
+          const int64_t send_ns = monotonic_ns();
+          if (sendto(fd, command, strlen(command), 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1 ||
+              recv(fd, reply, sizeof(reply), 0) <= 0)
+          {
+            continue;
+          }
+          samples.push_back(monotonic_ns() - send_ns);
+        }
+        report_latencies(strcmp(command, "ping") == 0 ? "control_ping" : "control_status", samples, requests);
+      }
+    }
+    if (fd != -1) close(fd);
+    kill(pid, SIGTERM);
+    await_exit(pid, 10000);
+  }
+
+  std::string program_dir(const char *argv0) {
+    char buf[4096];
+    const ssize_t n = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+    std::string path = n > 0 ? std::string(buf, (size_t) n) : std::string(argv0);
+    const auto slash = path.rfind('/');
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+  }
+
+}
+
+int main(int argc, char **argv) {
+  const auto dir = program_dir(argv[0]);
+  opts.watchdog = dir + "/java-watchdog";
+  opts.fake_dir = dir + "/fake-jdk/bin";
+  static const struct option long_options[] = {
+      { "watchdog",   required_argument, nullptr, 'w' },
+      { "fake-dir",   required_argument, nullptr, 'f' },
+      { "iterations", required_argument, nullptr, 'n' },
+      { "density",    required_argument, nullptr, 'd' },
+      { "seconds",    required_argument, nullptr, 's' },
+      { "only",       required_argument, nullptr, 'o' },
+      { nullptr, 0, nullptr, 0 },
+  };
+  int opt;
+  while ((opt = getopt_long(argc, argv, "w:f:n:d:s:o:", long_options, nullptr)) != -1) {
+    switch (opt) {
+      case 'w': opts.watchdog = optarg; break;
+      case 'f': opts.fake_dir = optarg; break;
+      case 'n': opts.iterations = std::max(1, atoi(optarg)); break;
+      case 'd': opts.density = std::max(1, atoi(optarg)); break;
+      case 's': opts.seconds = std::max(1, atoi(optarg)); break;
+      case 'o': opts.only = optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [--watchdog PATH] [--fake-dir DIR] [--iterations N] [--density N] [--seconds N] "
+                        "[--only NAME,...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if (access(opts.watchdog.c_str(), X_OK) != 0 || access((opts.fake_dir + "/java").c_str(), X_OK) != 0) {
+    fprintf(stderr, "%s: no java-watchdog at \"%s\" or fake java in \"%s\"\n", argv[0], opts.watchdog.c_str(),
+            opts.fake_dir.c_str());
+    return EXIT_FAILURE;
+  }
+  char work_dir[] = "/tmp/watchdog-bench-XXXXXX";
+  if (mkdtemp(work_dir) == nullptr) {
+    perror("mkdtemp");
+    return EXIT_FAILURE;
+  }
+  opts.work_dir = work_dir;
+
+  if (is_selected("launch")) bench_launch();
+  if (is_selected("crash_detect")) bench_crash_detect();
+  if (is_selected("restart")) bench_restart();
+  if (is_selected("shutdown")) bench_shutdown("shutdown", "run", "");
+  if (is_selected("shutdown_deadline")) {
+    bench_shutdown("shutdown_deadline", "ignore-term", "[shutdown]\ntimeout=100ms\nthread_dump_wait=50ms\n",
+                   true);
+  }
+  if (is_selected("output_throughput")) bench_output_throughput();
+  if (is_selected("overhead")) bench_overhead();
+  if (is_selected("density")) bench_density();
+  if (is_selected("control_ping")) bench_control();
+
+  // the scratch directory (its watchdog.log is kept when something failed)
+  if (failures == 0) {
+    for (const char *name : { "config.ini", "watchdog.log", "launch.marker", "crash.marker", "restart.marker",
+                              "shutdown.marker", "output.marker", "overhead.marker", "density.marker",
+                              "control.marker" }) {
+      unlink((opts.work_dir + "/" + name).c_str());
+    }
+    rmdir(opts.work_dir.c_str());
+  } else {
+    fprintf(stderr, "%s: %d benchmark(s) failed - see %s/watchdog.log\n", argv[0], failures, opts.work_dir.c_str());
+  }
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -19,15 +19,17 @@ limitations under the License.
 
 */
 #include <sys/stat.h>
-#include <list>
-#include <sstream>
+#include <string>
+#include <utility>
 #include "format2str.h"
+#include "trace.h"
 #include "cfgparse.h"
 
 static const char config_file_parse_err_fmt[] = "config file parsing error %d in %s() at line %d\n";
 static const char config_file_load_err_fmt[]  = "can't load config file \"%s\"\n";
 
 bool process_config(const std::string_view cfg_full_filepath, const cfg_parse_handler_t &handler) {
+  trace::span span{"process_config"};
   // check to see if specified config file exist
   struct stat statbuf{};
   if (stat(cfg_full_filepath.data(), &statbuf) == -1 ||
@@ -36,24 +38,21 @@ bool process_config(const std::string_view cfg_full_filepath, const cfg_parse_ha
     return false;
   }
 
-  std::list<std::string> err_list;
+  // (a plain string rather than a stream, so that no iostream or locale machinery gets linked in)
+  std::string err_msgs;
 
-  auto const err_code_notify = [&err_list](int ec, const std::string_view op, int ln) {
-    auto errmsg( format2str(config_file_parse_err_fmt, ec, op.data(), ln) );
-    err_list.emplace_back(std::move(errmsg));
+  auto const err_code_notify = [&err_msgs](int ec, const std::string_view op, int ln) {
+    err_msgs += format2str(config_file_parse_err_fmt, ec, op.data(), ln);
   };
 
-  if (ini_parse(cfg_full_filepath, handler, err_code_notify) != 0) {
-    auto errmsg( format2str(config_file_load_err_fmt, cfg_full_filepath.data()) );
-    err_list.emplace_front(std::move(errmsg));
-
-    std::stringstream ss;
-    for(std::list<std::string>::iterator list_iter = err_list.begin(); list_iter != err_list.end(); list_iter++)
-    {
-      ss << *list_iter;
-    }
-    err_list.clear();
-    throw process_cfg_exception(ss.str());
+  int rc;
+  {
+    trace::span ini_span{"ini_parse"};
+    rc = ini_parse(cfg_full_filepath, handler, err_code_notify);
+  }
+  if (rc != 0) {
+    err_msgs.insert(0, format2str(config_file_load_err_fmt, cfg_full_filepath.data()));
+    throw process_cfg_exception(std::move(err_msgs));
   }
 
   return true;
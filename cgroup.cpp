@@ -0,0 +1,117 @@
+/* cgroup.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#include "path-concat.h"
+#include "cgroup.h"
+
+namespace cgroup {
+
+  static const char * const cgroup_root = "/sys/fs/cgroup";
+
+  std::string read_file(const std::string_view path) {
+    std::string content;
+    const int fd = open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return content;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+      content.append(buf, (size_t) n);
+    }
+    close(fd);
+    return content;
+  }
+
+  // looks up the path of the watchdog's cgroup as listed in /proc/self/cgroup
+  // for either the unified hierarchy (empty controller) or a v1 controller
+  static std::string self_cgroup_path(const std::string_view controller) {
+    const auto content = read_file("/proc/self/cgroup");
+    size_t pos = 0;
+    while (pos < content.size()) {
+      auto eol = content.find('\n', pos);
+      if (eol == std::string::npos) eol = content.size();
+      const std::string_view line{content.data() + pos, eol - pos};
+      pos = eol + 1;
+      // hierarchy-ID:controller-list:cgroup-path
+      const auto first = line.find(':');
+      const auto second = first == std::string_view::npos ? first : line.find(':', first + 1);
+      if (second == std::string_view::npos) continue;
+      const auto controllers = line.substr(first + 1, second - first - 1);
+      const auto path = line.substr(second + 1);
+      if (controller.empty()) {
+        if (line.substr(0, first) == "0" && controllers.empty()) return std::string(path);
+        continue;
+      }
+      size_t cpos = 0;
+      while (cpos <= controllers.size()) {
+        auto comma = controllers.find(',', cpos);
+        if (comma == std::string_view::npos) comma = controllers.size();
+        if (controllers.substr(cpos, comma - cpos) == controller) return std::string(path);
+        cpos = comma + 1;
+      }
+    }
+    return std::string();
+  }
+
+  static bool is_dir(const std::string &path) {
+    struct stat statbuf{};
+    return stat(path.c_str(), &statbuf) == 0 && S_ISDIR(statbuf.st_mode);
+  }
+
+  const std::string& v2_dir() {
+    static const std::string dir = []() -> std::string {
+      struct statfs fsbuf{};
+      std::string root = cgroup_root;
+      if (statfs(cgroup_root, &fsbuf) != 0 || fsbuf.f_type != CGROUP2_SUPER_MAGIC) {
+        // hybrid hierarchy mounts the unified tree beneath the v1 controllers
+        root = path_concat(cgroup_root, "unified");
+        if (statfs(root.c_str(), &fsbuf) != 0 || fsbuf.f_type != CGROUP2_SUPER_MAGIC) return "";
+      }
+      const auto path = self_cgroup_path("");
+      // within a cgroup namespace the path is "/" (or the namespace root may be mounted as-is)
+      auto dir = path.size() > 1 ? root + path : root;
+      if (!is_dir(dir)) dir = root;
+      return dir;
+    }();
+    return dir;
+  }
+
+  std::string v1_dir(const std::string_view controller) {
+    const auto path = self_cgroup_path(controller);
+    if (path.empty()) return path;
+    const auto root = path_concat(cgroup_root, controller);
+    auto dir = path.size() > 1 ? root + path : root;
+    if (!is_dir(dir)) dir = is_dir(root) ? root : "";
+    return dir;
+  }
+
+  std::string v2_file(const std::string_view name) {
+    const auto &dir = v2_dir();
+    if (dir.empty()) return dir;
+    auto path = path_concat(dir, name);
+    if (access(path.c_str(), F_OK) != 0) path.clear();
+    return path;
+  }
+
+}
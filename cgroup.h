@@ -0,0 +1,42 @@
+/* cgroup.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __CGROUP_H__
+#define __CGROUP_H__
+
+#include <string>
+#include <string_view>
+
+namespace cgroup {
+
+  // directory of the watchdog's own cgroup in the unified (v2) hierarchy, or empty if there is none
+  const std::string& v2_dir();
+
+  // directory of the watchdog's own cgroup for a v1 controller (e.g. "memory"), or empty if there is none
+  std::string v1_dir(const std::string_view controller);
+
+  // full path of a cgroup v2 interface file (e.g. "memory.pressure") if it exists, otherwise empty
+  std::string v2_file(const std::string_view name);
+
+  // reads a (small) cgroup or procfs file into a string; empty if it could not be read
+  std::string read_file(const std::string_view path);
+
+}
+
+#endif //__CGROUP_H__
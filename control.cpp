@@ -0,0 +1,324 @@
+/* control.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "format2str.h"
+#include "log.h"
+#include "path-concat.h"
+#include "proc-stats.h"
+#include "control.h"
+
+using namespace logger;
+
+namespace {
+
+  constexpr size_t max_request = 256;
+
+  struct level_name {
+    const char *name;
+    LL level;
+  };
+  constexpr level_name level_names[] = {
+      { "trace", LL::TRACE }, { "debug", LL::DEBUG }, { "info", LL::INFO },
+      { "warn", LL::WARN }, { "error", LL::ERR }, { "fatal", LL::FATAL },
+  };
+
+  const char* to_string(LL level) {
+    for (const auto &entry : level_names) {
+      if (entry.level == level) return entry.name;
+    }
+    return "?";
+  }
+
+  // the default socket of a watchdog, alongside its stats file
+  std::string default_path(pid_t watchdog_pid) {
+    return path_concat(stats_settings{}.dir, format2str("java-watchdog-%d.sock", watchdog_pid));
+  }
+
+  bool to_unix_addr(const std::string &path, sockaddr_un &addr) {
+    addr = sockaddr_un{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+  }
+
+}
+
+void control_server::open() {
+  if (!cfg.enabled || sock_fd != -1) return;
+  path = cfg.socket.empty() ? default_path(getpid()) : cfg.socket;
+  sockaddr_un addr{};
+  if (!to_unix_addr(path, addr)) {
+    log(LL::WARN, "control socket path \"%s\" is too long - control socket disabled", path.c_str());
+    return;
+  }
+  sock_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  const int on = 1;
+  if (sock_fd == -1 || setsockopt(sock_fd, SOL_SOCKET, SO_PASSCRED, &on, sizeof(on)) == -1) {
+    log(LL::WARN, "could not create control socket - control socket disabled: %s", strerror(errno));
+    close();
+    return;
+  }
+  unlink(path.c_str()); // a socket left behind by a watchdog killed outright
+  // clients beyond the watchdog's own uid need write permission, their credentials are checked per request
+  const mode_t mask = umask(cfg.allow_uids.empty() && cfg.allow_gids.empty() ? 0177 : 0111);
+  const int rc = bind(sock_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+  umask(mask);
+  if (rc == -1) {
+    log(LL::WARN, "could not bind control socket \"%s\" - control socket disabled: %s", path.c_str(), strerror(errno));
+    ::close(sock_fd);
+    sock_fd = -1;
+    return;
+  }
+  log(LL::DEBUG, "serving control socket \"%s\"", path.c_str());
+}
+
+void control_server::close() {
+  detach();
+  if (sock_fd != -1) {
+    ::close(sock_fd);
+    sock_fd = -1;
+    unlink(path.c_str());
+  }
+}
+
+void control_server::attach(event_loop &event_loop, pid_t child_pid, unsigned launch_count, int64_t child_launch_ns,
+                            action_t relaunch)
+{
+  if (sock_fd == -1) return;
+  loop = &event_loop;
+  pid = child_pid;
+  restarts = launch_count;
+  launch_ns = child_launch_ns;
+  is_restarting = false;
+  on_relaunch = std::move(relaunch);
+  loop->add_fd(sock_fd, EPOLLIN, [this](uint32_t) { serve(); });
+}
+
+void control_server::detach() {
+  if (loop != nullptr) {
+    loop->remove_fd(sock_fd);
+    loop = nullptr;
+  }
+  on_relaunch = nullptr;
+}
+
+bool control_server::is_allowed(const ucred &cred) const {
+  const auto is_allowed_gid = [this](uint32_t gid) {
+    return std::find(cfg.allow_gids.begin(), cfg.allow_gids.end(), gid) != cfg.allow_gids.end();
+  };
+  if (cred.uid == 0 || cred.uid == geteuid() || is_allowed_gid(cred.gid) ||
+      std::find(cfg.allow_uids.begin(), cfg.allow_uids.end(), cred.uid) != cfg.allow_uids.end())
+  {
+    return true;
+  }
+  if (cfg.allow_gids.empty() || cred.pid <= 0) return false;
+
+  // the kernel attests only the primary gid, so the sender's supplementary groups are those of its status - as
+  // long as its pid is still the sender's, i.e. of the same real uid
+  char path[32], status[4096];
+  const int fd = ::open(format_to(path, "/proc/%d/status", cred.pid).data(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return false;
+  const ssize_t n = read(fd, status, sizeof(status) - 1);
+  ::close(fd);
+  if (n <= 0) return false;
+  status[n] = '\0';
+  const char * const uid_line = strstr(status, "\nUid:");
+  const char * const groups_line = strstr(status, "\nGroups:");
+  if (uid_line == nullptr || groups_line == nullptr || strtoul(uid_line + 5, nullptr, 10) != cred.uid) return false;
+  for (const char *p = groups_line + 8; *p != '\n' && *p != '\0';) {
+    char *end = nullptr;
+    const auto gid = (uint32_t) strtoul(p, &end, 10);
+    if (end == p) break;
+    if (is_allowed_gid(gid)) return true;
+    p = end;
+  }
+  return false;
+}
+
+void control_server::serve() {
+  // drains every queued request (each a datagram) without allocating
+  for (;;) {
+    char request[max_request + 1];
+    char reply[256];
+    union {
+      cmsghdr align;
+      char buf[CMSG_SPACE(sizeof(ucred))];
+    } control{};
+    sockaddr_un from{};
+    iovec iov{ request, max_request };
+    msghdr msg{};
+    msg.msg_name = &from;
+    msg.msg_namelen = sizeof(from);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    const ssize_t n = recvmsg(sock_fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (n == -1) {
+      if (errno == EINTR) continue;
+      return; // EAGAIN: drained
+    }
+
+    const ucred *cred = nullptr;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_CREDENTIALS) {
+        cred = reinterpret_cast<const ucred*>(CMSG_DATA(cmsg));
+      }
+    }
+    int len;
+    if (cred == nullptr || !is_allowed(*cred)) {
+      log(LL::WARN, "control request of uid %d (pid:%d) refused", cred != nullptr ? (int) cred->uid : -1,
+          cred != nullptr ? (int) cred->pid : 0);
+      len = (int) format_to(reply, "ERR permission denied").size();
+    } else if ((msg.msg_flags & MSG_TRUNC) != 0) {
+      len = (int) format_to(reply, "ERR request exceeds %zu bytes", max_request).size();
+    } else {
+      // "<command> [<arg>]", trailing whitespace (e.g. the newline of socat or nc) ignored
+      std::string_view line{request, (size_t) n};
+      while (!line.empty() && strchr(" \t\r\n", line.back()) != nullptr) line.remove_suffix(1);
+      while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) line.remove_prefix(1);
+      const auto space = std::min(line.find(' '), line.size());
+      auto arg = line.substr(space);
+      while (!arg.empty() && arg.front() == ' ') arg.remove_prefix(1);
+      len = execute(line.substr(0, space), arg, cred->uid, reply, sizeof(reply));
+    }
+    if (msg.msg_namelen > sizeof(sa_family_t)) {
+      // (an unbound client gets no reply)
+      sendto(sock_fd, reply, (size_t) len, MSG_DONTWAIT | MSG_NOSIGNAL, reinterpret_cast<const sockaddr*>(&from),
+             msg.msg_namelen);
+    }
+  }
+}
+
+int control_server::execute(std::string_view command, std::string_view arg, uint32_t uid, char *reply,
+                            size_t reply_size)
+{
+  const auto ok = [&](const char *what) {
+    return (int) format_to(reply, reply_size, "OK %s", what).size();
+  };
+  const auto err = [&](const char *what) {
+    return (int) format_to(reply, reply_size, "ERR %s", what).size();
+  };
+
+  if (command == "ping") {
+    return ok("pong");
+  }
+  if (command == "status") {
+    const char * const state = pid == 0 ? "held" : is_restarting ? "restarting" : "running";
+    return (int) format_to(reply, reply_size, "OK state=%s pid=%d restarts=%u uptime_ms=%ld paused=%d level=%s",
+                           state, pid, restarts, pid != 0 ? (long) ((monotonic_ns() - launch_ns) / 1000000) : 0L,
+                           is_paused ? 1 : 0, to_string(get_level())).size();
+  }
+  if (command == "dump") {
+    if (pid == 0) return err("no JVM running");
+    log(LL::INFO, "control: thread dump of child process (pid:%d) requested by uid %u", pid, uid);
+    kill(pid, SIGQUIT);
+    return ok("thread dump requested");
+  }
+  if (command == "loglevel") {
+    for (const auto &entry : level_names) {
+      if (arg.size() == strlen(entry.name) && strncasecmp(arg.data(), entry.name, arg.size()) == 0) {
+        log(LL::INFO, "control: log level set to %s by uid %u", entry.name, uid);
+        set_level(entry.level);
+        return ok(entry.name);
+      }
+    }
+    return err("expected loglevel trace|debug|info|warn|error|fatal");
+  }
+  if (command == "restart") {
+    if (pid == 0) return err("no JVM running (resume lets the held relaunch proceed)");
+    if (is_paused) return err("restarts are paused");
+    if (is_restarting) return ok("restart already under way");
+    log(LL::WARN, "control: restart of child process (pid:%d) requested by uid %u", pid, uid);
+    is_restarting = true;
+    if (on_relaunch) on_relaunch();
+    return ok("restarting");
+  }
+  if (command == "pause") {
+    if (!is_paused) log(LL::WARN, "control: restarts paused by uid %u", uid);
+    is_paused = true;
+    return ok("paused");
+  }
+  if (command == "resume") {
+    if (is_paused) log(LL::WARN, "control: restarts resumed by uid %u", uid);
+    is_paused = false;
+    if (pid == 0 && on_relaunch) {
+      on_relaunch();
+      return ok("resumed, relaunching");
+    }
+    return ok("resumed");
+  }
+  return err("unknown command (ping, status, dump, loglevel LEVEL, restart, pause, resume)");
+}
+
+int control_client(const char *target, int argc, const char *argv[]) {
+  const std::string path = strchr(target, '/') == nullptr && strtol(target, nullptr, 10) > 0 ?
+                           default_path((pid_t) strtol(target, nullptr, 10)) : std::string(target);
+  std::string request;
+  for (int i = 0; i < argc; i++) {
+    if (i > 0) request += ' ';
+    request += argv[i];
+  }
+  sockaddr_un addr{};
+  if (request.empty() || request.size() > max_request || !to_unix_addr(path, addr)) {
+    log(LL::ERR, "usage: --control <watchdog pid | socket path> <command> [<arg>]");
+    return EXIT_FAILURE;
+  }
+  const int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  // autobinds an abstract address for the reply to be sent to
+  const sockaddr_un autobind{ AF_UNIX, {} };
+  if (fd == -1 || bind(fd, reinterpret_cast<const sockaddr*>(&autobind), sizeof(sa_family_t)) == -1) {
+    log(LL::ERR, "could not create a control client socket: %s", strerror(errno));
+    if (fd != -1) ::close(fd);
+    return EXIT_FAILURE;
+  }
+  if (sendto(fd, request.data(), request.size(), 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1) {
+    log(LL::ERR, "could not send to control socket \"%s\": %s", path.c_str(), strerror(errno));
+    ::close(fd);
+    return EXIT_FAILURE;
+  }
+  pollfd pfd{ fd, POLLIN, 0 };
+  char reply[512];
+  ssize_t n = -1;
+  if (poll(&pfd, 1, 5000) == 1) {
+    n = recv(fd, reply, sizeof(reply) - 1, 0);
+  }
+  ::close(fd);
+  if (n < 0) {
+    log(LL::ERR, "no reply from control socket \"%s\"", path.c_str());
+    return EXIT_FAILURE;
+  }
+  reply[n] = '\0';
+  printf("%s\n", reply);
+  return strncmp(reply, "OK", 2) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
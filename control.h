@@ -0,0 +1,110 @@
+/* control.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __CONTROL_H__
+#define __CONTROL_H__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+
+/**
+ * Serves operational commands on a local unix socket, for use during
+ * incidents without exec'ing tools into a (possibly starved) container:
+ * <p>
+ * ping                 replies pong (a round trip of the socket and the event loop)
+ * status               state, child pid, restarts, uptime, paused, log level
+ * dump                 sends the JVM SIGQUIT (a thread dump on its stdout)
+ * loglevel LEVEL       sets the watchdog's log level (trace, debug, info, warn, error)
+ * restart              gracefully restarts the JVM (SIGTERM, within the shutdown deadline)
+ * pause / resume       holds off relaunching the JVM / lets a held relaunch proceed
+ * <p>
+ * A request is a single datagram of a command line; the reply is a single
+ * datagram starting with "OK" or "ERR". The socket is a SOCK_DGRAM one with
+ * SO_PASSCRED, so the kernel attests the credentials of each request: only
+ * root, the watchdog's own uid and the allow_uids/allow_gids of config.ini
+ * are served. As the kernel attests just the primary gid, the supplementary
+ * groups of a sender not otherwise allowed are read from its
+ * /proc/<pid>/status. Being connectionless, a request costs one recvmsg()
+ * and one sendto() within the event loop of the supervision - no per-client
+ * descriptor, no accept(), and a client that does not read its reply cannot
+ * stall the watchdog (replies are sent MSG_DONTWAIT). Requests are parsed and
+ * replied to in stack buffers; ping and status allocate nothing, whereas the
+ * commands that act are logged, and a restart arms the shutdown deadline.
+ */
+class control_server {
+public:
+  using action_t = std::function<void()>;
+private:
+  const control_settings &cfg;
+  std::string path;
+  int sock_fd{-1};
+  event_loop *loop{nullptr};
+  pid_t pid{0};                 // the child; zero while a relaunch is held by pause
+  unsigned restarts{0};
+  int64_t launch_ns{0};
+  bool is_paused{false};
+  bool is_restarting{false};
+  action_t on_relaunch;
+  void serve();
+  bool is_allowed(const ucred &cred) const;
+  int execute(std::string_view command, std::string_view arg, uint32_t uid, char *reply, size_t reply_size);
+public:
+  explicit control_server(const control_settings &cfg) : cfg{cfg} {}
+  control_server(const control_server &) = delete;
+  control_server& operator=(const control_server &) = delete;
+  ~control_server() { close(); }
+
+  // binds the socket (once, for all launches)
+  void open();
+  void close();
+
+  /**
+   * Serves commands within an event loop.
+   *
+   * @param loop the event loop of the supervision (or of a held relaunch)
+   * @param child_pid the child, or zero while a relaunch is held by pause
+   * @param launch_count launches of the child before this one
+   * @param child_launch_ns monotonic time of the launch of the child
+   * @param relaunch action of a restart command (with a child), or of resume (while held)
+   */
+  void attach(event_loop &loop, pid_t child_pid, unsigned launch_count, int64_t child_launch_ns, action_t relaunch);
+  void detach();
+
+  // relaunching is held off
+  bool paused() const { return is_paused; }
+};
+
+/**
+ * Client mode: sends a command to a watchdog's control socket and prints the
+ * reply to stdout.
+ *
+ * @param target a watchdog pid or control socket path
+ * @param argc count of the command words
+ * @param argv the command words (e.g. "loglevel", "debug")
+ * @return zero if the reply is OK
+ */
+int control_client(const char *target, int argc, const char *argv[]);
+
+#endif //__CONTROL_H__
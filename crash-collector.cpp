@@ -0,0 +1,257 @@
+/* crash-collector.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include "format2str.h"
+#include "path-concat.h"
+#include "log.h"
+#include "pgzip.h"
+#include "proc-stats.h"
+#include "crash-collector.h"
+
+using namespace logger;
+
+static const char bundle_prefix[] = "java_crash_pid";
+
+static bool is_regular_file(const std::string &path, off_t *size = nullptr) {
+  struct stat statbuf{};
+  if (stat(path.c_str(), &statbuf) == -1 || !S_ISREG(statbuf.st_mode)) return false;
+  if (size != nullptr) *size = statbuf.st_size;
+  return true;
+}
+
+static bool is_directory(const std::string &path) {
+  struct stat statbuf{};
+  return stat(path.c_str(), &statbuf) == 0 && S_ISDIR(statbuf.st_mode);
+}
+
+// expands the %p (pid) and %% escapes the JVM honors in -XX:ErrorFile and -XX:HeapDumpPath
+static std::string expand_pid(const std::string_view pattern, pid_t pid) {
+  std::string path;
+  for (size_t i = 0; i < pattern.size(); i++) {
+    if (pattern[i] == '%' && i + 1 < pattern.size()) {
+      if (pattern[i + 1] == 'p') {
+        path += std::to_string(pid);
+        i++;
+        continue;
+      }
+      if (pattern[i + 1] == '%') {
+        path += '%';
+        i++;
+        continue;
+      }
+    }
+    path += pattern[i];
+  }
+  return path;
+}
+
+static int remove_entry(const char *path, const struct stat *, int, struct FTW *) {
+  return remove(path);
+}
+
+// removes the oldest crash bundles so that at most keep remain
+static void prune_bundles(const std::string &root, unsigned keep) {
+  std::vector<std::pair<time_t, std::string>> bundles;
+  DIR * const dir = opendir(root.c_str());
+  if (dir == nullptr) return;
+  for (const struct dirent *ent = readdir(dir); ent != nullptr; ent = readdir(dir)) {
+    if (strncmp(ent->d_name, bundle_prefix, sizeof(bundle_prefix) - 1) != 0) continue;
+    auto path = path_concat(root, ent->d_name);
+    struct stat statbuf{};
+    if (stat(path.c_str(), &statbuf) == 0 && S_ISDIR(statbuf.st_mode)) {
+      bundles.emplace_back(statbuf.st_mtime, std::move(path));
+    }
+  }
+  closedir(dir);
+  if (bundles.size() <= keep) return;
+  std::sort(bundles.begin(), bundles.end());
+  for (size_t i = 0; i < bundles.size() - keep; i++) {
+    log(LL::INFO, "removing old crash bundle \"%s\"", bundles[i].second.c_str());
+    nftw(bundles[i].second.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+  }
+}
+
+// bytes that may still be written to the bundle volume per budget and free space floor
+static uint64_t available_budget(const crash_settings &cfg, const std::string &dir, uint64_t used) {
+  uint64_t budget = UINT64_MAX;
+  if (cfg.disk_budget > 0) {
+    budget = cfg.disk_budget > used ? cfg.disk_budget - used : 0;
+  }
+  struct statvfs vfs{};
+  if (statvfs(dir.c_str(), &vfs) == 0) {
+    const uint64_t free_bytes = (uint64_t) vfs.f_bavail * vfs.f_frsize;
+    const uint64_t usable = free_bytes > cfg.min_free_space ? free_bytes - cfg.min_free_space : 0;
+    budget = std::min(budget, usable);
+  }
+  return budget;
+}
+
+// moves a file into the bundle (copying it if on another volume); returns bytes added to the bundle
+static uint64_t move_into(const std::string &src, const std::string &bundle, const crash_settings &cfg, uint64_t &used) {
+  off_t size = 0;
+  if (!is_regular_file(src, &size)) return 0;
+  const auto name = src.substr(src.rfind(kPathSeparator) == std::string::npos ? 0 : src.rfind(kPathSeparator) + 1);
+  const auto dst = path_concat(bundle, name);
+  if (rename(src.c_str(), dst.c_str()) == 0) {
+    used += (uint64_t) size;
+    return (uint64_t) size;
+  }
+  if ((uint64_t) size > available_budget(cfg, bundle, used)) {
+    log(LL::WARN, "crash bundle disk budget exceeded - not collecting \"%s\"", src.c_str());
+    return 0;
+  }
+  const int in_fd = open(src.c_str(), O_RDONLY | O_CLOEXEC);
+  const int out_fd = in_fd == -1 ? -1 : open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+  off_t offset = 0;
+  bool is_ok = out_fd != -1;
+  while (is_ok && offset < size) {
+    is_ok = sendfile(out_fd, in_fd, &offset, (size_t) (size - offset)) > 0;
+  }
+  if (in_fd != -1) close(in_fd);
+  if (out_fd != -1) close(out_fd);
+  if (!is_ok) {
+    log(LL::WARN, "failed copying \"%s\" into crash bundle: %s", src.c_str(), strerror(errno));
+    unlink(dst.c_str());
+    return 0;
+  }
+  unlink(src.c_str());
+  used += (uint64_t) size;
+  return (uint64_t) size;
+}
+
+static unsigned compression_threads(const crash_settings &cfg) {
+  if (cfg.threads > 0) return cfg.threads;
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  const int ncpus = sched_getaffinity(0, sizeof(cpus), &cpus) == 0 ? CPU_COUNT(&cpus) : 1;
+  return (unsigned) std::clamp(ncpus, 1, 4);
+}
+
+static std::string find_heap_dump(const crash_artifacts &artifacts) {
+  const auto default_name = format2str("java_pid%d.hprof", artifacts.pid);
+  if (artifacts.heap_dump_path.empty()) {
+    return path_concat(".", default_name);
+  }
+  const auto path = expand_pid(artifacts.heap_dump_path, artifacts.pid);
+  return is_directory(path) ? path_concat(path, default_name) : path;
+}
+
+std::string collect_crash_bundle(const crash_settings &cfg, const crash_artifacts &artifacts) {
+  const auto pid = artifacts.pid;
+  std::vector<std::string> small_files;
+  small_files.emplace_back(artifacts.error_file.empty()
+                           ? path_concat(artifacts.crash_dir, format2str("hs_err_pid%d.log", pid))
+                           : expand_pid(artifacts.error_file, pid));
+  // the JVM falls back to the temp directory when it can't write its crash log to the working directory
+  small_files.emplace_back(format2str("/tmp/hs_err_pid%d.log", pid));
+  small_files.emplace_back(path_concat(".", format2str("replay_pid%d.log", pid)));
+  if (!artifacts.metrics_file.empty()) {
+    small_files.emplace_back(artifacts.metrics_file);
+  }
+  const auto heap_dump = find_heap_dump(artifacts);
+
+  off_t heap_dump_size = 0;
+  const bool has_heap_dump = is_regular_file(heap_dump, &heap_dump_size);
+  const bool has_crash_log = is_regular_file(small_files[0]) || is_regular_file(small_files[1]);
+  if (!artifacts.is_signaled && !has_crash_log && !has_heap_dump) {
+    return ""; // an ordinary non-zero exit status with nothing to collect
+  }
+
+  const auto start_ns = monotonic_ns();
+  const auto root = cfg.bundle_dir.empty() ? artifacts.crash_dir : cfg.bundle_dir;
+  mkdir(root.c_str(), 0750);
+  prune_bundles(root, cfg.max_bundles - 1);
+
+  char stamp[32];
+  const time_t now = time(nullptr);
+  struct tm tm_now{};
+  strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime_r(&now, &tm_now));
+  const auto bundle = path_concat(root, format2str("%s%d_%s", bundle_prefix, pid, stamp));
+  if (mkdir(bundle.c_str(), 0750) == -1) {
+    log(LL::ERR, "could not create crash bundle directory \"%s\": %s", bundle.c_str(), strerror(errno));
+    return "";
+  }
+
+  uint64_t used = 0;
+  unsigned file_count = 0;
+  for (const auto &path : small_files) {
+    if (move_into(path, bundle, cfg, used) > 0) file_count++;
+  }
+
+  if (!artifacts.output_tail.empty() && artifacts.output_tail.size() <= available_budget(cfg, bundle, used)) {
+    const auto tail_path = path_concat(bundle, "output_tail.log");
+    FILE * const file = fopen(tail_path.c_str(), "we");
+    if (file != nullptr) {
+      fwrite(artifacts.output_tail.data(), artifacts.output_tail.size(), 1, file);
+      fclose(file);
+      used += artifacts.output_tail.size();
+      file_count++;
+    }
+  }
+
+  const uint64_t heap_dump_budget = has_heap_dump ? available_budget(cfg, bundle, used) : 0;
+  if (has_heap_dump && heap_dump_budget == 0) {
+    log(LL::WARN, "crash bundle disk budget exceeded - not collecting heap dump \"%s\"", heap_dump.c_str());
+  } else if (has_heap_dump) {
+    pgzip_options options;
+    options.threads = compression_threads(cfg);
+    options.chunk_size = cfg.chunk_size;
+    options.level = cfg.compression_level;
+    options.max_output = heap_dump_budget;
+    const auto gz_name = heap_dump.substr(heap_dump.rfind(kPathSeparator) + 1) + ".gz";
+    const auto gz_path = path_concat(bundle, gz_name);
+    const auto gz_start_ns = monotonic_ns();
+    try {
+      const auto gz_size = pgzip_file(heap_dump, gz_path, options);
+      const double secs = (double) (monotonic_ns() - gz_start_ns) / 1e9;
+      log(LL::INFO, "compressed heap dump \"%s\" %ld -> %lu bytes in %.1f s (%.0f MB/s, %u threads)",
+          heap_dump.c_str(), (long) heap_dump_size, (unsigned long) gz_size, secs,
+          secs > 0 ? (double) heap_dump_size / secs / (1024 * 1024) : 0.0, options.threads);
+      used += gz_size;
+      file_count++;
+      if (!cfg.keep_heap_dump) {
+        unlink(heap_dump.c_str());
+      }
+    } catch(const pgzip_exception &ex) {
+      log(LL::WARN, "heap dump not collected into crash bundle:\n\t%s: %s", ex.name(), ex.what());
+    }
+  }
+
+  log(LL::INFO, "crash bundle \"%s\": %u files, %lu bytes, collected in %ld ms", bundle.c_str(), file_count,
+      (unsigned long) used, (long) ((monotonic_ns() - start_ns) / 1000000));
+  return bundle;
+}
+
+std::string crash_log_dir(const std::string_view error_file) {
+  const auto slash = error_file.rfind(kPathSeparator);
+  return slash == std::string_view::npos ? "." : slash == 0 ? "/" : std::string(error_file.substr(0, slash));
+}
@@ -0,0 +1,63 @@
+/* crash-collector.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __CRASH_COLLECTOR_H__
+#define __CRASH_COLLECTOR_H__
+
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include "settings.h"
+
+// what the watchdog knows about where a crashed JVM left its artifacts
+struct crash_artifacts {
+  pid_t pid{0};
+  bool is_signaled{false};
+  std::string crash_dir;        // directory of the hs_err crash log (-XX:ErrorFile or cwd)
+  std::string error_file;       // -XX:ErrorFile value (may contain %p) or empty
+  std::string heap_dump_path;   // -XX:HeapDumpPath value (file or directory) or empty
+  std::string output_tail;      // most recent captured output of the JVM
+  std::string metrics_file;     // postmortem metrics written by the watchdog or empty
+};
+
+/**
+ * Gathers the artifacts of a crashed JVM - hs_err_pid<pid>.log, replay_pid<pid>.log,
+ * java_pid<pid>.hprof, the tail of its output and the postmortem metrics - into a
+ * single crash bundle directory. The heap dump is compressed in parallel chunks.
+ * <p>
+ * Older bundles beyond max_bundles are pruned first, and nothing is written that
+ * would exceed the disk budget or eat into the minimum free space of the volume.
+ *
+ * @param cfg the [crash] settings
+ * @param artifacts the crashed child process and its artifact locations
+ * @return path of the crash bundle directory, or empty if no bundle was created
+ */
+std::string collect_crash_bundle(const crash_settings &cfg, const crash_artifacts &artifacts);
+
+/**
+ * Determines the directory the JVM will write its hs_err_pid<pid>.log crash
+ * log to, i.e., that of any -XX:ErrorFile= option or else the current working
+ * directory (which the child process inherits from the watchdog).
+ *
+ * @param error_file value of any -XX:ErrorFile= option
+ * @return directory path of the JVM crash log
+ */
+std::string crash_log_dir(const std::string_view error_file);
+
+#endif //__CRASH_COLLECTOR_H__
@@ -0,0 +1,159 @@
+/* event-loop.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "format2str.h"
+#include "event-loop.h"
+
+static const int max_events = 16;
+
+event_loop::event_loop() {
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd == -1) {
+    throw event_loop_exception(format2str("epoll_create1() failed: %s", strerror(errno)));
+  }
+}
+
+event_loop::~event_loop() {
+  for (const auto &entry : handlers) {
+    if (entry.first != signal_fd) {
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, entry.first, nullptr);
+    }
+  }
+  for (const int tfd : timers) {
+    close(tfd);
+  }
+  if (signal_fd != -1) {
+    close(signal_fd);
+  }
+  close(epoll_fd);
+}
+
+void event_loop::add_fd(int fd, uint32_t events, fd_handler_t handler) {
+  struct epoll_event ev{};
+  ev.events = events;
+  ev.data.fd = fd;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+    throw event_loop_exception(format2str("epoll_ctl(ADD, %d) failed: %s", fd, strerror(errno)));
+  }
+  handlers[fd] = std::make_shared<fd_handler_t>(std::move(handler));
+}
+
+void event_loop::modify_fd(int fd, uint32_t events) {
+  struct epoll_event ev{};
+  ev.events = events;
+  ev.data.fd = fd;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) == -1) {
+    throw event_loop_exception(format2str("epoll_ctl(MOD, %d) failed: %s", fd, strerror(errno)));
+  }
+}
+
+void event_loop::remove_fd(int fd) {
+  if (handlers.erase(fd) > 0) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  }
+}
+
+static struct itimerspec to_itimerspec(std::chrono::milliseconds interval, bool is_periodic) {
+  struct itimerspec its{};
+  const auto ms = interval.count() > 0 ? interval.count() : 1;
+  its.it_value.tv_sec = ms / 1000;
+  its.it_value.tv_nsec = (ms % 1000) * 1000000L;
+  if (is_periodic) {
+    its.it_interval = its.it_value;
+  }
+  return its;
+}
+
+int event_loop::add_timer(std::chrono::milliseconds interval, timer_handler_t handler, bool is_periodic) {
+  const int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (tfd == -1) {
+    throw event_loop_exception(format2str("timerfd_create() failed: %s", strerror(errno)));
+  }
+  const auto its = to_itimerspec(interval, is_periodic);
+  if (timerfd_settime(tfd, 0, &its, nullptr) == -1) {
+    const int err = errno;
+    close(tfd);
+    throw event_loop_exception(format2str("timerfd_settime() failed: %s", strerror(err)));
+  }
+  add_fd(tfd, EPOLLIN, [this, tfd, is_periodic, handler = std::move(handler)](uint32_t) {
+    uint64_t expirations = 0;
+    if (read(tfd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+      if (!is_periodic) cancel_timer(tfd);
+      handler();
+    }
+  });
+  timers.insert(tfd);
+  return tfd;
+}
+
+void event_loop::rearm_timer(int timer_id, std::chrono::milliseconds interval, bool is_periodic) {
+  const auto its = to_itimerspec(interval, is_periodic);
+  timerfd_settime(timer_id, 0, &its, nullptr);
+}
+
+void event_loop::cancel_timer(int timer_id) {
+  if (timers.erase(timer_id) == 0) return;
+  remove_fd(timer_id);
+  close(timer_id);
+}
+
+void event_loop::set_signals(const sigset_t &signals, signal_handler_t handler) {
+  const int sfd = signalfd(signal_fd, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (sfd == -1) {
+    throw event_loop_exception(format2str("signalfd() failed: %s", strerror(errno)));
+  }
+  signal_handler = std::move(handler);
+  if (signal_fd == -1) {
+    signal_fd = sfd;
+    add_fd(signal_fd, EPOLLIN, [this](uint32_t) {
+      signalfd_siginfo info{};
+      while (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+        signal_handler(info);
+      }
+    });
+  }
+}
+
+void event_loop::run_once(std::chrono::milliseconds timeout) {
+  struct epoll_event events[max_events];
+  const int n = epoll_wait(epoll_fd, events, max_events, static_cast<int>(timeout.count()));
+  if (n == -1) {
+    if (errno == EINTR) return;
+    throw event_loop_exception(format2str("epoll_wait() failed: %s", strerror(errno)));
+  }
+  for (int i = 0; i < n; i++) {
+    // handlers may add or remove entries, so look each one up (and pin it) at dispatch time
+    const auto it = handlers.find(events[i].data.fd);
+    if (it == handlers.end()) continue;
+    const auto handler = it->second;
+    (*handler)(events[i].events);
+  }
+}
+
+void event_loop::run() {
+  is_running = true;
+  while (is_running) {
+    run_once(std::chrono::milliseconds(-1));
+  }
+}
@@ -0,0 +1,82 @@
+/* event-loop.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __EVENT_LOOP_H__
+#define __EVENT_LOOP_H__
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <csignal>
+#include <sys/signalfd.h>
+#include "decl-exception.h"
+
+// declare event_loop_exception
+DECL_EXCEPTION(event_loop)
+
+/**
+ * Single-threaded epoll based event loop used by the watchdog parent process
+ * to multiplex child process supervision, periodic sampling timers and any
+ * file descriptors (pipes, sockets) that need servicing.
+ * <p>
+ * Timers are individual timerfd descriptors and signals are delivered via a
+ * signalfd, so every event source is just another file descriptor to epoll.
+ */
+class event_loop {
+public:
+  using fd_handler_t     = std::function<void(uint32_t events)>;
+  using timer_handler_t  = std::function<void()>;
+  using signal_handler_t = std::function<void(const signalfd_siginfo &info)>;
+private:
+  int epoll_fd{-1};
+  int signal_fd{-1};
+  bool is_running{false};
+  std::unordered_map<int, std::shared_ptr<fd_handler_t>> handlers;
+  std::unordered_set<int> timers;
+  signal_handler_t signal_handler;
+public:
+  event_loop();
+  event_loop(const event_loop &) = delete;
+  event_loop& operator=(const event_loop &) = delete;
+  ~event_loop();
+
+  void add_fd(int fd, uint32_t events, fd_handler_t handler);
+  void modify_fd(int fd, uint32_t events);
+  void remove_fd(int fd);
+
+  // returns a timer id that can be passed to cancel_timer() (one-shot timers cancel themselves once fired)
+  int add_timer(std::chrono::milliseconds interval, timer_handler_t handler, bool is_periodic = true);
+  void rearm_timer(int timer_id, std::chrono::milliseconds interval, bool is_periodic = true);
+  void cancel_timer(int timer_id);
+
+  // the specified signals must already be blocked via sigprocmask()
+  void set_signals(const sigset_t &signals, signal_handler_t handler);
+
+  // dispatches events until stop() is called from within a handler
+  void run();
+  // dispatches events that are ready now or become ready within timeout
+  void run_once(std::chrono::milliseconds timeout);
+  void stop() { is_running = false; }
+  bool running() const { return is_running; }
+};
+
+#endif //__EVENT_LOOP_H__
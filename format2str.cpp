@@ -16,29 +16,33 @@ See the License for the specific language governing permissions and
 limitations under the License.
 
 */
+#include <algorithm>
 #include <cstdio>
 #include "format2str.h"
 
 //#undef NDEBUG // uncomment this line to enable asserts in use below
 #include <cassert>
 
-std::string vformat2str(const std::string_view fmt, va_list ap) {
-  int strbuf_size = 256;
-  int n = strbuf_size;
-  char *strbuf = (char*) alloca(strbuf_size);
+// formats into a buffer of this thread kept at the size of its longest output, so formatting is
+// a single pass once it has grown to fit (glibc's vsnprintf() is slow when output overflows)
+static std::string_view vformat_to_tls(std::string &tls_buf, const std::string_view fmt, va_list ap) {
+  if (tls_buf.size() < 256) tls_buf.resize(256);
   va_list parm_copy;
   va_copy(parm_copy, ap);
-  {
-    n = vsnprintf(strbuf, (size_t) n, fmt.data(), ap);
-    assert(n > 0);
-    if (n >= strbuf_size) {
-      strbuf = (char*) alloca(strbuf_size = ++n);
-      n = vsnprintf(strbuf, (size_t) n, fmt.data(), parm_copy);
-      assert(n > 0 && n < strbuf_size);
-    }
+  int n = vsnprintf(tls_buf.data(), tls_buf.size(), fmt.data(), ap);
+  if (n >= 0 && (size_t) n >= tls_buf.size()) {
+    tls_buf.resize((size_t) n + 1);
+    n = vsnprintf(tls_buf.data(), tls_buf.size(), fmt.data(), parm_copy);
   }
   va_end(parm_copy);
-  return std::string(strbuf);
+  assert(n >= 0 && (size_t) n < tls_buf.size());
+  return { tls_buf.data(), n > 0 ? (size_t) n : 0 };
+}
+
+std::string vformat2str(const std::string_view fmt, va_list ap) {
+  // (a buffer apart from format_tls()'s, as its views can be arguments here)
+  static thread_local std::string tls_buf;
+  return std::string(vformat_to_tls(tls_buf, fmt, ap));
 }
 
 std::string format2str(const std::string_view fmt, ...) {
@@ -48,3 +52,63 @@ std::string format2str(const std::string_view fmt, ...) {
   va_end(ap);
   return rslt;
 }
+
+std::string_view vformat_to(char *buf, size_t size, const std::string_view fmt, va_list ap) {
+  if (size == 0) return {};
+  const int n = vsnprintf(buf, size, fmt.data(), ap);
+  if (n < 0) {
+    buf[0] = '\0';
+    return {};
+  }
+  return { buf, std::min((size_t) n, size - 1) };
+}
+
+std::string_view format_to(char *buf, size_t size, const std::string_view fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  const auto rslt = vformat_to(buf, size, fmt, ap);
+  va_end(ap);
+  return rslt;
+}
+
+std::string_view vformat_append(std::string &out, const std::string_view fmt, va_list ap) {
+  const size_t start = out.size();
+  // format into whatever capacity the string has spare (resize() zeroes it, hence the upper bound)
+  const size_t spare = std::clamp(out.capacity() - start, (size_t) 128, (size_t) 16384);
+  out.resize(start + spare);
+  va_list parm_copy;
+  va_copy(parm_copy, ap);
+  int n = vsnprintf(out.data() + start, spare + 1, fmt.data(), ap);
+  if (n < 0) {
+    out.resize(start);
+  } else if ((size_t) n <= spare) {
+    out.resize(start + (size_t) n);
+  } else {
+    out.resize(start + (size_t) n);
+    n = vsnprintf(out.data() + start, (size_t) n + 1, fmt.data(), parm_copy);
+    assert(n >= 0 && start + (size_t) n == out.size());
+  }
+  va_end(parm_copy);
+  return std::string_view{out}.substr(start);
+}
+
+std::string_view format_append(std::string &out, const std::string_view fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  const auto rslt = vformat_append(out, fmt, ap);
+  va_end(ap);
+  return rslt;
+}
+
+std::string_view vformat_tls(const std::string_view fmt, va_list ap) {
+  static thread_local std::string tls_buf;
+  return vformat_to_tls(tls_buf, fmt, ap);
+}
+
+std::string_view format_tls(const std::string_view fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  const auto rslt = vformat_tls(fmt, ap);
+  va_end(ap);
+  return rslt;
+}
@@ -20,10 +20,44 @@ limitations under the License.
 #define __FORMAT2STR_H__
 
 #include <string>
+#include <string_view>
 #include <cstdarg>
+#include <cstddef>
 
 std::string vformat2str(const std::string_view fmt, va_list ap);
 
 std::string format2str(const std::string_view fmt, ...);
 
+/*
+ * Formatting into caller supplied sinks. These write in place, with no
+ * intermediate buffer copied from, and return a view of the text written.
+ */
+
+// formats into a fixed buffer, never allocating; output beyond size - 1 chars is
+// truncated (the buffer is always null terminated when size > 0)
+std::string_view vformat_to(char *buf, size_t size, const std::string_view fmt, va_list ap);
+
+std::string_view format_to(char *buf, size_t size, const std::string_view fmt, ...);
+
+template<size_t N>
+inline std::string_view format_to(char (&buf)[N], const std::string_view fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  const auto rslt = vformat_to(buf, N, fmt, ap);
+  va_end(ap);
+  return rslt;
+}
+
+// appends to out, formatting into its spare capacity (a reused string formats in a
+// single pass once its capacity fits the output); the view is of the appended text
+std::string_view vformat_append(std::string &out, const std::string_view fmt, va_list ap);
+
+std::string_view format_append(std::string &out, const std::string_view fmt, ...);
+
+// formats into a per thread buffer that keeps its capacity between calls; the
+// view is valid until the same thread's next call
+std::string_view vformat_tls(const std::string_view fmt, va_list ap);
+
+std::string_view format_tls(const std::string_view fmt, ...);
+
 #endif //__FORMAT2STR_H__
\ No newline at end of file
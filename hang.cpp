@@ -0,0 +1,267 @@
+/* hang.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "format2str.h"
+#include "log.h"
+#include "proc-stats.h"
+#include "trace.h"
+#include "hang.h"
+
+using namespace logger;
+
+namespace {
+
+  // native names (truncated to 15 chars) of HotSpot's own threads, whose CPU time is not application progress
+  const char * const jvm_thread_prefixes[] = {
+      "VM Thread", "VM Periodic Tas", "GC Thread", "G1 ", "C1 CompilerThre", "C2 CompilerThre", "Signal Dispatch",
+      "Finalizer", "Reference Handl", "Service Thread", "Common-Cleaner", "Sweeper thread", "Attach Listener",
+      "Monitor Deflati", "Notification Th", "VM JFR", "JFR ", "Z", "Shenandoah", "Concurrent ", "CodeCacheSweepe",
+  };
+
+  bool is_jvm_thread(const char *comm) {
+    for (const char *prefix : jvm_thread_prefixes) {
+      if (strncmp(comm, prefix, strlen(prefix)) == 0) {
+        // "Z" prefixes ZGC's threads (ZWorker, ZDriver, ...); an application thread may start with Z too
+        return prefix[1] != '\0' || (comm[1] >= 'A' && comm[1] <= 'Z');
+      }
+    }
+    return false;
+  }
+
+  // utime + stime (fields 14 and 15) of a /proc stat file
+  uint64_t read_cpu_ticks(int fd) {
+    char buf[512];
+    const ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    const char *p = strrchr(buf, ')');
+    if (p == nullptr) return 0;
+    p += 2;
+    uint64_t ticks = 0;
+    for (int field = 3; p != nullptr && field <= 15; field++) {
+      if (field >= 14) ticks += strtoull(p, nullptr, 10);
+      p = strchr(p, ' ');
+      if (p != nullptr) p++;
+    }
+    return ticks;
+  }
+
+}
+
+void hang_detector::attach(event_loop &event_loop, pid_t child_pid, const process_tree &child_tree) {
+  if (!cfg.enabled) return;
+  loop = &event_loop;
+  pid = child_pid;
+  tree = &child_tree;
+  is_hang = false;
+  is_beat = false;
+  checks = 0;
+  last_progress_ns = monotonic_ns();
+  thrash_start_ns = 0;
+  prev_check_ns = last_progress_ns;
+  prev_safepoints = prev_gc_count = prev_gc_ticks = -1;
+  prev_app_cpu_ticks = 0;
+  heartbeat_mtime = {};
+  hsperf.detach();
+  close_tasks();
+  task_dir = opendir(format2str("/proc/%d/task", pid).c_str());
+
+  if (!cfg.heartbeat_socket.empty()) {
+    heartbeat_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (heartbeat_fd != -1 && cfg.heartbeat_socket.size() < sizeof(addr.sun_path)) {
+      strcpy(addr.sun_path, cfg.heartbeat_socket.c_str());
+      unlink(addr.sun_path);
+      if (bind(heartbeat_fd, (const struct sockaddr *) &addr, sizeof(addr)) == 0) {
+        loop->add_fd(heartbeat_fd, EPOLLIN, [this](uint32_t) {
+          char buf[256];
+          while (recv(heartbeat_fd, buf, sizeof(buf), 0) >= 0) {
+            is_beat = true;
+          }
+        });
+      } else {
+        close(heartbeat_fd);
+        heartbeat_fd = -1;
+      }
+    }
+    if (heartbeat_fd == -1) {
+      log(LL::WARN, "could not bind heartbeat socket \"%s\": %s", cfg.heartbeat_socket.c_str(), strerror(errno));
+    }
+  }
+
+  check_timer = loop->add_timer(cfg.check_interval, [this]() { check(); });
+}
+
+void hang_detector::detach() {
+  if (loop != nullptr) {
+    if (check_timer != -1) loop->cancel_timer(check_timer);
+    if (kill_timer != -1) loop->cancel_timer(kill_timer);
+    if (heartbeat_fd != -1) loop->remove_fd(heartbeat_fd);
+    loop = nullptr;
+  }
+  check_timer = -1;
+  kill_timer = -1;
+  if (heartbeat_fd != -1) {
+    close(heartbeat_fd);
+    heartbeat_fd = -1;
+    unlink(cfg.heartbeat_socket.c_str());
+  }
+  close_tasks();
+  hsperf.detach();
+}
+
+void hang_detector::close_tasks() {
+  for (const auto &entry : tasks) {
+    if (entry.second.stat_fd != -1) close(entry.second.stat_fd);
+  }
+  tasks.clear();
+  if (task_dir != nullptr) {
+    closedir(task_dir);
+    task_dir = nullptr;
+  }
+}
+
+bool hang_detector::is_heartbeat() {
+  bool is_progress = is_beat;
+  is_beat = false;
+  struct stat statbuf{};
+  if (!cfg.heartbeat_file.empty() && stat(cfg.heartbeat_file.c_str(), &statbuf) == 0) {
+    is_progress |= statbuf.st_mtim.tv_sec != heartbeat_mtime.tv_sec || statbuf.st_mtim.tv_nsec != heartbeat_mtime.tv_nsec;
+    heartbeat_mtime = statbuf.st_mtim;
+  }
+  return is_progress;
+}
+
+// CPU time of the application's threads (threads are opened once and then re-read via pread())
+uint64_t hang_detector::app_cpu_ticks() {
+  if (task_dir == nullptr) return 0;
+  for (auto &entry : tasks) {
+    entry.second.is_seen = false;
+  }
+  rewinddir(task_dir);
+  for (const struct dirent *ent = readdir(task_dir); ent != nullptr; ent = readdir(task_dir)) {
+    if (ent->d_name[0] == '.') continue;
+    const auto tid = (pid_t) strtol(ent->d_name, nullptr, 10);
+    const auto it = tasks.find(tid);
+    if (it != tasks.end()) {
+      it->second.is_seen = true;
+      continue;
+    }
+    char comm[32] = "";
+    const int comm_fd = openat(dirfd(task_dir), format2str("%d/comm", tid).c_str(), O_RDONLY | O_CLOEXEC);
+    if (comm_fd != -1) {
+      const ssize_t n = read(comm_fd, comm, sizeof(comm) - 1);
+      comm[n > 0 ? n : 0] = '\0';
+      close(comm_fd);
+    }
+    const int stat_fd = is_jvm_thread(comm) ? -1 :
+                        openat(dirfd(task_dir), format2str("%d/stat", tid).c_str(), O_RDONLY | O_CLOEXEC);
+    tasks.emplace(tid, task{stat_fd, true});
+  }
+  uint64_t ticks = 0;
+  for (auto it = tasks.begin(); it != tasks.end();) {
+    if (!it->second.is_seen) {
+      if (it->second.stat_fd != -1) close(it->second.stat_fd);
+      it = tasks.erase(it);
+      continue;
+    }
+    if (it->second.stat_fd != -1) ticks += read_cpu_ticks(it->second.stat_fd);
+    ++it;
+  }
+  return ticks;
+}
+
+void hang_detector::check() {
+  const auto now_ns = monotonic_ns();
+  checks++;
+  // the hsperfdata file appears a while after JVM start (and never with -XX:-UsePerfData), so retry sparingly
+  if (!hsperf.is_attached() && (checks < 30 || checks % 10 == 0)) {
+    hsperf.attach(pid);
+  }
+
+  bool is_progress = false;
+  if (!cfg.heartbeat_file.empty() || heartbeat_fd != -1) {
+    is_progress = is_heartbeat();
+  } else {
+    // threads that exited take their CPU time with them, so any change counts
+    const auto cpu_ticks = app_cpu_ticks();
+    is_progress = cpu_ticks != prev_app_cpu_ticks;
+    prev_app_cpu_ticks = cpu_ticks;
+    if (hsperf.is_attached()) {
+      const auto safepoints = hsperf.get("sun.rt.safepoints");
+      const auto gc_count = hsperf.sum("sun.gc.collector.", ".invocations");
+      is_progress |= safepoints != prev_safepoints || gc_count != prev_gc_count;
+      prev_safepoints = safepoints;
+      prev_gc_count = gc_count;
+    }
+  }
+  if (is_progress) {
+    last_progress_ns = now_ns;
+  }
+
+  if (cfg.gc_thrash_pct > 0 && hsperf.is_attached()) {
+    const auto gc_ticks = hsperf.sum("sun.gc.collector.", ".time");
+    if (prev_gc_ticks >= 0 && now_ns > prev_check_ns) {
+      const double gc_pct = 100.0 * hsperf.ticks_to_ms(gc_ticks - prev_gc_ticks) / ((double) (now_ns - prev_check_ns) / 1e6);
+      if (gc_pct < cfg.gc_thrash_pct) {
+        thrash_start_ns = 0;
+      } else if (thrash_start_ns == 0) {
+        thrash_start_ns = prev_check_ns;
+      }
+    }
+    prev_gc_ticks = gc_ticks;
+  }
+  prev_check_ns = now_ns;
+
+  const int64_t timeout_ns = (int64_t) cfg.timeout.count() * 1000000;
+  if (thrash_start_ns != 0 && now_ns - thrash_start_ns >= timeout_ns) {
+    declare_hang(format2str("GC thrashing (at least %u%% of the time in GC for %ld ms)", cfg.gc_thrash_pct,
+                            (long) ((now_ns - thrash_start_ns) / 1000000)).c_str());
+  } else if (now_ns - last_progress_ns >= timeout_ns) {
+    declare_hang(format2str("no progress (%s) for %ld ms",
+                            !cfg.heartbeat_file.empty() || heartbeat_fd != -1 ? "heartbeat" :
+                            "application thread CPU time, safepoint and GC counters",
+                            (long) ((now_ns - last_progress_ns) / 1000000)).c_str());
+  }
+}
+
+void hang_detector::declare_hang(const char *reason) {
+  is_hang = true;
+  trace::instant("hang");
+  log(LL::ERR, "%s (pid:%d) is hung: %s - requesting thread dump", label.c_str(), pid, reason);
+  loop->cancel_timer(check_timer);
+  check_timer = -1;
+  kill(pid, SIGQUIT);
+  // (cancelled by detach(), as the event loop outlives the child and a relaunch gets the same tree)
+  kill_timer = loop->add_timer(cfg.thread_dump_wait, [this]() {
+    kill_timer = -1;
+    log(LL::ERR, "killing hung %s (pid:%d)", label.c_str(), pid);
+    tree->kill_all();
+  }, false);
+}
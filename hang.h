@@ -0,0 +1,103 @@
+/* hang.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __HANG_H__
+#define __HANG_H__
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <dirent.h>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+#include "hsperf.h"
+#include "proc-tree.h"
+
+/**
+ * Detects a wedged JVM - one stuck in a safepoint, deadlocked or thrashing in
+ * GC - that would otherwise never exit. Once a hang is declared, a SIGQUIT
+ * thread dump is requested and, after thread_dump_wait, the process tree of
+ * the child is killed.
+ * <p>
+ * Progress is judged each check_interval from:
+ * <ul>
+ * <li>a heartbeat file touched (or datagrams sent to a heartbeat socket) by the
+ *     application; when configured, the heartbeat alone decides</li>
+ * <li>otherwise, the hsperfdata safepoint and GC counters advancing, or the CPU
+ *     time of the application's own threads (JVM internal threads excluded)</li>
+ * </ul>
+ * A hang is no progress for timeout. Independently, GC taking gc_thrash_pct of
+ * the time for timeout is declared a hang (the JVM progresses, the application
+ * does not).
+ * <p>
+ * A check costs a pread() of each application thread's stat file plus reads of
+ * the mapped counters, so it runs every second without burden.
+ */
+class hang_detector {
+private:
+  struct task {
+    int stat_fd;        // -1 for JVM internal threads (not counted)
+    bool is_seen;
+  };
+  const hang_settings &cfg;
+  const std::string &label;           // how logging refers to the JVM
+  pid_t pid{0};
+  event_loop *loop{nullptr};
+  const process_tree *tree{nullptr};
+  hsperf_reader hsperf;
+  DIR *task_dir{nullptr};
+  std::unordered_map<pid_t, task> tasks;
+  int heartbeat_fd{-1};
+  int check_timer{-1};
+  int kill_timer{-1};                 // pending kill of the tree of a hung child
+  int checks{0};
+  bool is_beat{false};                // a heartbeat datagram arrived since the last check
+  bool is_hang{false};
+  struct timespec heartbeat_mtime{};
+  int64_t last_progress_ns{0};
+  int64_t thrash_start_ns{0};
+  int64_t prev_check_ns{0};
+  int64_t prev_safepoints{-1};
+  int64_t prev_gc_count{-1};
+  int64_t prev_gc_ticks{-1};
+  uint64_t prev_app_cpu_ticks{0};
+  void check();
+  bool is_heartbeat();
+  uint64_t app_cpu_ticks();
+  void declare_hang(const char *reason);
+  void close_tasks();
+public:
+  // (label must outlive the detector)
+  hang_detector(const hang_settings &cfg, const std::string &label) : cfg{cfg}, label{label} {}
+  hang_detector(const hang_detector &) = delete;
+  hang_detector& operator=(const hang_detector &) = delete;
+  ~hang_detector() { detach(); }
+
+  // starts watching the child for progress; call in the parent after fork()
+  void attach(event_loop &loop, pid_t pid, const process_tree &tree);
+  // stops watching (the child has terminated or is being shut down on request)
+  void detach();
+
+  // true once a hang was declared (and the child killed)
+  bool is_hung() const { return is_hang; }
+};
+
+#endif //__HANG_H__
@@ -0,0 +1,176 @@
+/* hsperf.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cstring>
+#include <fcntl.h>
+#include <glob.h>
+#include <pwd.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "format2str.h"
+#include "log.h"
+#include "hsperf.h"
+
+using namespace logger;
+
+// layout of the hsperfdata file per HotSpot's perfMemory.hpp
+struct perf_data_prologue {
+  uint8_t magic[4];       // always big-endian 0xcafec0c0
+  int8_t  byte_order;
+  int8_t  major_version;
+  int8_t  minor_version;
+  int8_t  accessible;     // non-zero once the JVM has initialized the region
+  int32_t used;
+  int32_t overflow;
+  int64_t mod_time_stamp;
+  int32_t entry_offset;
+  int32_t num_entries;
+} __attribute__((packed));
+
+struct perf_data_entry {
+  int32_t entry_length;
+  int32_t name_offset;
+  int32_t vector_length;  // zero for scalar counters
+  int8_t  data_type;      // 'J' for jlong
+  int8_t  flags;
+  int8_t  data_units;
+  int8_t  data_variability;
+  int32_t data_offset;
+} __attribute__((packed));
+
+static const uint8_t perf_data_magic[4] = { 0xca, 0xfe, 0xc0, 0xc0 };
+
+static std::string find_hsperf_file(pid_t jvm_pid) {
+#if !defined(JAVA_WATCHDOG_STATIC)
+  // (a static build leaves out the user name lookup, as NSS would dlopen() shared libraries for it)
+  const struct passwd * const pw = getpwuid(geteuid());
+  if (pw != nullptr) {
+    auto path = format2str("/tmp/hsperfdata_%s/%d", pw->pw_name, jvm_pid);
+    if (access(path.c_str(), R_OK) == 0) return path;
+  }
+#endif
+  // the JVM may run as some other user, so try any hsperfdata directory
+  std::string path;
+  glob_t gl{};
+  if (glob(format2str("/tmp/hsperfdata_*/%d", jvm_pid).c_str(), 0, nullptr, &gl) == 0 && gl.gl_pathc > 0) {
+    path = gl.gl_pathv[0];
+  }
+  globfree(&gl);
+  return path;
+}
+
+bool hsperf_reader::attach(pid_t jvm_pid) {
+  detach();
+  const auto path = find_hsperf_file(jvm_pid);
+  if (path.empty()) return false;
+
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return false;
+  struct stat statbuf{};
+  if (fstat(fd, &statbuf) == -1 || statbuf.st_size < (off_t) sizeof(perf_data_prologue)) {
+    close(fd);
+    return false;
+  }
+  void * const addr = mmap(nullptr, (size_t) statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) return false;
+
+  const auto prologue = static_cast<const volatile perf_data_prologue*>(addr);
+  if (memcmp(const_cast<const uint8_t*>(prologue->magic), perf_data_magic, sizeof(perf_data_magic)) != 0
+      || prologue->accessible == 0)
+  {
+    munmap(addr, (size_t) statbuf.st_size);
+    return false;
+  }
+  base = static_cast<const char*>(addr);
+  mapped_size = (size_t) statbuf.st_size;
+  pid = jvm_pid;
+  index_entries();
+  log(LL::DEBUG, "attached to hsperfdata '%s' (%d counters)", path.c_str(), (int) longs.size());
+  return true;
+}
+
+void hsperf_reader::detach() {
+  if (base != nullptr) {
+    munmap(const_cast<char*>(base), mapped_size);
+  }
+  base = nullptr;
+  mapped_size = 0;
+  indexed_entries = 0;
+  longs.clear();
+  ticks_per_ms = 0.0;
+}
+
+void hsperf_reader::index_entries() {
+  const auto prologue = reinterpret_cast<const volatile perf_data_prologue*>(base);
+  const int32_t num_entries = prologue->num_entries;
+  size_t offset = (size_t) prologue->entry_offset;
+  for (int32_t i = 0; i < num_entries; i++) {
+    if (offset + sizeof(perf_data_entry) > mapped_size) break;
+    const auto entry = reinterpret_cast<const perf_data_entry*>(base + offset);
+    if (entry->entry_length <= 0 || offset + (size_t) entry->entry_length > mapped_size) break;
+    if (entry->data_type == 'J' && entry->vector_length == 0) {
+      const char * const name = base + offset + entry->name_offset;
+      const auto value = reinterpret_cast<const volatile int64_t*>(base + offset + entry->data_offset);
+      longs.emplace(std::string(name, strnlen(name, mapped_size - (offset + entry->name_offset))), value);
+    }
+    offset += (size_t) entry->entry_length;
+  }
+  indexed_entries = num_entries;
+  const auto freq = longs.find("sun.os.hrt.frequency");
+  if (freq != longs.end() && *freq->second > 0) {
+    ticks_per_ms = (double) *freq->second / 1000.0;
+  }
+}
+
+const volatile int64_t* hsperf_reader::find(const std::string_view name) {
+  if (base == nullptr) return nullptr;
+  const std::string key{name};
+  auto it = longs.find(key);
+  if (it == longs.end()) {
+    // the JVM keeps registering counters while it initializes
+    const auto prologue = reinterpret_cast<const volatile perf_data_prologue*>(base);
+    if (prologue->num_entries == indexed_entries) return nullptr;
+    longs.clear();
+    index_entries();
+    it = longs.find(key);
+    if (it == longs.end()) return nullptr;
+  }
+  return it->second;
+}
+
+int64_t hsperf_reader::get(const std::string_view name) {
+  const auto counter = find(name);
+  return counter != nullptr ? *counter : -1;
+}
+
+int64_t hsperf_reader::sum(const std::string_view prefix, const std::string_view suffix) {
+  int64_t total = 0;
+  for (const auto &entry : longs) {
+    const std::string_view name{entry.first};
+    if (name.size() >= prefix.size() + suffix.size() &&
+        name.compare(0, prefix.size(), prefix) == 0 &&
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+    {
+      total += *entry.second;
+    }
+  }
+  return total;
+}
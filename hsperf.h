@@ -0,0 +1,67 @@
+/* hsperf.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __HSPERF_H__
+#define __HSPERF_H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <sys/types.h>
+
+/**
+ * Read-only view of the HotSpot performance counters a JVM publishes in its
+ * memory mapped hsperfdata file (/tmp/hsperfdata_<user>/<pid>). This is the
+ * same data source jstat reads; it costs the JVM nothing to have it sampled.
+ * <p>
+ * The file only appears some time after the JVM has started (and not at all
+ * if the JVM runs with -XX:-UsePerfData), so attach() is retried by callers.
+ */
+class hsperf_reader {
+private:
+  pid_t pid{0};
+  const char *base{nullptr};
+  size_t mapped_size{0};
+  int32_t indexed_entries{0};
+  std::unordered_map<std::string, const volatile int64_t*> longs;
+  double ticks_per_ms{0.0};
+  void index_entries();
+public:
+  hsperf_reader() = default;
+  hsperf_reader(const hsperf_reader &) = delete;
+  hsperf_reader& operator=(const hsperf_reader &) = delete;
+  ~hsperf_reader() { detach(); }
+
+  // returns true if the hsperfdata file of the specified JVM process is mapped
+  bool attach(pid_t jvm_pid);
+  void detach();
+  bool is_attached() const { return base != nullptr; }
+
+  // address of a long (jlong) counter or nullptr if no such counter exists
+  const volatile int64_t* find(const std::string_view name);
+  // value of a long counter or -1 if no such counter exists
+  int64_t get(const std::string_view name);
+  // sum of all long counters whose names begin with prefix and end with suffix
+  int64_t sum(const std::string_view prefix, const std::string_view suffix);
+  // converts a tick based time counter (e.g. sun.gc.collector.0.time) to milliseconds
+  double ticks_to_ms(int64_t ticks) const { return ticks_per_ms > 0 ? ticks / ticks_per_ms : 0.0; }
+};
+
+#endif //__HSPERF_H__
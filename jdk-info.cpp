@@ -0,0 +1,61 @@
+/* jdk-info.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <climits>
+#include <cstdlib>
+#include "path-concat.h"
+#include "cgroup.h"
+#include "jdk-info.h"
+
+static std::string parent_dir(const std::string &path) {
+  const auto slash = path.rfind(kPathSeparator);
+  return slash == std::string::npos || slash == 0 ? std::string("/") : path.substr(0, slash);
+}
+
+// extracts the JAVA_VERSION="..." value of a JDK release file
+static std::string release_version(const std::string &content) {
+  static const char key[] = "JAVA_VERSION=\"";
+  const auto pos = content.find(key);
+  if (pos == std::string::npos) return std::string();
+  const auto start = pos + sizeof(key) - 1;
+  const auto end = content.find('"', start);
+  return end == std::string::npos ? std::string() : content.substr(start, end - start);
+}
+
+jdk_info probe_jdk(const std::string &java_prog_path) {
+  jdk_info info;
+  char resolved[PATH_MAX];
+  info.java_path = realpath(java_prog_path.c_str(), resolved) != nullptr ? resolved : java_prog_path;
+  const auto home = parent_dir(parent_dir(info.java_path));
+  for (const auto &dir : { home, parent_dir(home) }) {
+    const auto version = release_version(cgroup::read_file(path_concat(dir, "release")));
+    if (!version.empty()) {
+      info.version = version;
+      break;
+    }
+  }
+  info.home = home;
+  if (!info.version.empty()) {
+    // "1.8.0_292" is feature release 8, "17.0.2" is 17
+    const int first = atoi(info.version.c_str());
+    const auto dot = info.version.find('.');
+    info.feature = first == 1 && dot != std::string::npos ? atoi(info.version.c_str() + dot + 1) : first;
+  }
+  return info;
+}
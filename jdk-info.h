@@ -0,0 +1,42 @@
+/* jdk-info.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __JDK_INFO_H__
+#define __JDK_INFO_H__
+
+#include <string>
+
+// what can be told about a JDK from its installation directory without running it
+struct jdk_info {
+  std::string java_path;      // java launcher program with symbolic links resolved
+  std::string home;           // JDK (or JRE) home directory, i.e., the parent of bin/
+  std::string version;        // JAVA_VERSION of the release file (e.g. "17.0.2" or "1.8.0_292")
+  int feature{0};             // feature release number (e.g. 17 or 8); zero if unknown
+};
+
+/**
+ * Resolves the JDK a java launcher program belongs to, per the release file of
+ * the JDK home (or of its parent directory for the jre/ of a JDK 8).
+ *
+ * @param java_prog_path path of the java launcher program
+ * @return the JDK info (home and version are empty if undetermined)
+ */
+jdk_info probe_jdk(const std::string &java_prog_path);
+
+#endif //__JDK_INFO_H__
@@ -0,0 +1,244 @@
+/* jvm-args.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include "path-concat.h"
+#include "jvm-args.h"
+
+// java launcher options whose value is the following argument
+static const char * const options_with_value[] = {
+    "-cp", "-classpath", "--class-path", "-p", "--module-path", "--upgrade-module-path", "--add-modules",
+    "--limit-modules", "--add-reads", "--add-exports", "--add-opens", "--patch-module", "--source",
+};
+
+static bool takes_value(const std::string_view arg) {
+  return std::any_of(std::begin(options_with_value), std::end(options_with_value),
+                     [arg](const char *option) { return arg == option; });
+}
+
+jvm_args::jvm_args(int argc, const char *argv[]) {
+  args.reserve((size_t) argc + 8);
+  for (int i = 0; i < argc; i++) {
+    args.emplace_back(argv[i]);
+  }
+  if (args.empty()) args.emplace_back();
+}
+
+void jvm_args::set_program(const std::string_view path) {
+  args[0] = path;
+}
+
+void jvm_args::inject(std::string option) {
+  args.insert(args.begin() + 1 + (long) injected, std::move(option));
+  injected++;
+}
+
+std::string jvm_option_name(const std::string_view option) {
+  if (option.compare(0, 4, "-XX:") == 0) {
+    const size_t start = option.size() > 4 && (option[4] == '+' || option[4] == '-') ? 5 : 4;
+    return "-XX:" + std::string(option.substr(start, option.find('=') - start));
+  }
+  if (option.compare(0, 2, "-D") == 0) {
+    return std::string(option.substr(0, option.find('=')));
+  }
+  for (const char *prefix : { "-Xmx", "-Xms", "-Xss", "-Xmn" }) {
+    if (option.compare(0, 4, prefix) == 0) return prefix;
+  }
+  return std::string(option);
+}
+
+size_t jvm_args::remove_options(const std::function<bool(const std::string_view option)> &matches) {
+  size_t removed = 0;
+  size_t end = main_index();
+  for (size_t i = 1; i < end;) {
+    const size_t count = takes_value(args[i]) && i + 1 < end ? 2 : 1;
+    if (!matches(args[i])) {
+      i += count;
+      continue;
+    }
+    args.erase(args.begin() + (long) i, args.begin() + (long) (i + count));
+    if (i <= injected) injected--;
+    end -= count;
+    removed++;
+  }
+  return removed;
+}
+
+void jvm_args::append_option(std::string option) {
+  args.insert(args.begin() + (long) main_index(), std::move(option));
+}
+
+void jvm_args::set_option(std::string option) {
+  const auto name = jvm_option_name(option);
+  std::vector<size_t> found;
+  const auto end = main_index();
+  for (size_t i = 1; i < end; i++) {
+    if (takes_value(args[i])) {
+      i++;
+    } else if (jvm_option_name(args[i]) == name) {
+      found.push_back(i);
+    }
+  }
+  if (found.empty()) {
+    append_option(std::move(option));
+    return;
+  }
+  // the first occurrence is replaced, the others are dropped
+  args[found.front()] = std::move(option);
+  for (size_t j = found.size(); j-- > 1;) {
+    args.erase(args.begin() + (long) found[j]);
+    if (found[j] <= injected) injected--;
+  }
+}
+
+size_t jvm_args::dedupe_options() {
+  // the options ahead of the main class, by their name (options taking a value by themselves plus the value)
+  std::vector<std::pair<size_t, std::string>> options;
+  const auto end = main_index();
+  for (size_t i = 1; i < end; i++) {
+    if (takes_value(args[i]) && i + 1 < end) {
+      options.emplace_back(i, args[i] + '\0' + args[i + 1]);
+      i++;
+    } else {
+      options.emplace_back(i, jvm_option_name(args[i]));
+    }
+  }
+  size_t removed = 0;
+  for (size_t j = options.size(); j-- > 0;) {
+    const bool is_repeated = std::any_of(options.begin() + (long) j + 1, options.end(),
+                                         [&](const auto &later) { return later.second == options[j].second; });
+    if (!is_repeated) continue;
+    const size_t i = options[j].first;
+    const size_t count = takes_value(args[i]) ? 2 : 1;
+    args.erase(args.begin() + (long) i, args.begin() + (long) (i + count));
+    if (i <= injected) injected--;
+    // (later entries are past i, and already examined, so only their names need to stay)
+    options.erase(options.begin() + (long) j);
+    removed++;
+  }
+  return removed;
+}
+
+std::string jvm_args::option_value(const std::string_view prefix) const {
+  std::string value;
+  const auto end = main_index();
+  for (size_t i = 1; i < end; i++) {
+    if (args[i].compare(0, prefix.size(), prefix) == 0) {
+      value = args[i].substr(prefix.size());
+    }
+  }
+  return value;
+}
+
+bool jvm_args::has_option(const std::string_view prefix) const {
+  const auto end = main_index();
+  for (size_t i = 1; i < end; i++) {
+    if (args[i].compare(0, prefix.size(), prefix) == 0) return true;
+  }
+  return false;
+}
+
+size_t jvm_args::main_index() const {
+  for (size_t i = 1; i < args.size(); i++) {
+    const auto &arg = args[i];
+    if (arg == "-jar" || arg == "-m" || arg == "--module") {
+      return i + 1 < args.size() ? i + 1 : args.size();
+    }
+    if (takes_value(arg)) {
+      i++;
+    } else if (arg.empty() || arg[0] != '-') {
+      return i;
+    }
+  }
+  return args.size();
+}
+
+// expands a class path entry of the form dir/* to the jar files of dir
+static void expand_entry(const std::string &entry, std::vector<std::string> &paths) {
+  if (entry.size() < 2 || entry.compare(entry.size() - 2, 2, "/*") != 0) {
+    if (!entry.empty()) paths.push_back(entry);
+    return;
+  }
+  const auto dir_path = entry.substr(0, entry.size() - 2);
+  DIR * const dir = opendir(dir_path.empty() ? "/" : dir_path.c_str());
+  if (dir == nullptr) return;
+  std::vector<std::string> jars;
+  for (const struct dirent *ent = readdir(dir); ent != nullptr; ent = readdir(dir)) {
+    const size_t len = strlen(ent->d_name);
+    if (len > 4 && (strcmp(ent->d_name + len - 4, ".jar") == 0 || strcmp(ent->d_name + len - 4, ".JAR") == 0)) {
+      jars.push_back(path_concat(dir_path, ent->d_name));
+    }
+  }
+  closedir(dir);
+  std::sort(jars.begin(), jars.end()); // readdir() order is arbitrary
+  paths.insert(paths.end(), jars.begin(), jars.end());
+}
+
+std::vector<std::string> jvm_args::classpath() const {
+  std::string path_list;
+  bool is_specified = false;
+  const auto end = main_index();
+  for (size_t i = 1; i < end; i++) {
+    if ((args[i] == "-cp" || args[i] == "-classpath" || args[i] == "--class-path") && i + 1 < end) {
+      path_list = args[++i];
+      is_specified = true;
+    } else if (args[i].compare(0, 13, "--class-path=") == 0) {
+      path_list = args[i].substr(13);
+      is_specified = true;
+    }
+  }
+  std::vector<std::string> paths;
+  if (end > 1 && end < args.size() && args[end - 1] == "-jar") {
+    paths.push_back(args[end]); // the class path options are ignored by the launcher with -jar
+    return paths;
+  }
+  if (!is_specified) {
+    const char * const env = getenv("CLASSPATH");
+    path_list = env != nullptr ? env : ".";
+  }
+  size_t pos = 0;
+  while (pos <= path_list.size()) {
+    auto colon = path_list.find(':', pos);
+    if (colon == std::string::npos) colon = path_list.size();
+    expand_entry(path_list.substr(pos, colon - pos), paths);
+    pos = colon + 1;
+  }
+  return paths;
+}
+
+char* const* jvm_args::argv() {
+  const size_t ptrs_size = (args.size() + 1) * sizeof(char*);
+  size_t arena_size = ptrs_size;
+  for (const auto &arg : args) {
+    arena_size += arg.size() + 1;
+  }
+  arena.reset(new char[arena_size]);
+  const auto ptrs = reinterpret_cast<char**>(arena.get());
+  char *str = arena.get() + ptrs_size;
+  for (size_t i = 0; i < args.size(); i++) {
+    ptrs[i] = str;
+    memcpy(str, args[i].c_str(), args[i].size() + 1);
+    str += args[i].size() + 1;
+  }
+  ptrs[args.size()] = nullptr;
+  return ptrs;
+}
@@ -0,0 +1,88 @@
+/* jvm-args.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __JVM_ARGS_H__
+#define __JVM_ARGS_H__
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * The command line the java launcher is exec'd with. The watchdog injects its
+ * own JVM options right after argv[0], ahead of those supplied by the user, so
+ * that a user-supplied -XX option of the same name still wins (the JVM honors
+ * the last occurrence).
+ */
+class jvm_args {
+private:
+  std::vector<std::string> args;
+  std::unique_ptr<char[]> arena;  // argv(): the pointer array followed by the strings it points at
+  size_t injected{0};
+public:
+  jvm_args(int argc, const char *argv[]);
+
+  // replaces argv[0] (i.e., with the path of the java launcher program)
+  void set_program(const std::string_view path);
+  // inserts an option after argv[0] and any previously injected options
+  void inject(std::string option);
+
+  /*
+   * Rewriting of the JVM options (those ahead of the main class, -jar file or
+   * main module; the application's own arguments are never touched).
+   */
+  // removes the options matching (along with the value of an option taking one, e.g. the path of -cp);
+  // returns the count of options removed
+  size_t remove_options(const std::function<bool(const std::string_view option)> &matches);
+  // appends an option after the other JVM options, where it takes precedence over them
+  void append_option(std::string option);
+  // replaces the options of the same name (see jvm_option_name()) with option, or else appends it
+  void set_option(std::string option);
+  // removes options repeating one of the same name later on (the JVM honors the last); returns the count removed
+  size_t dedupe_options();
+
+  size_t size() const { return args.size(); }
+  const std::string& operator[](size_t i) const { return args[i]; }
+
+  // value of the last option starting with prefix (e.g. "-XX:ErrorFile=") or else empty
+  std::string option_value(const std::string_view prefix) const;
+  // true if any option starts with prefix
+  bool has_option(const std::string_view prefix) const;
+  // index of the main class, main module or -jar file argument; size() if there is none
+  size_t main_index() const;
+  // the jar files and directories of the class path (-cp, -jar or $CLASSPATH) with wildcards expanded
+  std::vector<std::string> classpath() const;
+
+  // null-terminated argument array as passed to execv(), built in a single allocation
+  // (valid until the next call; later modifications are not reflected in it)
+  char* const* argv();
+};
+
+/**
+ * The name identifying what a JVM option sets, for options the JVM honors
+ * the last occurrence of: -XX:+Flag, -XX:-Flag and -XX:Flag=value are all
+ * -XX:Flag; -Dkey=value is -Dkey; -Xmx512m is -Xmx (likewise -Xms, -Xss and
+ * -Xmn). Any other option (e.g. -javaagent:..., which may be repeated) is
+ * named by itself in full.
+ */
+std::string jvm_option_name(const std::string_view option);
+
+#endif //__JVM_ARGS_H__
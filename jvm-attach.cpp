@@ -0,0 +1,182 @@
+/* jvm-attach.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "cgroup.h"
+#include "format2str.h"
+#include "log.h"
+#include "jvm-attach.h"
+
+using namespace logger;
+
+// the pid of the process within its own (innermost) pid namespace
+static pid_t namespace_pid(pid_t pid) {
+  const auto status = cgroup::read_file(format2str("/proc/%d/status", pid));
+  const auto pos = status.find("NSpid:");
+  if (pos == std::string::npos) return pid;
+  const auto eol = status.find('\n', pos);
+  const auto line = status.substr(pos, eol == std::string::npos ? std::string::npos : eol - pos);
+  const auto last = line.find_last_of(" \t");
+  return last == std::string::npos ? pid : (pid_t) strtol(line.c_str() + last + 1, nullptr, 10);
+}
+
+void jvm_attach_client::reset(pid_t jvm_pid) {
+  if (fd != -1) {
+    loop->remove_fd(fd);
+    close(fd);
+    fd = -1;
+    if (deadline_timer != -1) loop->cancel_timer(deadline_timer);
+    deadline_timer = -1;
+    on_reply = nullptr;
+  }
+  if (!attach_file.empty()) {
+    unlink(attach_file.c_str());
+    attach_file.clear();
+  }
+  pid = jvm_pid;
+  if (pid == 0) return;
+  ns_pid = namespace_pid(pid);
+  socket_path = format2str("/proc/%d/root/tmp/.java_pid%d", pid, ns_pid);
+}
+
+bool jvm_attach_client::is_listening() const {
+  struct stat statbuf{};
+  return pid != 0 && stat(socket_path.c_str(), &statbuf) == 0 && S_ISSOCK(statbuf.st_mode);
+}
+
+bool jvm_attach_client::request_listener() {
+  if (pid == 0) return false;
+  if (is_listening()) return true;
+  // the JVM looks for the attach file in its working directory, then in its /tmp
+  for (const auto &path : { format2str("/proc/%d/cwd/.attach_pid%d", pid, ns_pid),
+                            format2str("/proc/%d/root/tmp/.attach_pid%d", pid, ns_pid) })
+  {
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0660);
+    if (fd != -1) {
+      close(fd);
+      attach_file = path;
+      break;
+    }
+  }
+  if (attach_file.empty()) {
+    log(LL::DEBUG, "could not create attach file for JVM (pid:%d): %s", pid, strerror(errno));
+    return false;
+  }
+  return kill(pid, SIGQUIT) == 0;
+}
+
+int jvm_attach_client::connect_listener() const {
+  const int sock_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sock_fd == -1) return -1;
+  struct sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  // /proc/<pid>/root/... may exceed sun_path, so connect via the socket file's directory
+  const auto slash = socket_path.rfind('/');
+  const int dir_fd = open(socket_path.substr(0, slash).c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+  const auto short_path = format2str("/proc/self/fd/%d/%s", dir_fd, socket_path.c_str() + slash + 1);
+  strncpy(addr.sun_path, short_path.c_str(), sizeof(addr.sun_path) - 1);
+  // (a unix socket connects at once, or fails with EAGAIN should the listener's backlog be full)
+  const bool is_connected = dir_fd != -1 && connect(sock_fd, (const struct sockaddr *) &addr, sizeof(addr)) == 0;
+  if (dir_fd != -1) close(dir_fd);
+  if (!is_connected) {
+    close(sock_fd);
+    return -1;
+  }
+  return sock_fd;
+}
+
+bool jvm_attach_client::jcmd(event_loop &event_loop, const std::string_view command, int timeout_ms,
+                             jcmd_handler on_reply)
+{
+  if (fd != -1 || !is_listening()) return false;
+  if (!attach_file.empty()) {
+    unlink(attach_file.c_str()); // served its purpose
+    attach_file.clear();
+  }
+  fd = connect_listener();
+  if (fd == -1) return false;
+
+  // protocol version, command and three arguments, each null terminated (a request the socket buffer takes whole)
+  std::string request{"1"};
+  request += '\0';
+  request += "jcmd";
+  request += '\0';
+  request += command;
+  request.append(3, '\0');
+  if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t) request.size()) {
+    close(fd);
+    fd = -1;
+    return false;
+  }
+  loop = &event_loop;
+  this->command = command;
+  this->on_reply = std::move(on_reply);
+  reply.clear();
+  loop->add_fd(fd, EPOLLIN, [this](uint32_t) { on_readable(); });
+  deadline_timer = loop->add_timer(std::chrono::milliseconds(timeout_ms), [this]() {
+    deadline_timer = -1;
+    log(LL::DEBUG, "jcmd \"%s\" of JVM (pid:%d) timed out", this->command.c_str(), pid);
+    complete(false);
+  }, false);
+  return true;
+}
+
+// the JVM closes the connection once it has written the whole reply
+void jvm_attach_client::on_readable() {
+  char buf[8192];
+  for (;;) {
+    const ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n > 0) {
+      reply.append(buf, (size_t) n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    // the reply starts with the command's return code on a line of its own
+    const bool is_ok = n == 0 && reply.compare(0, 2, "0\n") == 0;
+    if (!is_ok) {
+      log(LL::DEBUG, "jcmd \"%s\" of JVM (pid:%d) failed: %.200s", command.c_str(), pid, reply.c_str());
+    }
+    complete(is_ok);
+    return;
+  }
+}
+
+void jvm_attach_client::complete(bool is_ok) {
+  loop->remove_fd(fd);
+  close(fd);
+  fd = -1;
+  if (deadline_timer != -1) loop->cancel_timer(deadline_timer);
+  deadline_timer = -1;
+  if (is_ok) reply.erase(0, 2);
+  // (the handler may start the next command)
+  const auto handler = std::move(on_reply);
+  on_reply = nullptr;
+  const auto output = std::move(reply);
+  reply.clear();
+  handler(is_ok, output);
+}
@@ -0,0 +1,93 @@
+/* jvm-attach.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __JVM_ATTACH_H__
+#define __JVM_ATTACH_H__
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include "event-loop.h"
+
+/**
+ * Client of the HotSpot dynamic attach mechanism (what jcmd uses): commands
+ * are sent over the unix socket /tmp/.java_pid<pid> that the JVM's attach
+ * listener creates. The listener is started on demand by creating an
+ * .attach_pid<pid> file and sending the JVM SIGQUIT.
+ * <p>
+ * Paths go through /proc/<pid>/root and the JVM's namespace pid is used, so a
+ * JVM in a container's mount and pid namespaces can be attached to as well.
+ * The watchdog must run as the JVM's user (or root).
+ * <p>
+ * SIGQUIT kills a JVM that has not yet installed its signal handlers, so only
+ * request the listener of a JVM that is well past its startup.
+ * <p>
+ * A command is run from the watchdog's event loop: its reply is read as it
+ * arrives and a timer bounds the exchange, as commands such as GC.run on a
+ * large heap can take a while.
+ */
+class jvm_attach_client {
+public:
+  // receives whether the JVM ran the command successfully, and the command's output
+  using jcmd_handler = std::function<void(bool is_ok, const std::string &output)>;
+private:
+  pid_t pid{0};
+  pid_t ns_pid{0};
+  std::string socket_path;
+  std::string attach_file;
+  event_loop *loop{nullptr};
+  int fd{-1};                         // socket of the exchange in progress
+  int deadline_timer{-1};
+  std::string command;
+  std::string reply;
+  jcmd_handler on_reply;
+  int connect_listener() const;
+  void on_readable();
+  void complete(bool is_ok);
+public:
+  jvm_attach_client() = default;
+  jvm_attach_client(const jvm_attach_client &) = delete;
+  jvm_attach_client& operator=(const jvm_attach_client &) = delete;
+  ~jvm_attach_client() { reset(0); }
+
+  // targets a JVM process (removes any attach file left for a prior one, and abandons any command in progress)
+  void reset(pid_t jvm_pid);
+  // true if the attach listener of the JVM is up
+  bool is_listening() const;
+  // asks the JVM to start its attach listener (it is up once is_listening() turns true)
+  bool request_listener();
+
+  /**
+   * Starts a jcmd diagnostic command (e.g. "VM.native_memory summary"); one
+   * at a time.
+   *
+   * @param event_loop the loop of the watchdog, which serves the exchange
+   * @param command the command line as given to jcmd
+   * @param timeout_ms bound on the whole exchange
+   * @param on_reply called once the command is done, failed or timed out (not
+   * when abandoned by reset()); the handler may start the next command
+   * @return false if it could not be started (on_reply is not called then)
+   */
+  bool jcmd(event_loop &event_loop, const std::string_view command, int timeout_ms, jcmd_handler on_reply);
+  // true while a command is in progress
+  bool is_busy() const { return fd != -1; }
+};
+
+#endif //__JVM_ATTACH_H__
@@ -0,0 +1,135 @@
+/* jvm-rewrite.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fnmatch.h>
+#include "format2str.h"
+#include "malloc-policy.h"
+#include "log.h"
+#include "jvm-rewrite.h"
+
+using namespace logger;
+
+namespace {
+
+  bool holds(const rewrite_condition &condition, double value) {
+    switch (condition.op) {
+      case COMPARISON::ANY: return true;
+      case COMPARISON::LT:  return value < condition.value;
+      case COMPARISON::LE:  return value <= condition.value;
+      case COMPARISON::EQ:  return value == condition.value;
+      case COMPARISON::NE:  return value != condition.value;
+      case COMPARISON::GE:  return value >= condition.value;
+      case COMPARISON::GT:  return value > condition.value;
+    }
+    return false;
+  }
+
+  // NAME=GLOB holds if the variable's value matches; NAME alone if the variable is set and not empty
+  bool holds_env(const std::string &condition) {
+    const auto eq = condition.find('=');
+    const char * const value = getenv(condition.substr(0, eq).c_str());
+    if (eq == std::string::npos) return value != nullptr && *value != '\0';
+    return fnmatch(condition.c_str() + eq + 1, value != nullptr ? value : "", 0) == 0;
+  }
+
+}
+
+bool jvm_rewriter::matcher::matches(const std::string_view option) const {
+  switch (kind) {
+    case KIND::EXACT:  return option == pattern;
+    case KIND::PREFIX: return option.compare(0, pattern.size(), pattern) == 0;
+    case KIND::GLOB:   return fnmatch(pattern.c_str(), std::string(option).c_str(), 0) == 0;
+  }
+  return false;
+}
+
+jvm_rewriter::jvm_rewriter(const std::vector<rewrite_settings> &cfg) {
+  if (cfg.empty()) return;
+  // the host is probed only for conditions some rule has
+  const bool is_memory_used = std::any_of(cfg.begin(), cfg.end(),
+      [](const rewrite_settings &rule) { return rule.memory.op != COMPARISON::ANY; });
+  const bool is_cpus_used = std::any_of(cfg.begin(), cfg.end(),
+      [](const rewrite_settings &rule) { return rule.cpus.op != COMPARISON::ANY; });
+  const uint64_t memory_limit = is_memory_used ? memory_limit_bytes() : 0;
+  const double memory = memory_limit != 0 ? (double) memory_limit : HUGE_VAL;
+  const double cpus = is_cpus_used ? effective_cpus(std::string()) : 0.0;
+
+  for (const auto &rule_cfg : cfg) {
+    rule r{rule_cfg, {}, true};
+    for (const auto &pattern : rule_cfg.remove) {
+      const auto meta = pattern.find_first_of("*?[\\");
+      if (meta == std::string::npos) {
+        r.remove.push_back({ matcher::KIND::EXACT, pattern });
+      } else if (meta == pattern.size() - 1 && pattern[meta] == '*') {
+        r.remove.push_back({ matcher::KIND::PREFIX, pattern.substr(0, meta) });
+      } else {
+        r.remove.push_back({ matcher::KIND::GLOB, pattern });
+      }
+    }
+    if (!holds(rule_cfg.memory, memory)) {
+      log(LL::DEBUG, "rewrite rule \"%s\" does not apply to a memory limit of %s", rule_cfg.name.c_str(),
+          memory_limit != 0 ? format2str("%lu MB", (unsigned long) (memory_limit >> 20)).c_str() : "none");
+      r.is_host_match = false;
+    } else if (!holds(rule_cfg.cpus, cpus)) {
+      log(LL::DEBUG, "rewrite rule \"%s\" does not apply to %.2f CPUs", rule_cfg.name.c_str(), cpus);
+      r.is_host_match = false;
+    } else {
+      for (const auto &condition : rule_cfg.env) {
+        if (!holds_env(condition)) {
+          log(LL::DEBUG, "rewrite rule \"%s\" does not apply: %s does not hold", rule_cfg.name.c_str(),
+              condition.c_str());
+          r.is_host_match = false;
+          break;
+        }
+      }
+    }
+    rules.push_back(std::move(r));
+  }
+}
+
+unsigned jvm_rewriter::apply(jvm_args &args, const std::string &jvm_name, int jdk_feature) const {
+  unsigned applied = 0;
+  for (const auto &r : rules) {
+    if (!r.is_host_match || fnmatch(r.cfg.process.c_str(), jvm_name.c_str(), 0) != 0) continue;
+    if (r.cfg.jdk.op != COMPARISON::ANY && (jdk_feature == 0 || !holds(r.cfg.jdk, jdk_feature))) {
+      log(LL::DEBUG, "rewrite rule \"%s\" does not apply to JDK %d", r.cfg.name.c_str(), jdk_feature);
+      continue;
+    }
+    size_t removed = 0;
+    if (!r.remove.empty()) {
+      removed = args.remove_options([&r](const std::string_view option) {
+        return std::any_of(r.remove.begin(), r.remove.end(), [option](const matcher &m) { return m.matches(option); });
+      });
+    }
+    for (const auto &option : r.cfg.set) {
+      args.set_option(option);
+    }
+    for (const auto &option : r.cfg.add) {
+      args.append_option(option);
+    }
+    const size_t deduped = r.cfg.dedupe ? args.dedupe_options() : 0;
+    log(LL::INFO, "rewrite rule \"%s\" applied to JVM \"%s\": %zu option(s) removed, %zu set, %zu added, %zu deduped",
+        r.cfg.name.c_str(), jvm_name.c_str(), removed, r.cfg.set.size(), r.cfg.add.size(), deduped);
+    applied++;
+  }
+  return applied;
+}
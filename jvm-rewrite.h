@@ -0,0 +1,73 @@
+/* jvm-rewrite.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __JVM_REWRITE_H__
+#define __JVM_REWRITE_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "settings.h"
+#include "jvm-args.h"
+
+/**
+ * Rewrites the JVM options of a java command line per the [rewrite.NAME]
+ * rules of config.ini, so that tuning (G1 vs ZGC, region and code cache
+ * sizes, ...) can be rolled out by config rather than by rebuilding images.
+ * <p>
+ * The rules are compiled once: their remove patterns into matchers (exact,
+ * prefix or fnmatch() glob), and their host conditions - the cgroup memory
+ * limit, the effective CPUs and the environment - evaluated up front. The
+ * JDK feature release and JVM name conditions are checked per JVM.
+ * <p>
+ * Each rule whose conditions hold is applied in config order: its remove
+ * patterns first, then set, add and dedupe. Options it adds or sets follow
+ * the user's JVM options, so they take precedence (the JVM honors the last
+ * occurrence of an option). Arguments of the application (those after the
+ * main class, -jar file or main module) are never touched.
+ */
+class jvm_rewriter {
+private:
+  struct matcher {
+    enum class KIND : char { EXACT, PREFIX, GLOB };
+    KIND kind;
+    std::string pattern;        // without the trailing * of a PREFIX
+    bool matches(const std::string_view option) const;
+  };
+  struct rule {
+    const rewrite_settings &cfg;
+    std::vector<matcher> remove;
+    bool is_host_match;         // the memory, CPU and environment conditions hold
+  };
+  std::vector<rule> rules;
+public:
+  explicit jvm_rewriter(const std::vector<rewrite_settings> &cfg);
+
+  /**
+   * Applies the rules whose conditions hold for a JVM.
+   *
+   * @param args the JVM's command line
+   * @param jvm_name "main" for the JVM of the watchdog's command line, else its [process.NAME] name
+   * @param jdk_feature feature release of the JVM's JDK (zero if unknown)
+   * @return count of rules applied
+   */
+  unsigned apply(jvm_args &args, const std::string &jvm_name, int jdk_feature) const;
+};
+
+#endif //__JVM_REWRITE_H__
@@ -0,0 +1,452 @@
+/* jvm-runner.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "crash-collector.h"
+#include "format2str.h"
+#include "path-concat.h"
+#include "trace.h"
+#include "log.h"
+#include "jvm-runner.h"
+
+using namespace logger;
+
+namespace {
+
+  // parses a CPU list such as "0-3,8"; false if it is malformed
+  bool parse_cpu_list(const std::string &list, cpu_set_t &cpus) {
+    CPU_ZERO(&cpus);
+    const char *p = list.c_str();
+    while (*p != '\0') {
+      char *end = nullptr;
+      const long first = strtol(p, &end, 10);
+      if (end == p || first < 0) return false;
+      long last = first;
+      if (*end == '-') {
+        p = end + 1;
+        last = strtol(p, &end, 10);
+        if (end == p || last < first) return false;
+      }
+      for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+        CPU_SET((int) cpu, &cpus);
+      }
+      if (*end != ',' && *end != '\0') return false;
+      p = *end == ',' ? end + 1 : end;
+    }
+    return CPU_COUNT(&cpus) > 0;
+  }
+
+  // the command line of the JVM (argv[0] is replaced by the java launcher path)
+  jvm_args make_args(const process_settings &process) {
+    std::vector<const char*> argv{ "java" };
+    for (const auto &arg : process.args) {
+      argv.push_back(arg.c_str());
+    }
+    argv.push_back(nullptr);
+    return jvm_args((int) argv.size() - 1, argv.data());
+  }
+
+  /**
+   * Writes the last few minutes of sampled metrics of a crashed child process
+   * to a compact file next to its crash log (or to the configured directory).
+   *
+   * @param ring the in-memory compressed metrics ring
+   * @param cfg the [metrics] settings
+   * @param crash_dir directory of the JVM crash log
+   * @param pid the pid of the crashed child process
+   * @return path of the written metrics file or an empty string on failure
+   */
+  std::string write_postmortem_metrics(const metric_ring &ring, const metrics_settings &cfg,
+                                       const std::string &crash_dir, pid_t pid)
+  {
+    const auto &dir = cfg.postmortem_dir.empty() ? crash_dir : cfg.postmortem_dir;
+    const auto path = path_concat(dir, format2str("java_watchdog_metrics_pid%d.tsdb", pid));
+    try {
+      const auto since_ms = wall_clock_ms() - cfg.postmortem_window.count();
+      const auto samples = ring.write_since(path, since_ms);
+      log(LL::INFO, "wrote %zu metrics samples of child process (pid:%d) to \"%s\"", samples, pid, path.c_str());
+      return path;
+    } catch(const tsdb_exception &ex) {
+      log(LL::ERR, "failed writing postmortem metrics of child process (pid:%d):\n\t%s: %s", pid, ex.name(),
+          ex.what());
+    }
+    return "";
+  }
+
+}
+
+jvm_runner::jvm_runner(const watchdog_settings &cfg, const process_settings &process, const std::string &java_path,
+                       std::string cgroup_name, std::string label, watchdog_services *services)
+    : cfg{cfg}, process{process}, services{services}, label{std::move(label)}, cgroup_name{std::move(cgroup_name)},
+      hang_cfg{cfg.hang}, throttle_cfg{cfg.throttle}, tuning_cfg{cfg.tuning}, malloc_cfg{cfg.malloc},
+      arbiter_cfg{cfg.arbiter}, java_path{java_path},
+      jdk{[&java_path]() { trace::span span{"probe_jdk"}; return probe_jdk(java_path); }()},
+      args{make_args(process)}, cds{cfg.cds, jdk}, tree{cfg.process_tree.teardown}, prewarm{cfg.prewarm},
+      readiness{cfg.readiness, this->label}, hang{hang_cfg, this->label}, leak{cfg.leak, this->label},
+      throttle{throttle_cfg}, tuner{tuning_cfg, jdk}, arbiter{arbiter_cfg}, allocator{malloc_cfg}
+{
+  hang_cfg.heartbeat_file = for_jvm(hang_cfg.heartbeat_file);
+  hang_cfg.heartbeat_socket = for_jvm(hang_cfg.heartbeat_socket);
+  throttle_cfg.recommend_file = for_jvm(throttle_cfg.recommend_file);
+  tuning_cfg.state_file = for_jvm(tuning_cfg.state_file);
+  malloc_cfg.report_file = for_jvm(malloc_cfg.report_file);
+  arbiter_cfg.name = for_jvm(arbiter_cfg.name);
+
+  args.set_program(java_path);
+  log(LL::DEBUG, "%s: JDK home \"%s\", version %s", this->label.c_str(), jdk.home.c_str(),
+      jdk.version.empty() ? "unknown" : jdk.version.c_str());
+  if (!cfg.rewrites.empty()) {
+    trace::span span{"rewrite_jvm_args"};
+    jvm_rewriter(cfg.rewrites).apply(args, process.name, jdk.feature);
+  }
+
+  // the JVM crash log directory is where postmortem metrics get written
+  error_file = args.option_value("-XX:ErrorFile=");
+  heap_dump_path = args.option_value("-XX:HeapDumpPath=");
+  crash_dir = crash_log_dir(error_file);
+
+  if (cfg.output.capture) {
+    relay = std::make_unique<output_relay>(cfg.output.tail_size);
+  }
+  if (cfg.metrics.enabled) {
+    ring = std::make_unique<metric_ring>(
+        std::vector<std::string_view>(metric_names.begin(), metric_names.end()), cfg.metrics.ring_budget);
+    log(LL::DEBUG, "%s: metrics ring of %zu bytes sampled every %ld ms", this->label.c_str(),
+        ring->capacity_bytes(), (long) cfg.metrics.sample_interval.count());
+  }
+
+  // a JVM bound to CPUs of its own is not placed on a NUMA node
+  if (!process.cpus.empty()) {
+    is_bound = parse_cpu_list(process.cpus, cpus);
+    if (!is_bound) {
+      log(LL::WARN, "invalid cpus '%s' of %s ignored - the JVM is not bound to CPUs", process.cpus.c_str(),
+          this->label.c_str());
+    }
+  }
+  if (!is_bound) {
+    trace::span span{"numa_plan"};
+    placement.plan(cfg.numa);
+  }
+  allocator.plan(is_bound ? process.cpus : placement.is_active() ? placement.cpu_list() : std::string());
+
+  leak.prepare(args);
+  throttle.prepare(args);
+  if (cfg.prewarm.enabled) {
+    classpath = args.classpath();
+  }
+}
+
+jvm_runner::~jvm_runner() {
+  detach();
+  if (teardown_timer != -1) loop->cancel_timer(teardown_timer);
+}
+
+std::string jvm_runner::for_jvm(const std::string &value) const {
+  return is_primary() || value.empty() ? value : value + "." + process.name;
+}
+
+void jvm_runner::prepare_launch() {
+  {
+    // (a relaunch uses the AppCDS archive the run it follows dumped, and is tuned per its profile)
+    trace::span span{"cds_prepare"};
+    cds.prepare(args);
+  }
+  tuner.prepare(args);
+  {
+    trace::span span{"process_tree_prepare"};
+    tree.prepare(cgroup_name);
+  }
+  if (cfg.numa.cpuset && placement.is_active()) {
+    tree.set_cpuset(placement.cpu_list(), placement.node_list());
+  }
+  if (relay) {
+    try {
+      relay->open_pipes();
+    } catch(const output_relay_exception &ex) {
+      log(LL::WARN, "not capturing output of %s:\n\t%s: %s", label.c_str(), ex.name(), ex.what());
+      relay.reset();
+    }
+  }
+}
+
+bool jvm_runner::launch(event_loop &event_loop, const sigset_t &orig_signals) {
+  prepare_launch();
+  char* const* const exec_argv = args.argv();
+  char* const* const exec_envp = services != nullptr ? services->listeners.envp(allocator.envp()) : allocator.envp();
+
+  logger::flush_syslog(); // else the child would send the queued messages too
+  launch_ns = monotonic_ns();
+  trace::instant("fork");
+  const pid_t child = fork();
+  if (child == -1) {
+    log(LL::ERR, "pid(%d): fork() of %s failed: %s", getpid(), label.c_str(), strerror(errno));
+    return false;
+  } else if (child == 0) {
+    // child process
+    if (is_debug_level()) {
+      log(LL::DEBUG, "pid(%d): argc: %zu ; first arg: '%s', second arg: '%s'",
+          getpid(), args.size(), exec_argv[0], args.size() > 1 ? exec_argv[1] : "");
+    }
+    // the signal mask is inherited across execve() so restore it for the JVM
+    sigprocmask(SIG_SETMASK, &orig_signals, nullptr);
+    tree.enter_child();
+    if (is_bound) {
+      sched_setaffinity(0, sizeof(cpus), &cpus);
+    } else {
+      placement.apply_child();
+    }
+    if (relay) {
+      relay->redirect_child();
+    }
+    if (services != nullptr) {
+      services->listeners.apply_child();
+    }
+    // this forked child process will now become the found java launcher program
+    // (the supplied command line arguments will now be applied to the java launcher)
+    trace::record("child_pre_exec", launch_ns, trace::now_ns() - launch_ns);
+    execve(java_path.c_str(), exec_argv, exec_envp);
+    log(LL::ERR, "pid(%d): failed to exec '%s': %s", getpid(), java_path.c_str(), strerror(errno));
+    logger::flush_syslog();
+    // (not returning into the watchdog, whose destructors would unlink the parent's control and listening sockets)
+    _exit(EXIT_FAILURE);
+  }
+
+  pid = child;
+  loop = &event_loop;
+  is_attached = true;
+  result = outcome{};
+  stop_ns = 0;
+  tree.adopt(pid);
+  // reads ahead the JDK and class path files while the JVM boots (a relaunch finds them cached)
+  if (launches == 0) {
+    prewarm.start(jdk.home, std::move(classpath), cds.is_archive_in_use() ? cds.archive() : std::string());
+  }
+  log(LL::INFO, "started %s (pid:%d)%s", label.c_str(), pid,
+      launches > 0 ? format2str("; launch %u", launches + 1).c_str() : "");
+  attach();
+  launches++;
+  return true;
+}
+
+void jvm_runner::attach() {
+  if (relay) {
+    // startup latency as seen from outside the JVM, for comparing launches with and without prewarm/AppCDS
+    relay->add_listener([this, is_reported = false](std::string_view) mutable {
+      if (is_reported) return;
+      is_reported = true;
+      trace::instant("first_output");
+      log(LL::INFO, "%s (pid:%d) time to first output: %ld ms (prewarm %s, AppCDS %s)", label.c_str(), pid,
+          (long) ((relay->first_output_time_ns() - launch_ns) / 1000000), cfg.prewarm.enabled ? "on" : "off",
+          cds.is_archive_in_use() ? "on" : "off");
+    });
+    relay->attach(*loop);
+  }
+
+  live_stats * const stats = services != nullptr ? &services->stats : nullptr;
+  if (stats != nullptr) {
+    stats->on_launch(pid, launches);
+  }
+  if (ring || (stats != nullptr && stats->is_enabled())) {
+    sampler.attach(pid);
+    const auto interval = ring ? cfg.metrics.sample_interval : cfg.stats.interval;
+    sample_timer = loop->add_timer(interval, [this, stats]() {
+      if (sampler.sample(values)) {
+        leak.publish(values);
+        throttle.publish(values);
+        if (ring) {
+          ring->append(wall_clock_ms(), values.data());
+        }
+        if (stats != nullptr) {
+          if (readiness.is_ready()) {
+            stats->set_state(WATCHDOG_STATE::READY);
+          }
+          stats->set_metrics(values);
+        }
+      }
+    });
+  }
+
+  if (services != nullptr) {
+    readiness.attach(*loop, pid, tree, relay.get(), launch_ns);
+  }
+  hang.attach(*loop, pid, tree);
+  leak.attach(*loop, pid);
+  throttle.attach(*loop, pid);
+  tuner.attach(*loop, pid, relay.get());
+  if (services != nullptr) {
+    services->control.attach(*loop, pid, launches, launch_ns, [this]() {
+      result.is_restart_requested = true;
+      kill(pid, SIGTERM);
+      begin_stop();
+    });
+  }
+  arbiter.attach(*loop, pid);
+}
+
+void jvm_runner::detach() {
+  if (!is_attached) return;
+  for (int *timer : { &sample_timer, &deadline_timer, &kill_timer }) {
+    if (*timer != -1) loop->cancel_timer(*timer);
+    *timer = -1;
+  }
+  if (relay) {
+    relay->drain();
+  }
+  if (services != nullptr) {
+    readiness.detach();
+    services->control.detach();
+  }
+  result.is_hang_killed = result.is_hang_killed || hang.is_hung();
+  hang.detach();
+  leak.detach();
+  throttle.detach();
+  tuner.detach();
+  arbiter.detach();
+  is_attached = false;
+}
+
+void jvm_runner::forward(int signo) const {
+  if (!is_attached) return;
+  log(LL::INFO, "forwarding signal %d (%s) to %s (pid:%d)", signo, strsignal(signo), label.c_str(), pid);
+  kill(pid, signo);
+}
+
+void jvm_runner::stop(int signo) {
+  if (!is_attached) return;
+  forward(signo);
+  result.is_stop_requested = true;
+  begin_stop();
+}
+
+// the JVM gets the shutdown deadline to terminate, whether shutting down or restarting
+void jvm_runner::begin_stop() {
+  if (stop_ns != 0) return;
+  if (services != nullptr) {
+    services->stats.set_state(WATCHDOG_STATE::STOPPING);
+  }
+  result.is_hang_killed = hang.is_hung();
+  hang.detach(); // a slow shutdown is the business of the shutdown deadline
+  stop_ns = monotonic_ns();
+  if (cfg.shutdown.timeout.count() > 0) {
+    deadline_timer = loop->add_timer(cfg.shutdown.timeout, [this]() {
+      deadline_timer = -1;
+      on_deadline();
+    }, false);
+  }
+}
+
+void jvm_runner::on_deadline() {
+  log(LL::WARN, "%s (pid:%d) still running %ld ms after shutdown request - requesting thread dump",
+      label.c_str(), pid, (long) cfg.shutdown.timeout.count());
+  kill(pid, SIGQUIT);
+  kill_timer = loop->add_timer(cfg.shutdown.thread_dump_wait, [this]() {
+    kill_timer = -1;
+    log(LL::ERR, "shutdown deadline expired - killing %s (pid:%d)", label.c_str(), pid);
+    result.is_deadline_killed = true;
+    tree.kill_all();
+    kill(pid, SIGKILL);
+  }, false);
+}
+
+void jvm_runner::finish(int status, const struct rusage &usage, finished_handler on_finished) {
+  detach();
+  result.status = status;
+  this->on_finished = std::move(on_finished);
+  if (stop_ns != 0) {
+    log(LL::INFO, "%s (pid:%d) shut down in %ld ms", label.c_str(), pid, stop_elapsed_ms());
+  }
+  if (services != nullptr) {
+    services->stats.on_exit(status);
+  }
+  prewarm.stop();
+  allocator.report(pid, usage.ru_maxrss, (monotonic_ns() - launch_ns) / 1000000);
+  tuner.finish(status, result.is_deadline_killed || result.is_hang_killed, usage.ru_maxrss);
+
+  // whatever the JVM left running (or orphaned) goes down with it
+  if (tree.teardown_mode() == TEARDOWN::NONE) {
+    conclude();
+    return;
+  }
+  teardown_ns = trace::now_ns();
+  tree.kill_all();
+  if (tree.is_empty()) {
+    await_teardown();
+    return;
+  }
+  teardown_timer = loop->add_timer(milliseconds(10), [this]() { await_teardown(); });
+}
+
+// completes the teardown of the process tree once it is empty (or has not emptied within a second)
+void jvm_runner::await_teardown() {
+  const auto elapsed_ns = trace::now_ns() - teardown_ns;
+  const bool is_empty = tree.is_empty();
+  if (!is_empty && elapsed_ns < 1000000000L) return;
+  if (teardown_timer != -1) loop->cancel_timer(teardown_timer);
+  teardown_timer = -1;
+  if (!is_empty) {
+    log(LL::WARN, "processes of %s (pid:%d) remain 1000 ms after process tree teardown", label.c_str(), pid);
+  }
+  tree.release();
+  trace::record("teardown", teardown_ns, elapsed_ns);
+  log(LL::DEBUG, "process tree of %s (pid:%d) torn down in %ld us", label.c_str(), pid, (long) (elapsed_ns / 1000));
+  conclude();
+}
+
+// finishes the run's AppCDS archive - an -Xshare:dump of it delays only the relaunch of this JVM - then reports
+void jvm_runner::conclude() {
+  const auto cds_start_ns = trace::now_ns();
+  cds.finish(*loop, WIFEXITED(result.status) && !result.is_deadline_killed, [this, cds_start_ns]() {
+    trace::record("cds_finish", cds_start_ns, trace::now_ns() - cds_start_ns);
+    report();
+  });
+}
+
+void jvm_runner::report() {
+  const bool is_abnormal = result.is_hang_killed || !WIFEXITED(result.status) || WEXITSTATUS(result.status) != 0;
+  if (is_abnormal && !result.is_stop_requested && !result.is_restart_requested) {
+    collect_crash_artifacts();
+  }
+  // (the handler may well relaunch the JVM, which resets both)
+  const auto handler = std::move(on_finished);
+  const auto finished = result;
+  on_finished = nullptr;
+  handler(finished);
+}
+
+// gathers the postmortem metrics and JVM crash artifacts of an abnormally terminated JVM
+void jvm_runner::collect_crash_artifacts() {
+  trace::span span{"crash_collect"};
+  crash_artifacts artifacts;
+  if (ring) {
+    artifacts.metrics_file = write_postmortem_metrics(*ring, cfg.metrics, crash_dir, pid);
+  }
+  if (cfg.crash.enabled) {
+    artifacts.pid = pid;
+    artifacts.is_signaled = WIFSIGNALED(result.status);
+    artifacts.crash_dir = crash_dir;
+    artifacts.error_file = error_file;
+    artifacts.heap_dump_path = heap_dump_path;
+    if (relay) {
+      artifacts.output_tail = relay->tail_text();
+    }
+    collect_crash_bundle(cfg.crash, artifacts);
+  }
+}
@@ -0,0 +1,219 @@
+/* jvm-runner.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __JVM_RUNNER_H__
+#define __JVM_RUNNER_H__
+
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+#include "proc-stats.h"
+#include "tsdb.h"
+#include "output-relay.h"
+#include "proc-tree.h"
+#include "numa.h"
+#include "jvm-args.h"
+#include "jvm-rewrite.h"
+#include "jdk-info.h"
+#include "app-cds.h"
+#include "prewarm.h"
+#include "readiness.h"
+#include "hang.h"
+#include "leak.h"
+#include "malloc-policy.h"
+#include "throttle.h"
+#include "tuning.h"
+#include "control.h"
+#include "listen-sockets.h"
+#include "arbiter.h"
+#include "live-stats.h"
+
+/**
+ * Runs one JVM for the watchdog - the JVM of the command line or that of a
+ * [process.NAME] section, alike - from the preparation of each launch (AppCDS
+ * archive, tuned options, NUMA placement or CPU binding, native allocator
+ * policy, process tree) through its supervision within the watchdog's event
+ * loop (sampled metrics, readiness, hang, native memory leak and CPU throttling
+ * detection, output relay, memory arbitration, shutdown deadline) to its
+ * termination, when its process tree is torn down and, should it have ended
+ * abnormally, its postmortem metrics and crash bundle are collected.
+ * <p>
+ * When and how often it is launched, stopped and relaunched is the decision of
+ * process_supervisor. The services of the watchdog as a whole - the control
+ * socket, the inherited listening sockets, the live stats and the readiness
+ * reporting - serve its primary JVM only. For a JVM other than the primary, the
+ * file and socket paths of the [hang], [throttle], [tuning] and [malloc]
+ * sections, and the [arbiter] name, get ".NAME" appended so that its JVMs do
+ * not share them.
+ */
+class jvm_runner {
+public:
+  // how a launch of the JVM came to terminate
+  struct outcome {
+    int status{0};                      // waitpid() status
+    bool is_stop_requested{false};      // the JVM was sent a shutdown signal by stop()
+    bool is_restart_requested{false};   // a restart command of the control socket stopped the JVM
+    bool is_deadline_killed{false};     // the shutdown deadline expired and the JVM was sent SIGKILL
+    bool is_hang_killed{false};         // the JVM was declared hung and killed
+  };
+  using finished_handler = std::function<void(const outcome &result)>;
+  // the services of the watchdog as a whole, which its primary JVM is the one to get
+  struct watchdog_services {
+    control_server &control;
+    listen_sockets &listeners;
+    live_stats &stats;
+  };
+private:
+  const watchdog_settings &cfg;
+  const process_settings &process;
+  watchdog_services * const services;   // nullptr unless the primary JVM
+  const std::string label;              // how logging refers to the JVM
+  const std::string cgroup_name;
+  hang_settings hang_cfg;
+  throttle_settings throttle_cfg;
+  tuning_settings tuning_cfg;
+  malloc_settings malloc_cfg;
+  arbiter_settings arbiter_cfg;
+  std::string java_path;
+  jdk_info jdk;
+  jvm_args args;
+  std::string error_file;               // the crash log options of the JVM (and where postmortem metrics go)
+  std::string heap_dump_path;
+  std::string crash_dir;
+  app_cds cds;
+  process_tree tree;
+  std::unique_ptr<output_relay> relay;
+  std::unique_ptr<metric_ring> ring;
+  numa_placement placement;
+  cpu_set_t cpus{};
+  bool is_bound{false};
+  prewarmer prewarm;
+  readiness_detector readiness;
+  hang_detector hang;
+  leak_detector leak;
+  throttle_monitor throttle;
+  jvm_tuner tuner;
+  memory_arbiter arbiter;
+  malloc_policy allocator;
+  proc_sampler sampler;
+  metric_values values{};
+  std::vector<std::string> classpath;   // read ahead by the prewarmer at the first launch
+  event_loop *loop{nullptr};
+  bool is_attached{false};              // the JVM is running and supervised
+  pid_t pid{0};
+  unsigned launches{0};
+  int64_t launch_ns{0};
+  int64_t stop_ns{0};
+  int sample_timer{-1};
+  int deadline_timer{-1};
+  int kill_timer{-1};
+  int teardown_timer{-1};
+  int64_t teardown_ns{0};
+  outcome result;
+  finished_handler on_finished;
+  std::string for_jvm(const std::string &value) const;
+  void prepare_launch();
+  void attach();
+  void detach();
+  void begin_stop();
+  void on_deadline();
+  void await_teardown();
+  void conclude();
+  void report();
+  void collect_crash_artifacts();
+public:
+  /**
+   * @param cfg the config.ini settings (must outlive the runner)
+   * @param process the JVM's settings - its name and command line among them (must outlive the runner)
+   * @param java_path the java launcher program found for the JVM
+   * @param cgroup_name name of the child cgroup confining its process tree (unique per co-located watchdog)
+   * @param label how logging refers to the JVM (e.g. "child process" or "process \"NAME\"")
+   * @param services the watchdog services for the primary JVM, nullptr for any other
+   */
+  jvm_runner(const watchdog_settings &cfg, const process_settings &process, const std::string &java_path,
+             std::string cgroup_name, std::string label, watchdog_services *services);
+  jvm_runner(const jvm_runner &) = delete;
+  jvm_runner& operator=(const jvm_runner &) = delete;
+  ~jvm_runner();
+
+  /**
+   * Launches the JVM (anew, if it ran before) and starts supervising it.
+   * <p>
+   * SIGCHLD and the signals the watchdog handles must be blocked, as the child
+   * restores orig_signals prior to exec.
+   *
+   * @param event_loop the loop of the watchdog, which reports the termination of the JVM back via finish()
+   * @param orig_signals the signal mask to restore in the child
+   * @return false if the fork() failed
+   */
+  bool launch(event_loop &event_loop, const sigset_t &orig_signals);
+
+  // forwards a signal to the JVM, e.g. a SIGQUIT thread dump request
+  void forward(int signo) const;
+
+  /**
+   * Forwards a shutdown signal to the JVM and starts its shutdown deadline: once
+   * that expires, a SIGQUIT thread dump is requested and, after thread_dump_wait,
+   * its process tree is killed.
+   */
+  void stop(int signo);
+
+  /**
+   * Ends the supervision of the terminated JVM, reaped by the watchdog: tears
+   * down its process tree, finishes the run's AppCDS archive and tuning profile
+   * and, if it ended abnormally other than on request, collects its postmortem
+   * metrics and crash bundle.
+   * <p>
+   * This completes asynchronously within the event loop - the tree is polled
+   * until empty, for up to a second, and an -Xshare:dump of the AppCDS archive
+   * is a child process reported back via reaped() - so other JVMs are
+   * supervised meanwhile; on_finished is called once it has.
+   *
+   * @param status the waitpid() status of the JVM (the java launcher program)
+   * @param usage its resource usage per wait4()
+   * @param on_finished receives how the JVM came to terminate
+   */
+  void finish(int status, const struct rusage &usage, finished_handler on_finished);
+
+  // true if pid, reaped by the watchdog, is a helper process of the runner (an -Xshare:dump of the AppCDS archive)
+  bool reaped(pid_t pid, int status) { return cds.reaped(pid, status); }
+
+  // kills the process tree of the JVM outright (the watchdog can no longer supervise it)
+  void kill_all() const { tree.kill_all(); }
+
+  const process_settings& settings() const { return process; }
+  const std::string& name() const { return process.name; }
+  const char* description() const { return label.c_str(); }
+  bool is_primary() const { return services != nullptr; }
+  pid_t child_pid() const { return pid; }
+  // count of launches so far
+  unsigned launch_count() const { return launches; }
+  // milliseconds since the JVM was asked to stop
+  long stop_elapsed_ms() const { return stop_ns != 0 ? (long) ((monotonic_ns() - stop_ns) / 1000000) : 0; }
+};
+
+#endif //__JVM_RUNNER_H__
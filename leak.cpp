@@ -0,0 +1,257 @@
+/* leak.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cgroup.h"
+#include "format2str.h"
+#include "log.h"
+#include "path-concat.h"
+#include "leak.h"
+
+using namespace logger;
+
+namespace {
+
+  // the fit thins out the samples it keeps so that it stays cheap regardless of sample_interval
+  const size_t max_window_samples = 240;
+  const int jcmd_timeout_ms = 5000;
+
+  // value (in kB) of a "Name:   1234 kB" line of smaps_rollup
+  double rollup_kb(const char *rollup, const char *name) {
+    const char * const p = strstr(rollup, name);
+    return p != nullptr ? strtod(p + strlen(name), nullptr) : 0.0;
+  }
+
+  uint64_t read_bytes(const std::string &path) {
+    if (path.empty()) return 0;
+    const auto str = cgroup::read_file(path);
+    return str.empty() || str.compare(0, 3, "max") == 0 ? 0 : strtoull(str.c_str(), nullptr, 10);
+  }
+
+  // memory limit and usage of the watchdog's cgroup (zero limit if there is none)
+  void cgroup_memory(uint64_t &limit, uint64_t &usage) {
+    limit = read_bytes(cgroup::v2_file("memory.max"));
+    if (limit != 0) {
+      usage = read_bytes(cgroup::v2_file("memory.current"));
+      return;
+    }
+    const auto v1 = cgroup::v1_dir("memory");
+    if (v1.empty()) return;
+    limit = read_bytes(path_concat(v1, "memory.limit_in_bytes"));
+    if (limit >= (1ULL << 62)) limit = 0; // the v1 way of saying unlimited
+    usage = read_bytes(path_concat(v1, "memory.usage_in_bytes"));
+  }
+
+  /**
+   * Summarizes the NMT categories whose committed memory grew the most, per
+   * the lines of a VM.native_memory summary.diff such as:
+   * "-                  Internal (reserved=2056KB +12KB, committed=2056KB +12KB)"
+   */
+  std::string nmt_top_growth(const std::string &diff) {
+    std::vector<std::pair<long, std::string>> growth;
+    size_t pos = 0;
+    while (pos < diff.size()) {
+      auto eol = diff.find('\n', pos);
+      if (eol == std::string::npos) eol = diff.size();
+      const auto line = diff.substr(pos, eol - pos);
+      pos = eol + 1;
+      const auto paren = line.find(" (reserved=");
+      const auto committed = line.find("committed=");
+      if (line.empty() || line[0] != '-' || paren == std::string::npos || committed == std::string::npos) continue;
+      const auto delta = line.find_first_of("+-", line.find("KB", committed));
+      if (delta == std::string::npos || delta > line.find(')', committed)) continue;
+      const long kb = strtol(line.c_str() + delta, nullptr, 10);
+      const auto name_start = line.find_first_not_of("- ");
+      if (kb > 0 && name_start < paren) growth.emplace_back(kb, line.substr(name_start, paren - name_start));
+    }
+    std::sort(growth.begin(), growth.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    std::string summary;
+    for (size_t i = 0; i < growth.size() && i < 3; i++) {
+      if (!summary.empty()) summary += ", ";
+      summary += format2str("%s +%ld KB", growth[i].second.c_str(), growth[i].first);
+    }
+    return summary;
+  }
+
+}
+
+double leak_detector::theil_sen_slope(const double *x, const double *y, size_t n, std::vector<double> &scratch) {
+  scratch.clear();
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = i + 1; j < n; j++) {
+      if (x[j] != x[i]) scratch.push_back((y[j] - y[i]) / (x[j] - x[i]));
+    }
+  }
+  if (scratch.empty()) return 0.0;
+  const auto mid = scratch.begin() + (ptrdiff_t) (scratch.size() / 2);
+  std::nth_element(scratch.begin(), mid, scratch.end());
+  if (scratch.size() % 2 != 0) return *mid;
+  const double upper = *mid;
+  return (upper + *std::max_element(scratch.begin(), mid)) / 2.0;
+}
+
+void leak_detector::prepare(jvm_args &args) {
+  if (!cfg.enabled || !cfg.nmt) return;
+  if (!args.has_option("-XX:NativeMemoryTracking=")) {
+    args.inject("-XX:NativeMemoryTracking=summary");
+  }
+  is_nmt = args.option_value("-XX:NativeMemoryTracking=") != "off";
+}
+
+void leak_detector::attach(event_loop &event_loop, pid_t child_pid) {
+  if (!cfg.enabled) return;
+  loop = &event_loop;
+  pid = child_pid;
+  window.clear();
+  anon_kb = slope_kb_per_h = hours_to_limit = 0.0;
+  last_alert_ns = 0;
+  is_nmt_baselined = false;
+  nmt_growth.clear();
+  attach_client.reset(pid);
+  smaps_fd = open(format2str("/proc/%d/smaps_rollup", pid).c_str(), O_RDONLY | O_CLOEXEC);
+  if (smaps_fd == -1) {
+    log(LL::WARN, "could not open smaps_rollup of %s (pid:%d) - leak detection disabled: %s",
+        label.c_str(), pid, strerror(errno));
+    return;
+  }
+  sample_timer = loop->add_timer(cfg.sample_interval, [this]() { sample_memory(); });
+  if (is_nmt) {
+    // (well past JVM startup, as requesting the attach listener sends the JVM SIGQUIT)
+    nmt_timer = loop->add_timer(cfg.nmt_interval, [this]() { check_nmt(); });
+  }
+}
+
+void leak_detector::detach() {
+  if (loop != nullptr) {
+    if (sample_timer != -1) loop->cancel_timer(sample_timer);
+    if (nmt_timer != -1) loop->cancel_timer(nmt_timer);
+    if (listener_timer != -1) loop->cancel_timer(listener_timer);
+    loop = nullptr;
+  }
+  sample_timer = nmt_timer = listener_timer = -1;
+  if (smaps_fd != -1) {
+    close(smaps_fd);
+    smaps_fd = -1;
+  }
+  attach_client.reset(0);
+}
+
+void leak_detector::sample_memory() {
+  char buf[4096];
+  ssize_t n = pread(smaps_fd, buf, sizeof(buf) - 1, 0);
+  if (n <= 0) {
+    // opened prior to the child's execv(), the file still refers to the address space the exec replaced
+    close(smaps_fd);
+    char smaps_path[48];
+    format_to(smaps_path, "/proc/%d/smaps_rollup", pid);
+    smaps_fd = open(smaps_path, O_RDONLY | O_CLOEXEC);
+    n = pread(smaps_fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return;
+  }
+  buf[n] = '\0';
+  anon_kb = rollup_kb(buf, "\nAnonymous:");
+  const double rss_kb = rollup_kb(buf, "\nRss:");
+
+  const auto now_ns = monotonic_ns();
+  const int64_t window_ns = (int64_t) cfg.window.count() * 1000000;
+  while (!window.empty() && now_ns - window.front().time_ns > window_ns) {
+    window.pop_front();
+  }
+  if (window.empty() || now_ns - window.back().time_ns >= window_ns / (int64_t) max_window_samples) {
+    window.push_back({now_ns, anon_kb});
+  }
+  // the trend needs a quarter of the window's span before it is worth fitting
+  const int64_t span_ns = window.back().time_ns - window.front().time_ns;
+  if (window.size() < 8 || span_ns < window_ns / 4) return;
+
+  std::vector<double> x, y;
+  x.reserve(window.size());
+  y.reserve(window.size());
+  for (const auto &entry : window) {
+    x.push_back((double) (entry.time_ns - window.front().time_ns) / 3.6e12); // hours
+    y.push_back(entry.anon_kb);
+  }
+  slope_kb_per_h = theil_sen_slope(x.data(), y.data(), x.size(), slopes);
+
+  uint64_t limit = 0, usage = 0;
+  cgroup_memory(limit, usage);
+  hours_to_limit = 0.0;
+  if (limit > usage && slope_kb_per_h > 0.0) {
+    hours_to_limit = (double) (limit - usage) / 1024.0 / slope_kb_per_h;
+  }
+  log(LL::TRACE, "%s (pid:%d) rss %.0f kB (anon %.0f kB, file %.0f kB), anon trend %+.1f kB/h",
+      label.c_str(), pid, rss_kb, anon_kb, rss_kb - anon_kb, slope_kb_per_h);
+
+  if (slope_kb_per_h * 1024.0 >= (double) cfg.min_slope &&
+      (last_alert_ns == 0 || now_ns - last_alert_ns >= (int64_t) cfg.alert_interval.count() * 1000000))
+  {
+    last_alert_ns = now_ns;
+    alert();
+  }
+}
+
+void leak_detector::alert() {
+  const double span_h = (double) (window.back().time_ns - window.front().time_ns) / 3.6e12;
+  const double horizon_h = (double) cfg.alert_horizon.count() / 3.6e6;
+  const bool is_imminent = hours_to_limit > 0.0 && hours_to_limit <= horizon_h;
+  const auto projection = hours_to_limit > 0.0 ?
+      format2str("; memory limit projected to be reached in %.1f h", hours_to_limit) : std::string();
+  const auto nmt = nmt_growth.empty() ? std::string() : "; NMT growth: " + nmt_growth;
+  const auto span = span_h >= 1.0 ? format2str("%.1f h", span_h) : format2str("%.0f min", span_h * 60.0);
+  log(is_imminent ? LL::ERR : LL::WARN, "%s (pid:%d) suspected native memory leak: anonymous memory "
+      "growing %.1f MB/h over the last %s (now %.0f MB)%s%s", label.c_str(), pid, slope_kb_per_h / 1024.0,
+      span.c_str(), anon_kb / 1024.0, projection.c_str(), nmt.c_str());
+}
+
+void leak_detector::check_nmt() {
+  if (loop == nullptr || attach_client.is_busy()) return;
+  if (!attach_client.is_listening()) {
+    if (listener_timer == -1 && attach_client.request_listener()) {
+      // the listener comes up within moments of the request
+      listener_timer = loop->add_timer(milliseconds(2000), [this]() {
+        listener_timer = -1;
+        check_nmt();
+      }, false);
+    }
+    return;
+  }
+  if (!is_nmt_baselined) {
+    attach_client.jcmd(*loop, "VM.native_memory baseline", jcmd_timeout_ms, [this](bool is_ok, const std::string &) {
+      is_nmt_baselined = is_ok;
+    });
+    return;
+  }
+  attach_client.jcmd(*loop, "VM.native_memory summary.diff", jcmd_timeout_ms,
+                     [this](bool is_ok, const std::string &output) {
+    if (!is_ok) return;
+    nmt_growth = nmt_top_growth(output);
+    log(LL::DEBUG, "%s (pid:%d) NMT growth since baseline: %s", label.c_str(), pid,
+        nmt_growth.empty() ? "none" : nmt_growth.c_str());
+  });
+}
+
+void leak_detector::publish(metric_values &values) const {
+  if (loop == nullptr) return;
+  at(values, METRIC::ANON_KB) = anon_kb;
+  at(values, METRIC::LEAK_KB_PER_H) = slope_kb_per_h;
+  at(values, METRIC::LEAK_HOURS_TO_LIMIT) = slope_kb_per_h * 1024.0 >= (double) cfg.min_slope ? hours_to_limit : 0.0;
+}
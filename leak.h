@@ -0,0 +1,106 @@
+/* leak.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __LEAK_H__
+#define __LEAK_H__
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+#include "jvm-args.h"
+#include "jvm-attach.h"
+#include "proc-stats.h"
+
+/**
+ * Watches the child JVM for slow native memory leaks (direct buffers, Netty
+ * arenas, malloc arena fragmentation) - the kind that end in an OOM kill days
+ * after they begin.
+ * <p>
+ * The RSS of the JVM, split into anonymous and file backed memory, is sampled
+ * from /proc/<pid>/smaps_rollup. A Theil-Sen fit (the median of the slopes
+ * between every pair of samples) over the sliding window gives the growth rate
+ * of anonymous memory; being robust to outliers, a GC or a burst of traffic
+ * doesn't sway it. Sustained growth above min_slope is logged as a leak,
+ * together with the projected time until the cgroup memory limit is reached.
+ * <p>
+ * With nmt enabled, the JVM runs with -XX:NativeMemoryTracking=summary and a
+ * VM.native_memory summary.diff (against a baseline taken at the first
+ * interval) is obtained via the attach mechanism, so alerts can tell which
+ * JVM subsystem is growing.
+ */
+class leak_detector {
+private:
+  struct sample {
+    int64_t time_ns;
+    double anon_kb;
+  };
+  const leak_settings &cfg;
+  const std::string &label;           // how logging refers to the JVM
+  pid_t pid{0};
+  event_loop *loop{nullptr};
+  int smaps_fd{-1};
+  int sample_timer{-1};
+  int nmt_timer{-1};
+  int listener_timer{-1};               // awaits the attach listener the JVM was asked to start
+  std::deque<sample> window;
+  std::vector<double> slopes;           // scratch space of the fit
+  double anon_kb{0.0};
+  double slope_kb_per_h{0.0};
+  double hours_to_limit{0.0};
+  int64_t last_alert_ns{0};
+  bool is_nmt{false};
+  bool is_nmt_baselined{false};
+  jvm_attach_client attach_client;
+  std::string nmt_growth;               // summary of the NMT categories growing most
+  void sample_memory();
+  void check_nmt();
+  void alert();
+public:
+  // (label must outlive the detector)
+  leak_detector(const leak_settings &cfg, const std::string &label) : cfg{cfg}, label{label} {}
+  leak_detector(const leak_detector &) = delete;
+  leak_detector& operator=(const leak_detector &) = delete;
+  ~leak_detector() { detach(); }
+
+  // adds -XX:NativeMemoryTracking=summary to the JVM options when nmt is enabled; call prior to fork()
+  void prepare(jvm_args &args);
+  // starts watching the child; call in the parent after fork()
+  void attach(event_loop &loop, pid_t pid);
+  void detach();
+
+  // fills in the leak metrics of a metrics sample
+  void publish(metric_values &values) const;
+
+  /**
+   * Theil-Sen slope estimate: the median of the slopes between all pairs of points.
+   *
+   * @param x the x coordinates (need not be sorted)
+   * @param y the y coordinates
+   * @param n number of points
+   * @param scratch reused for the pairwise slopes
+   * @return the slope (zero if fewer than two distinct x coordinates)
+   */
+  static double theil_sen_slope(const double *x, const double *y, size_t n, std::vector<double> &scratch);
+};
+
+#endif //__LEAK_H__
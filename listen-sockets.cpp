@@ -0,0 +1,224 @@
+/* listen-sockets.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "log.h"
+#include "listen-sockets.h"
+
+using namespace logger;
+
+namespace {
+
+  constexpr int first_fd = 3;           // SD_LISTEN_FDS_START
+
+  bool is_listen_var(const char *var) {
+    for (const char *name : { "LISTEN_FDS=", "LISTEN_PID=", "LISTEN_FDNAMES=", "JAVA_WATCHDOG_LISTEN_FDS=" }) {
+      if (strncmp(var, name, strlen(name)) == 0) return true;
+    }
+    return false;
+  }
+
+  int listen_on(int domain, const sockaddr *addr, socklen_t addr_len, unsigned backlog) {
+    const int fd = socket(domain, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return -1;
+    const int on = 1, off = 0;
+    if (domain != AF_UNIX) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    // a wildcard IPv6 socket accepts IPv4 connections too
+    if (domain == AF_INET6) setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    if (bind(fd, addr, addr_len) == -1 || listen(fd, (int) backlog) == -1) {
+      const int err = errno;
+      ::close(fd);
+      errno = err;
+      return -1;
+    }
+    return fd;
+  }
+
+}
+
+int listen_sockets::bind_socket(const listen_socket &socket, std::string &unix_path) const {
+  const std::string &address = socket.address;
+  if (address.compare(0, 5, "unix:") == 0) {
+    // unix:PATH, or unix:@NAME for an abstract socket
+    const std::string path = address.substr(5);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+      errno = ENAMETOOLONG;
+      return -1;
+    }
+    memcpy(addr.sun_path, path.data(), path.size());
+    const bool is_abstract = path[0] == '@';
+    if (is_abstract) {
+      addr.sun_path[0] = '\0';
+    } else {
+      unlink(path.c_str()); // a socket left behind by a watchdog killed outright
+    }
+    const int fd = listen_on(AF_UNIX, reinterpret_cast<const sockaddr*>(&addr),
+                             (socklen_t) (offsetof(sockaddr_un, sun_path) + path.size() + (is_abstract ? 0 : 1)),
+                             cfg.backlog);
+    if (fd != -1 && !is_abstract) unix_path = path;
+    return fd;
+  }
+
+  // PORT, HOST:PORT or [IPV6]:PORT
+  std::string host, port;
+  const auto colon = address.rfind(':');
+  if (colon == std::string::npos) {
+    port = address;
+  } else {
+    host = address.substr(0, colon);
+    port = address.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+  }
+  const auto port_num = strtoul(port.c_str(), nullptr, 10);
+  if (port.empty() || port.find_first_not_of("0123456789") != std::string::npos || port_num > 65535) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (host.empty() || host == "*") {
+    // every address; dual-stack where the host has IPv6
+    sockaddr_in6 addr6{};
+    addr6.sin6_family = AF_INET6;
+    addr6.sin6_addr = in6addr_any;
+    addr6.sin6_port = htons((uint16_t) port_num);
+    const int fd = listen_on(AF_INET6, reinterpret_cast<const sockaddr*>(&addr6), sizeof(addr6), cfg.backlog);
+    if (fd != -1 || (errno != EAFNOSUPPORT && errno != EADDRNOTAVAIL)) return fd;
+    sockaddr_in addr4{};
+    addr4.sin_family = AF_INET;
+    addr4.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr4.sin_port = htons((uint16_t) port_num);
+    return listen_on(AF_INET, reinterpret_cast<const sockaddr*>(&addr4), sizeof(addr4), cfg.backlog);
+  }
+  // a numeric address only: resolving a host name would take glibc's NSS modules (shared libraries, which
+  // java-watchdog-static does without), and a listening address is numeric as a rule anyway
+  sockaddr_in addr4{};
+  addr4.sin_family = AF_INET;
+  addr4.sin_port = htons((uint16_t) port_num);
+  if (inet_pton(AF_INET, host.c_str(), &addr4.sin_addr) == 1) {
+    return listen_on(AF_INET, reinterpret_cast<const sockaddr*>(&addr4), sizeof(addr4), cfg.backlog);
+  }
+  sockaddr_in6 addr6{};
+  addr6.sin6_family = AF_INET6;
+  addr6.sin6_port = htons((uint16_t) port_num);
+  if (inet_pton(AF_INET6, host.c_str(), &addr6.sin6_addr) == 1) {
+    return listen_on(AF_INET6, reinterpret_cast<const sockaddr*>(&addr6), sizeof(addr6), cfg.backlog);
+  }
+  log(LL::ERR, "listening socket \"%s\" address \"%s\": \"%s\" is not a numeric IPv4 or IPv6 address",
+      socket.name.c_str(), address.c_str(), host.c_str());
+  errno = EINVAL;
+  return -1;
+}
+
+bool listen_sockets::open() {
+  if (cfg.sockets.empty() || !held.empty()) return true;
+  const int count = (int) cfg.sockets.size();
+  for (const auto &socket : cfg.sockets) {
+    std::string unix_path;
+    const int fd = bind_socket(socket, unix_path);
+    if (fd == -1) {
+      log(LL::ERR, "could not listen on \"%s\" for listening socket \"%s\": %s", socket.address.c_str(),
+          socket.name.c_str(), strerror(errno));
+      close();
+      return false;
+    }
+    // held above the fds the child gets them as, so that apply_child() never overwrites one before moving it
+    const int high_fd = fcntl(fd, F_DUPFD_CLOEXEC, first_fd + count);
+    if (high_fd == -1) {
+      log(LL::ERR, "could not hold listening socket \"%s\": %s", socket.name.c_str(), strerror(errno));
+      ::close(fd);
+      if (!unix_path.empty()) unlink(unix_path.c_str());
+      close();
+      return false;
+    }
+    ::close(fd);
+    held.push_back({ high_fd, std::move(unix_path) });
+    log(LL::INFO, "listening on \"%s\" as socket \"%s\" (fd %d of the JVM)", socket.address.c_str(),
+        socket.name.c_str(), first_fd + (int) held.size() - 1);
+  }
+  return true;
+}
+
+void listen_sockets::close() {
+  for (const auto &socket : held) {
+    ::close(socket.fd);
+    if (!socket.unix_path.empty()) unlink(socket.unix_path.c_str());
+  }
+  held.clear();
+}
+
+char* const* listen_sockets::envp(char* const* base) {
+  if (held.empty()) return base;
+  std::string names, fds;
+  for (size_t i = 0; i < held.size(); i++) {
+    if (i > 0) {
+      names += ':';
+      fds += ',';
+    }
+    names += cfg.sockets[i].name;
+    fds += cfg.sockets[i].name + '=' + std::to_string(first_fd + (int) i);
+  }
+  env.clear();
+  for (char* const* var = base; *var != nullptr; var++) {
+    if (!is_listen_var(*var)) env.emplace_back(*var);
+  }
+  env.push_back("LISTEN_FDS=" + std::to_string(held.size()));
+  env.push_back("LISTEN_FDNAMES=" + names);
+  env.push_back("JAVA_WATCHDOG_LISTEN_FDS=" + fds);
+  // the pid of the child is only known once forked, so room is reserved for its digits
+  env.push_back("LISTEN_PID=" + std::string(sizeof("4294967295"), '\0'));
+  env_ptrs.clear();
+  for (auto &var : env) {
+    env_ptrs.push_back(var.data());
+  }
+  env_ptrs.push_back(nullptr);
+  listen_pid = env.back().data() + strlen("LISTEN_PID=");
+  return env_ptrs.data();
+}
+
+void listen_sockets::apply_child() const {
+  if (held.empty()) return;
+  for (size_t i = 0; i < held.size(); i++) {
+    // (the fd dup2() creates is not close-on-exec)
+    dup2(held[i].fd, first_fd + (int) i);
+  }
+  if (cfg.inherited_channel) {
+    dup2(held[0].fd, STDIN_FILENO);
+  }
+  if (listen_pid != nullptr) {
+    char digits[16];
+    int n = 0;
+    for (auto pid = (unsigned) getpid(); pid != 0 || n == 0; pid /= 10) {
+      digits[n++] = (char) ('0' + pid % 10);
+    }
+    for (int i = 0; i < n; i++) {
+      listen_pid[i] = digits[n - 1 - i];
+    }
+    listen_pid[n] = '\0';
+  }
+}
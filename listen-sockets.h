@@ -0,0 +1,68 @@
+/* listen-sockets.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __LISTEN_SOCKETS_H__
+#define __LISTEN_SOCKETS_H__
+
+#include <string>
+#include <vector>
+#include "settings.h"
+
+/**
+ * Listening sockets the watchdog binds once and holds for all launches of the
+ * JVM, so that a restart does not refuse connections: while no JVM accepts,
+ * the kernel queues them (up to backlog) and the next JVM picks them up.
+ * <p>
+ * The child inherits the sockets as fds 3, 4, ... in config.ini order, per the
+ * socket activation convention of systemd - LISTEN_FDS, LISTEN_PID and
+ * LISTEN_FDNAMES in its environment - plus JAVA_WATCHDOG_LISTEN_FDS, a list of
+ * NAME=FD pairs (e.g. "http=3,admin=4"). With inherited_channel, the first
+ * socket is the JVM's stdin as well, where System.inheritedChannel() finds it.
+ */
+class listen_sockets {
+private:
+  struct held_socket {
+    int fd;
+    std::string unix_path;             // unlinked on close (empty for an IP or abstract socket)
+  };
+  const listen_settings &cfg;
+  std::vector<held_socket> held;
+  std::vector<std::string> env;
+  std::vector<char*> env_ptrs;
+  char *listen_pid{nullptr};           // digits of the LISTEN_PID variable, written by the child
+  int bind_socket(const listen_socket &socket, std::string &unix_path) const;
+public:
+  explicit listen_sockets(const listen_settings &cfg) : cfg{cfg} {}
+  listen_sockets(const listen_sockets &) = delete;
+  listen_sockets& operator=(const listen_sockets &) = delete;
+  ~listen_sockets() { close(); }
+
+  // binds and listens on the configured sockets (once, for all launches); false if one can't be
+  bool open();
+  void close();
+
+  // the environment the child is exec'd with: base plus the LISTEN_* variables; call prior to fork()
+  char* const* envp(char* const* base);
+  // called in the forked child prior to execve(); moves the sockets to fds 3, 4, ... (async-signal-safe)
+  void apply_child() const;
+
+  bool is_active() const { return !held.empty(); }
+};
+
+#endif //__LISTEN_SOCKETS_H__
@@ -0,0 +1,177 @@
+/* live-stats.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "format2str.h"
+#include "path-concat.h"
+#include "log.h"
+#include "live-stats.h"
+
+using namespace logger;
+
+namespace {
+
+  const char stats_magic[8] = "JWDSTAT";
+
+}
+
+const char* to_string(WATCHDOG_STATE state) {
+  switch (state) {
+    case WATCHDOG_STATE::STARTING:   return "starting";
+    case WATCHDOG_STATE::RUNNING:    return "running";
+    case WATCHDOG_STATE::READY:      return "ready";
+    case WATCHDOG_STATE::STOPPING:   return "stopping";
+    case WATCHDOG_STATE::RESTARTING: return "restarting";
+    case WATCHDOG_STATE::EXITED:     return "exited";
+  }
+  return "unknown";
+}
+
+live_stats::live_stats(const stats_settings &cfg) {
+  if (!cfg.enabled) return;
+  owner = getpid();
+  path = path_concat(cfg.dir, format2str("java-watchdog-%d.stats", owner));
+  // the directory is world-writable: a stale file of an earlier watchdog of this pid is removed, and none other
+  // (nor a planted symlink) is ever opened
+  unlink(path.c_str());
+  const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+  if (fd == -1 || ftruncate(fd, sizeof(live_stats_region)) != 0) {
+    log(LL::WARN, "could not create stats file \"%s\" - stats are not published: %s", path.c_str(), strerror(errno));
+    if (fd != -1) {
+      close(fd);
+      unlink(path.c_str());
+    }
+    return;
+  }
+  void * const addr = mmap(nullptr, sizeof(live_stats_region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    log(LL::WARN, "could not map stats file \"%s\" - stats are not published: %s", path.c_str(), strerror(errno));
+    unlink(path.c_str());
+    return;
+  }
+  region = new (addr) live_stats_region{};
+  region->version = live_stats_region::current_version;
+  region->size = sizeof(live_stats_region);
+  region->metric_count = (uint32_t) metric_count;
+  for (size_t i = 0; i < metric_count; i++) {
+    strncpy(region->metric_names[i], metric_names[i].data(), std::min(metric_names[i].size(), (size_t) 31));
+  }
+  data.watchdog_pid = owner;
+  data.last_exit_status = -1;
+  data.started_ms = wall_clock_ms();
+  publish();
+  // readers go by the magic, so it marks the header as complete
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(region->magic, stats_magic, sizeof(stats_magic));
+  log(LL::DEBUG, "publishing stats in \"%s\"", path.c_str());
+}
+
+live_stats::~live_stats() {
+  if (region == nullptr) return;
+  // (a forked child that failed to exec must leave the watchdog's file alone)
+  if (getpid() == owner) unlink(path.c_str());
+  munmap(region, sizeof(live_stats_region));
+}
+
+void live_stats::publish() {
+  const auto seq = region->seq.load(std::memory_order_relaxed);
+  region->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(&region->data, &data, sizeof(data));
+  region->seq.store(seq + 2, std::memory_order_release);
+}
+
+void live_stats::on_launch(pid_t child_pid, unsigned restarts) {
+  if (region == nullptr) return;
+  data.child_pid = child_pid;
+  data.restarts = restarts;
+  data.child_started_ms = wall_clock_ms();
+  data.state = WATCHDOG_STATE::RUNNING;
+  publish();
+}
+
+void live_stats::on_exit(int status) {
+  if (region == nullptr) return;
+  data.last_exit_status = status;
+  data.state = WATCHDOG_STATE::EXITED;
+  publish();
+}
+
+void live_stats::set_state(WATCHDOG_STATE state) {
+  // readiness only ever follows running (not a shutdown already under way)
+  if (region == nullptr || data.state == state ||
+      (state == WATCHDOG_STATE::READY && data.state != WATCHDOG_STATE::RUNNING)) {
+    return;
+  }
+  data.state = state;
+  publish();
+}
+
+void live_stats::set_metrics(const metric_values &values) {
+  if (region == nullptr) return;
+  data.sampled_ms = wall_clock_ms();
+  data.samples++;
+  memcpy(data.metrics, values.data(), sizeof(double) * metric_count);
+  publish();
+}
+
+bool live_stats::read(const std::string &path, live_stats_snapshot &snapshot) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return false;
+  struct stat statbuf{};
+  if (fstat(fd, &statbuf) != 0 || (size_t) statbuf.st_size < sizeof(live_stats_region)) {
+    close(fd);
+    return false;
+  }
+  void * const addr = mmap(nullptr, sizeof(live_stats_region), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) return false;
+  const auto * const region = static_cast<const live_stats_region*>(addr);
+
+  bool is_read = memcmp(region->magic, stats_magic, sizeof(stats_magic)) == 0 &&
+                 region->version == live_stats_region::current_version && region->size == sizeof(live_stats_region);
+  if (is_read) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    snapshot.metric_names.clear();
+    for (uint32_t i = 0; i < std::min<uint32_t>(region->metric_count, 32); i++) {
+      snapshot.metric_names.emplace_back(region->metric_names[i], strnlen(region->metric_names[i], 32));
+    }
+    is_read = false;
+    for (int tries = 0; tries < 10000 && !is_read; tries++) {
+      const auto seq = region->seq.load(std::memory_order_acquire);
+      if ((seq & 1) != 0) {
+        sched_yield(); // a write is under way
+        continue;
+      }
+      memcpy(&snapshot.data, &region->data, sizeof(snapshot.data));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      is_read = region->seq.load(std::memory_order_relaxed) == seq;
+    }
+  }
+  munmap(addr, sizeof(live_stats_region));
+  return is_read;
+}
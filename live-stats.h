@@ -0,0 +1,124 @@
+/* live-stats.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __LIVE_STATS_H__
+#define __LIVE_STATS_H__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "settings.h"
+#include "proc-stats.h"
+
+// what the watchdog is doing (the state field of the stats region)
+enum class WATCHDOG_STATE : uint32_t {
+  STARTING = 0,   // preparing the launch of the child
+  RUNNING,        // the child is running
+  READY,          // the child is running and passed the readiness check
+  STOPPING,       // a shutdown signal was forwarded to the child
+  RESTARTING,     // the child terminated and is launched anew
+  EXITED,         // the child terminated for good
+};
+
+const char* to_string(WATCHDOG_STATE state);
+
+// the variable part of the stats region, written under the seqlock
+struct live_stats_data {
+  int32_t watchdog_pid;
+  int32_t child_pid;
+  WATCHDOG_STATE state;
+  uint32_t restarts;
+  int32_t last_exit_status;     // waitpid() status of the last child to terminate (-1 if none has)
+  uint32_t reserved;
+  int64_t started_ms;           // wall clock time of the watchdog's start
+  int64_t child_started_ms;     // wall clock time of the current child's launch
+  int64_t sampled_ms;           // wall clock time of the metrics sample (zero if none yet)
+  uint64_t samples;
+  double metrics[32];           // in the order of the header's metric names
+};
+
+/**
+ * The fixed layout of a stats file: a header written once at creation, then
+ * the data guarded by a seqlock. The version is bumped on any layout change.
+ * <p>
+ * Readers map the file read-only and copy the data out, retrying while the
+ * sequence number is odd (a write is in progress) or changed during the copy.
+ * Reading costs no syscalls and never blocks or slows the watchdog.
+ */
+struct live_stats_region {
+  static const uint32_t current_version = 1;
+  char magic[8];                // "JWDSTAT"
+  uint32_t version;
+  uint32_t size;                // of the whole region
+  uint32_t metric_count;
+  uint32_t reserved;
+  char metric_names[32][32];
+  alignas(64) std::atomic<uint64_t> seq;
+  alignas(64) live_stats_data data;
+};
+
+// a consistent copy of a stats region
+struct live_stats_snapshot {
+  std::vector<std::string> metric_names;
+  live_stats_data data;
+};
+
+static_assert(metric_count <= sizeof(live_stats_data::metrics) / sizeof(double), "stats region metrics too small");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock must be lock free to live in shared memory");
+
+/**
+ * Publishes the state of the watchdog and the sampled metrics of its child in
+ * a shared memory file (java-watchdog-<pid>.stats in the [stats] directory),
+ * so monitoring agents can poll it at any rate without a syscall into the
+ * watchdog. The file is removed when the watchdog exits.
+ */
+class live_stats {
+private:
+  live_stats_region *region{nullptr};
+  std::string path;
+  pid_t owner{0};
+  live_stats_data data{};       // the last published data (the watchdog is its only writer)
+  void publish();
+public:
+  explicit live_stats(const stats_settings &cfg);
+  live_stats(const live_stats &) = delete;
+  live_stats& operator=(const live_stats &) = delete;
+  ~live_stats();
+
+  // a child was launched (restarts is the count of launches before it)
+  void on_launch(pid_t child_pid, unsigned restarts);
+  // the child terminated (per its waitpid() status)
+  void on_exit(int status);
+  void set_state(WATCHDOG_STATE state);
+  void set_metrics(const metric_values &values);
+  bool is_enabled() const { return region != nullptr; }
+
+  /**
+   * Reads a consistent snapshot of a stats file without blocking its writer.
+   *
+   * @param path the stats file
+   * @param snapshot receives the metric names and the data
+   * @return false if the file is not a stats file of this version
+   */
+  static bool read(const std::string &path, live_stats_snapshot &snapshot);
+};
+
+#endif //__LIVE_STATS_H__
@@ -44,10 +44,12 @@ namespace logger {
       openlog(ident.data(), LOG_PID, LOG_DAEMON);
     }
   };
-  using call_syslog_t = std::function<void(const std::string_view, const std::string_view)>;
-  static call_syslog_t s_syslog = [](const std::string_view level, const std::string_view msg) {
+  using call_syslog_t = std::function<void(LOGGING_LEVEL, const std::string_view, const std::string_view)>;
+  static call_syslog_t s_syslog = [](LOGGING_LEVEL, const std::string_view level, const std::string_view msg) {
     syslog(LOG_ERR, "%s: %s", level.data(), msg.data());
   };
+  static LOGGING_LEVEL s_syslog_level = LL::ERR;
+  static std::function<void()> s_syslog_flush = []() {};
 
   // NOTE: this property must be set on the logger namespace subsystem prior to use of its functions
   void set_progname(const std::string_view progname) {
@@ -63,10 +65,24 @@ namespace logger {
     s_call_openlog(tmp_prg_name, is_syslogging_enabled);
     s_call_openlog = [](const std::string_view ident, bool is_enabled) {};
     if (!is_syslogging_enabled) {
-      s_syslog = [](const std::string_view, const std::string_view) {};
+      s_syslog = [](LOGGING_LEVEL, const std::string_view, const std::string_view) {};
+      s_syslog_flush = []() {};
     }
   }
 
+  void set_syslog_sink(LOGGING_LEVEL min_level, syslog_sink_t sink, std::function<void()> flush) {
+    closelog();
+    s_syslog_level = min_level;
+    s_syslog = [sink = std::move(sink)](LOGGING_LEVEL level, const std::string_view, const std::string_view msg) {
+      sink(level, msg);
+    };
+    s_syslog_flush = std::move(flush);
+  }
+
+  void flush_syslog() {
+    s_syslog_flush();
+  }
+
   LOGGING_LEVEL get_level() { return loggingLevel; }
 
   // trim from start
@@ -115,33 +131,34 @@ namespace logger {
 
     auto stream = stdout;
     std::string_view level_str = ": ";
-    call_syslog_t syslog_it = [](const std::string_view, const std::string_view) {};
     std::string_view syslog_level = "";
     switch (level) {
       case LL::FATAL:
         level_str = ": FATAL: ";
         stream = stderr;
-        syslog_it = s_syslog;
         syslog_level = "FATAL";
         break;
       case LL::ERR:
         level_str = ": ERROR: ";
         stream = stderr;
-        syslog_it = s_syslog;
         syslog_level = "ERROR";
         break;
       case LL::WARN:
         level_str = ": WARN: ";
         stream = stderr;
+        syslog_level = "WARN";
         break;
       case LL::INFO:
         level_str = ": INFO: ";
+        syslog_level = "INFO";
         break;
       case LL::DEBUG:
         level_str = ": DEBUG: ";
+        syslog_level = "DEBUG";
         break;
       case LL::TRACE:
         level_str = ": TRACE: ";
+        syslog_level = "TRACE";
         break;
     }
 
@@ -173,7 +190,9 @@ namespace logger {
     strbuf[n++] = CNEWLINE;
     strbuf[n] = CNULLTRM;
     fputs(strbuf, stream);
-    syslog_it(syslog_level, strbuf + len);
+    if ((char) level >= (char) s_syslog_level) {
+      s_syslog(level, syslog_level, strbuf + len);
+    }
   }
 
   void log(LOGGING_LEVEL level, const std::string_view fmt, ...) {
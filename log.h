@@ -20,6 +20,8 @@ limitations under the License.
 #define __LOG_H__
 
 #include <cstdarg>
+#include <functional>
+#include <string_view>
 
 namespace logger {
 
@@ -38,6 +40,11 @@ namespace logger {
   void set_progname(const std::string_view progname);
 
   void set_syslogging(bool is_syslogging_enabled);
+  // replaces the libc syslog() call made for ERR and FATAL lines with a sink taking lines of min_level and above
+  using syslog_sink_t = std::function<void(LOGGING_LEVEL level, const std::string_view msg)>;
+  void set_syslog_sink(LOGGING_LEVEL min_level, syslog_sink_t sink, std::function<void()> flush);
+  // sends on whatever lines a batching syslog sink is holding
+  void flush_syslog();
   LOGGING_LEVEL get_level();
   inline bool is_debug_level() { return get_level() == LL::DEBUG; }
   inline bool is_trace_level() { return get_level() == LL::TRACE; }
@@ -19,14 +19,22 @@ limitations under the License.
 */
 #include <string_view>
 #include <cstring>
-#include <sys/file.h>
+#include <dirent.h>
 #include <sys/stat.h>
-#include <sys/wait.h>
-#include <popt.h>
 #include "decl-exception.h"
 #include "format2str.h"
 #include "path-concat.h"
 #include "cfgparse.h"
+#include "program-path.h"
+#include "settings.h"
+#include "proc-stats.h"
+#include "tsdb.h"
+#include "proc-tree.h"
+#include "control.h"
+#include "live-stats.h"
+#include "syslog-transport.h"
+#include "supervisor.h"
+#include "trace.h"
 #include "log.h"
 
 //#undef NDEBUG // uncomment this line to enable asserts in use below
@@ -38,8 +46,6 @@ void __assert (const char *__assertion, const char *__file, int __line) __THROW
 using namespace logger;
 using std::string_view_literals::operator ""sv;
 
-DECL_EXCEPTION(find_program_path)
-
 static int s_parent_thrd_pid = 0;
 static const auto cfg_file_name = "config.ini"sv;
 static std::string_view s_progpath;
@@ -48,18 +54,6 @@ inline int get_parent_pid() { return s_parent_thrd_pid; }
 const char* progpath() { return s_progpath.data(); }
 const std::string_view progname() { return s_progname; }
 
-enum class ACCEPT_ORDINAL : char {
-  FIRST_FOUND = 0,
-  SECOND_FOUND,
-  THIRD_FOUND,
-  FOURTH_FOUND,
-  FIFTH_FOUND,
-  SIXTH_FOUND,
-  SEVENTH_FOUND,
-  LAST_FOUND = -1,
-};
-using AO = ACCEPT_ORDINAL;
-
 /**
  * Returns the value string of a specified environment variable.
  *
@@ -71,84 +65,6 @@ static std::string get_env_var(const char * const name) {
   return val != nullptr ? std::string(val) : std::string();
 }
 
-/**
- * Searches a specified environment variable (typically PATH), where assumes are
- * directory paths seperated by the platform path separator character (e.g., ':').
- * Looks for occurrence of the specified program. An ACCEPT_ORDINAL parameter is
- * used to specify which occurrence to accept and return as the function's result.
- *
- * @param prog the program to search for
- * @param path_var_name the environment path variable to search the directories of
- * @param ao the ordinal sequence of any found occurrences of prog to be returned
- * @return a found occurrence of prog; throws an exception if none found
- */
-static std::string find_program_path(const char * const prog, const char * const path_var_name, ACCEPT_ORDINAL ao) {
-  const std::string path_env_var = get_env_var(path_var_name);
-
-  if (path_env_var.empty()) {
-    const char * const err_msg_fmt = "there is no %s environment variable defined";
-    throw find_program_path_exception(format2str(err_msg_fmt, path_var_name));
-  }
-
-  const char * const path_env_var_dup = strdupa(path_env_var.c_str());
-
-  static const char * const delim = ":";
-  char *save = nullptr;
-  const char * path = strtok_r(const_cast<char*>(path_env_var_dup), delim, &save);
-
-  std::string last_found_valid_path;
-
-  for (int i = 0; path != nullptr;) {
-    log(LL::TRACE, "'%s'", path);
-    const std::string_view sv_path{path};
-    const auto full_path = sv_path.back() == kPathSeparator ?
-        format2str("%s%s", path, prog) : format2str("%s%c%s", path, kPathSeparator, prog);
-    log(LL::TRACE, "'%s'", full_path.c_str());
-    // check to see if program file path exist
-    struct stat statbuf{0};
-    if (stat(full_path.c_str(), &statbuf) != -1 &&
-        ((statbuf.st_mode & S_IFMT) == S_IFREG || (statbuf.st_mode & S_IFMT) == S_IFLNK))
-    {
-      last_found_valid_path = full_path;
-      log(LL::DEBUG, "'%s'", last_found_valid_path.c_str());
-      bool matches_ao = false;
-      switch(++i) {
-        case 1:
-          matches_ao = ao == AO::FIRST_FOUND;
-          break;
-        case 2:
-          matches_ao = ao == AO::SECOND_FOUND;
-          break;
-        case 3:
-          matches_ao = ao == AO::THIRD_FOUND;
-          break;
-        case 4:
-          matches_ao = ao == AO::FOURTH_FOUND;
-          break;
-        case 5:
-          matches_ao = ao == AO::FIFTH_FOUND;
-          break;
-        case 6:
-          matches_ao = ao == AO::SIXTH_FOUND;
-          break;
-        case 7:
-          matches_ao = ao == AO::SEVENTH_FOUND;
-          break;
-      }
-      if (matches_ao) {
-        return last_found_valid_path;
-      }
-    }
-    path = strtok_r(nullptr, delim, &save);
-    if (ao == AO::LAST_FOUND && path == nullptr) {
-      return last_found_valid_path;
-    }
-  }
-
-  const char * const err_msg_fmt = "could not locate program '%s' via %s environment variable";
-  throw find_program_path_exception(format2str(err_msg_fmt, prog, path_var_name));
-}
-
 /**
  * Looks for 'config.ini' file in three different locations (in order of precedence):
  * <p>
@@ -163,6 +79,7 @@ static std::string find_program_path(const char * const prog, const char * const
  * @return the full file path of a found 'config.ini' or else an empty string if not found
  */
 static std::string locate_cfg_file() {
+  trace::span span{"locate_cfg_file"};
   std::string dir;
   std::string cfg_file_path;
   struct stat statbuf{};
@@ -241,6 +158,88 @@ static void one_time_init_main(int argc, const char *argv[])
 }
 #pragma clang diagnostic pop
 
+/**
+ * Decodes a postmortem metrics file, writing its samples as CSV to stdout.
+ *
+ * @param path file path of a metrics file written on a child process crash
+ * @return process completion status code
+ */
+static int decode_metrics(const char * const path) {
+  try {
+    size_t series_count = 0;
+    metric_ring::decode_file(path,
+      [&series_count](const std::vector<std::string> &names) {
+        series_count = names.size();
+        printf("timestamp_ms");
+        for (const auto &name : names) {
+          printf(",%s", name.c_str());
+        }
+        printf("\n");
+      },
+      [&series_count](int64_t ts_ms, const double *values) {
+        printf("%ld", (long) ts_ms);
+        for (size_t i = 0; i < series_count; i++) {
+          printf(",%.6g", values[i]);
+        }
+        printf("\n");
+      });
+  } catch(const tsdb_exception &ex) {
+    log(LL::ERR, "%s: %s", ex.name(), ex.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Prints the live stats of running watchdogs, as a JSON line per watchdog, to stdout.
+ *
+ * @param target a watchdog pid or stats file path; nullptr for every watchdog publishing to the default directory
+ * @return process completion status code
+ */
+static int print_stats(const char * const target) {
+  std::vector<std::string> paths;
+  const stats_settings stats_defaults;
+  if (target == nullptr) {
+    DIR * const dir = opendir(stats_defaults.dir.c_str());
+    if (dir != nullptr) {
+      for (const struct dirent *entry; (entry = readdir(dir)) != nullptr;) {
+        const std::string_view name{entry->d_name};
+        if (name.compare(0, 14, "java-watchdog-") == 0 && name.size() > 20 && name.substr(name.size() - 6) == ".stats") {
+          paths.push_back(path_concat(stats_defaults.dir, entry->d_name));
+        }
+      }
+      closedir(dir);
+    }
+  } else if (strchr(target, '/') == nullptr && strtol(target, nullptr, 10) > 0) {
+    paths.push_back(path_concat(stats_defaults.dir, format2str("java-watchdog-%s.stats", target)));
+  } else {
+    paths.emplace_back(target);
+  }
+
+  int rtn = target == nullptr ? EXIT_SUCCESS : EXIT_FAILURE;
+  live_stats_snapshot snapshot;
+  for (const auto &path : paths) {
+    if (!live_stats::read(path, snapshot)) {
+      if (target != nullptr) log(LL::ERR, "no watchdog stats could be read from \"%s\"", path.c_str());
+      continue;
+    }
+    const auto &data = snapshot.data;
+    // a watchdog killed outright leaves its file behind
+    const bool is_alive = kill(data.watchdog_pid, 0) == 0 || errno == EPERM;
+    printf("{\"file\":\"%s\",\"watchdog_pid\":%d,\"alive\":%s,\"state\":\"%s\",\"child_pid\":%d,\"restarts\":%u,"
+           "\"last_exit_status\":%d,\"started_ms\":%ld,\"child_started_ms\":%ld,\"sampled_ms\":%ld,\"samples\":%lu",
+           path.c_str(), data.watchdog_pid, is_alive ? "true" : "false", to_string(data.state), data.child_pid,
+           data.restarts, data.last_exit_status, (long) data.started_ms, (long) data.child_started_ms,
+           (long) data.sampled_ms, (unsigned long) data.samples);
+    for (size_t i = 0; i < snapshot.metric_names.size(); i++) {
+      printf(",\"%s\":%.6g", snapshot.metric_names[i].c_str(), data.metrics[i]);
+    }
+    printf("}\n");
+    rtn = EXIT_SUCCESS;
+  }
+  return rtn;
+}
+
 /**
  * Determines any runtime options as supplied in a 'config.ini' file, then
  * proceeds to fork a child process where a found, standard java launcher
@@ -263,17 +262,42 @@ static void one_time_init_main(int argc, const char *argv[])
  * @return process completion status code (zero indicates successful completion)
  */
 int main(int argc, const char *argv[]) {
+  if (argc == 3 && strcmp(argv[1], "--decode-metrics") == 0) {
+    set_level(LL::ERR); // stdout is reserved for the decoded CSV output
+    one_time_init_main(argc, argv);
+    return decode_metrics(argv[2]);
+  }
+  if ((argc == 2 || argc == 3) && strcmp(argv[1], "--stat") == 0) {
+    set_level(LL::ERR); // stdout is reserved for the stats output
+    one_time_init_main(argc, argv);
+    return print_stats(argc == 3 ? argv[2] : nullptr);
+  }
+  if (argc >= 4 && strcmp(argv[1], "--control") == 0) {
+    set_level(LL::ERR); // stdout is reserved for the reply
+    one_time_init_main(argc, argv);
+    return control_client(argv[2], argc - 3, argv + 3);
+  }
+
   set_level(LL::TRACE); // comment out this line to disable debug/trace logging verbosity
   one_time_init_main(argc, argv);
 
+  // tracing from the environment covers the config lookup and processing too
+  const auto trace_env = get_env_var("JAVA_WATCHDOG_TRACE");
+  if (!trace_env.empty() && trace_env != "0") {
+    const trace_settings trace_defaults;
+    trace::start(trace_env == "1" ? trace_defaults.file : trace_env, trace_defaults.buffer_events);
+  }
+
   // initialized to default settings
   LOGGING_LEVEL logging_level = LL::INFO;
   ACCEPT_ORDINAL accept_ordinal = AO::FIRST_FOUND;
+  watchdog_settings cfg;
 
   const auto cfg_file_path = locate_cfg_file();
   if (!cfg_file_path.empty()) {
     auto prs_cfg_callback =
-        [&logging_level, &accept_ordinal](const std::string_view section, const std::string_view name, const std::string_view value)
+        [&logging_level, &accept_ordinal, &cfg]
+        (const std::string_view section, const std::string_view name, const std::string_view value)
         {
           const auto to_lower = [](std::string &str) {
             transform(str.begin(), str.end(), str.begin(), ::tolower);
@@ -299,7 +323,7 @@ int main(int argc, const char *argv[]) {
                 logging_level = LL::ERR;
               } else {
                 logging_level = LL::INFO;
-                log(LL::WARN, "logging level '%s' not recognized - defaulting to INFO", value);
+                log(LL::WARN, "logging level '%s' not recognized - defaulting to INFO", s_value.c_str());
               }
             } else if (s_name.compare("accept_ordinal") == 0) {
               if (s_value.compare("first_found") == 0) {
@@ -321,13 +345,17 @@ int main(int argc, const char *argv[]) {
               } else {
                 accept_ordinal = AO::FIRST_FOUND;
                 log(LL::WARN, "unrecognized settings section %s value '%s' - defaulting to FIRST_FOUND",
-                    name, value);
+                    s_name.c_str(), s_value.c_str());
               }
             } else {
-              log(LL::WARN, "unrecognized settings section name '%s' ignored", name);
+              log(LL::WARN, "unrecognized settings section name '%s' ignored", s_name.c_str());
             }
           } else {
-            log(LL::WARN, "unrecognized config section '%s' ignored", section);
+            std::string s_name{name};
+            to_lower(s_name);
+            if (!parse_section_setting(s_section, s_name, value, cfg)) {
+              log(LL::WARN, "unrecognized config section '%s' name '%s' ignored", s_section.c_str(), s_name.c_str());
+            }
           }
           return EXIT_FAILURE;
         };
@@ -337,92 +365,70 @@ int main(int argc, const char *argv[]) {
         // reset to defaults
         logging_level = LL::INFO;
         accept_ordinal = AO::FIRST_FOUND;
+        cfg = watchdog_settings{};
       }
     } catch(const process_cfg_exception &ex) {
       // reset to defaults
       logging_level = LL::INFO;
       accept_ordinal = AO::FIRST_FOUND;
+      cfg = watchdog_settings{};
       log(LL::WARN, "failed processing config file - using default settings:\n\t%s: %s", ex.name(), ex.what());
     }
   }
 
   set_level(logging_level);
 
-  // determine the path to the Java launcher program by
-  // searching the PATH environment variable path string
-  std::string java_prog_path;
-  try {
-    // determine fully qualified path to the program
-    java_prog_path = find_program_path("java", "PATH", accept_ordinal);
-  } catch(const find_program_path_exception &ex) {
-    log(LL::ERR, "could not locate a Java launcher program:\n\t%s: %s", ex.name(), ex.what());
-    return EXIT_FAILURE;
+  // (when enabled by config only, the trace starts here; the environment variable covers config processing too)
+  if (cfg.trace.enabled && !trace::enabled()) {
+    trace::start(cfg.trace.file, cfg.trace.buffer_events);
   }
-  log(LL::DEBUG, "Java launcher program: \"%s\"", java_prog_path.c_str());
 
-  // will use argc_arg and argv_arg in execv() call
-  int argc_arg = 0;
-  const char **argv_arg = nullptr;
-  {
-    // duplicate the current argv array
-    int rtn = poptDupArgv(argc, argv, &argc_arg, &argv_arg);
-    if (rtn != 0) {
-      const char *const errmsg = poptStrerror(rtn);
-      log(LL::ERR, "parent pid(%d) failed parsing command line args:\n\t%s", getpid(), errmsg);
-      return EXIT_FAILURE;
-    }
-    // replace first argv entry of program path with path to the java launcher executable
-    argv_arg[0] = strdup(java_prog_path.c_str());
-    if (is_debug_level()) {
-      log(LL::DEBUG, "'%s' ppid(%d); pid(%d):\n\targc: %d ; first arg: '%s', second arg: '%s'",
-          argv[0], getppid(), getpid(), argc_arg, argv_arg[0], argv_arg[1]);
-    }
+  // the native syslog transport takes over from libc syslog() for the remainder of the program
+  if (!cfg.syslog.enabled) {
+    set_syslogging(false);
+  } else {
+    static syslog_transport *syslog_sink = nullptr;
+    syslog_sink = new syslog_transport(cfg.syslog, progname());
+    set_syslog_sink(cfg.syslog.level,
+                    [](LOGGING_LEVEL level, const std::string_view msg) { syslog_sink->send(level, msg); },
+                    []() { syslog_sink->flush(); });
+    atexit([]() {
+      set_syslogging(false);
+      delete syslog_sink; // sends any pending repeat count and queued messages
+    });
   }
 
-  const pid_t pid = fork();
-  if (pid == -1) {
-    log(LL::ERR, "pid(%d): fork() of Java main() entry point failed: %s", getpid(), strerror(errno));
-    return EXIT_FAILURE;
-  } else if (pid == 0) {
-    // child process
-    if (is_debug_level()) {
-      log(LL::DEBUG, "pid(%d): argc: %d ; first arg: '%s', second arg: '%s'",
-          getpid(), argc_arg, argv_arg[0], argv_arg[1]);
-    }
-    // this forked child process will now become the found java launcher program
-    // (the supplied command line arguments will now be applied to the java launcher)
-    int rc = execv(java_prog_path.c_str(), (char**) argv_arg);
-    if (rc == -1) {
-      log(LL::ERR, "pid(%d): failed to exec '%s': %s", getpid(), java_prog_path.c_str(), strerror(errno));
-      return EXIT_FAILURE;
-    }
-  } else {
-    // free the heap-duplicated command line args (not needed in the parent process)
-    free((void*) argv_arg[0]);
-    argv_arg[0] = nullptr;
-    free(argv_arg); // was heap-allocated via poptDupArgv() above, prior to fork() call
-
-    // now wait on the child process pid (the java launcher program)
-    int status = 0;
-    do {
-      if (waitpid(pid, &status, 0) == -1) {
-        log(LL::ERR, "failed waiting for forked launcher child process (pid:%d): %s",
-            getpid(), strerror(errno));
-        return EXIT_FAILURE;
-      }
-      if (WIFSIGNALED(status) || WIFSTOPPED(status)) {
-        log(LL::ERR, "interrupted waiting for forked launcher child process (pid:%d)", pid);
-        return EXIT_FAILURE;
-      }
-    } while (!WIFEXITED(status) && !WIFSIGNALED(status));
+  if (cfg.process_tree.subreaper) {
+    become_subreaper();
+  }
 
-    log(LL::DEBUG, "%s(): **** fork/exec Java launcher child process (pid:%d) for '%s'; exit status: %d ****",
-        __FUNCTION__, pid, java_prog_path.c_str(), status);
+  // the JVM of the command line runs alone or, with [process.NAME] sections, as process "main" among theirs
+  process_settings main_jvm;
+  main_jvm.name = "main";
+  main_jvm.args.assign(argv + 1, argv + argc);
+  main_jvm.ordinal = (int) accept_ordinal;
+  main_jvm.restart = RESTART_POLICY::NEVER;
+  main_jvm.required = true;
+  std::vector<process_settings> single_jvm;
+  if (cfg.processes.empty()) {
+    single_jvm.push_back(std::move(main_jvm));
+  } else if (argc > 1) {
+    cfg.processes.insert(cfg.processes.begin(), std::move(main_jvm));
+  }
+  const auto &processes = cfg.processes.empty() ? single_jvm : cfg.processes;
 
-    if (status != 0) {
+  process_supervisor supervisor(cfg);
+  for (const auto &process : processes) {
+    try {
+      // determine fully qualified path to the java launcher program by searching the PATH environment variable
+      const auto java_prog_path = find_program_path("java", "PATH", (ACCEPT_ORDINAL) process.ordinal);
+      log(LL::DEBUG, "Java launcher program of JVM \"%s\": \"%s\"", process.name.c_str(), java_prog_path.c_str());
+      supervisor.add(process, java_prog_path);
+    } catch(const find_program_path_exception &ex) {
+      log(LL::ERR, "could not locate a Java launcher program for JVM \"%s\":\n\t%s: %s", process.name.c_str(),
+          ex.name(), ex.what());
       return EXIT_FAILURE;
     }
   }
-
-  return EXIT_SUCCESS;
-}
\ No newline at end of file
+  return supervisor.run();
+}
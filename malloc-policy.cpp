@@ -0,0 +1,278 @@
+/* malloc-policy.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <sched.h>
+#include <unistd.h>
+#include "cgroup.h"
+#include "format2str.h"
+#include "log.h"
+#include "path-concat.h"
+#include "malloc-policy.h"
+
+extern char **environ;
+
+using namespace logger;
+
+namespace {
+
+  const char * const lib_dirs[] = {
+      "/usr/lib/x86_64-linux-gnu", "/usr/lib/aarch64-linux-gnu", "/usr/lib64", "/usr/lib", "/usr/local/lib",
+  };
+  const char * const jemalloc_libs[] = { "libjemalloc.so.2", "libjemalloc.so" };
+  const char * const tcmalloc_libs[] = { "libtcmalloc_minimal.so.4", "libtcmalloc.so.4" };
+
+  template<size_t N>
+  std::string find_library(const char * const (&names)[N]) {
+    for (const char *dir : lib_dirs) {
+      for (const char *name : names) {
+        auto path = path_concat(dir, name);
+        if (access(path.c_str(), R_OK) == 0) return path;
+      }
+    }
+    return std::string();
+  }
+
+  // number of CPUs of a cpu list such as "0-3,8,10-11"
+  int count_cpu_list(const std::string &list) {
+    int count = 0;
+    for (const char *p = list.c_str(); *p != '\0';) {
+      char *end = nullptr;
+      const long first = strtol(p, &end, 10);
+      if (end == p) break;
+      long last = first;
+      if (*end == '-') {
+        p = end + 1;
+        last = strtol(p, &end, 10);
+      }
+      count += (int) (last - first + 1);
+      p = *end == ',' ? end + 1 : end;
+    }
+    return count;
+  }
+
+  std::string json_escape(const std::string &str) {
+    std::string escaped;
+    for (const char c : str) {
+      if (c == '"' || c == '\\') escaped += '\\';
+      if ((unsigned char) c >= 0x20) escaped += c;
+    }
+    return escaped;
+  }
+
+  // a "name":"value" or "name":number field of a report line
+  std::string json_field(const std::string &line, const std::string &name) {
+    const auto key = "\"" + name + "\":";
+    auto pos = line.find(key);
+    if (pos == std::string::npos) return std::string();
+    pos += key.size();
+    if (line[pos] == '"') {
+      const auto end = line.find('"', pos + 1);
+      return line.substr(pos + 1, end == std::string::npos ? std::string::npos : end - pos - 1);
+    }
+    return line.substr(pos, line.find_first_of(",}", pos) - pos);
+  }
+
+}
+
+uint64_t memory_limit_bytes() {
+  const auto v2 = cgroup::v2_file("memory.max");
+  if (!v2.empty()) {
+    const auto str = cgroup::read_file(v2);
+    return str.compare(0, 3, "max") == 0 ? 0 : strtoull(str.c_str(), nullptr, 10);
+  }
+  const auto v1 = cgroup::v1_dir("memory");
+  if (v1.empty()) return 0;
+  const auto limit = strtoull(cgroup::read_file(path_concat(v1, "memory.limit_in_bytes")).c_str(), nullptr, 10);
+  return limit >= (1ULL << 62) ? 0 : limit; // the v1 way of saying unlimited
+}
+
+double effective_cpus(const std::string &bound_cpus) {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  double cpus = !bound_cpus.empty() ? count_cpu_list(bound_cpus) :
+                sched_getaffinity(0, sizeof(allowed), &allowed) == 0 ? CPU_COUNT(&allowed) : 1;
+  double quota = 0.0;
+  const auto v2 = cgroup::v2_file("cpu.max");
+  if (!v2.empty()) {
+    // "<quota> <period>" or "max <period>"
+    const auto str = cgroup::read_file(v2);
+    if (str.compare(0, 3, "max") != 0) {
+      char *end = nullptr;
+      const double q = strtod(str.c_str(), &end);
+      const double period = strtod(end, nullptr);
+      if (q > 0 && period > 0) quota = q / period;
+    }
+  } else {
+    const auto v1 = cgroup::v1_dir("cpu");
+    if (!v1.empty()) {
+      const double q = strtod(cgroup::read_file(path_concat(v1, "cpu.cfs_quota_us")).c_str(), nullptr);
+      const double period = strtod(cgroup::read_file(path_concat(v1, "cpu.cfs_period_us")).c_str(), nullptr);
+      if (q > 0 && period > 0) quota = q / period;
+    }
+  }
+  if (quota > 0.0 && quota < cpus) cpus = quota;
+  return cpus > 0.0 ? cpus : 1.0;
+}
+
+void malloc_policy::set_env(const std::string &name, const std::string &value, bool is_merged) {
+  const auto prefix = name + "=";
+  const auto it = std::find_if(env.begin(), env.end(), [&prefix](const std::string &var) {
+    return var.compare(0, prefix.size(), prefix) == 0;
+  });
+  if (it == env.end()) {
+    env.push_back(prefix + value);
+    return;
+  }
+  if (!is_merged) return; // set by the user, who knows best
+  if (name == "LD_PRELOAD") {
+    if (it->find(value) == std::string::npos) *it = prefix + value + ":" + it->substr(prefix.size());
+    return;
+  }
+  // GLIBC_TUNABLES: adds the tunables the user has not set
+  std::string merged = it->substr(prefix.size());
+  size_t pos = 0;
+  while (pos < value.size()) {
+    auto colon = value.find(':', pos);
+    if (colon == std::string::npos) colon = value.size();
+    const auto tunable = value.substr(pos, colon - pos);
+    const auto tunable_name = tunable.substr(0, tunable.find('=') + 1);
+    if ((":" + merged).find(":" + tunable_name) == std::string::npos) {
+      merged += (merged.empty() ? "" : ":") + tunable;
+    }
+    pos = colon + 1;
+  }
+  *it = prefix + merged;
+}
+
+void malloc_policy::plan(const std::string &bound_cpus) {
+  if (!cfg.enabled) return;
+  env.clear();
+  for (char **var = environ; *var != nullptr; var++) {
+    env.emplace_back(*var);
+  }
+  cpus = effective_cpus(bound_cpus);
+  memory_limit = memory_limit_bytes();
+  const bool is_small = memory_limit != 0 && memory_limit < (1ULL << 30);
+
+  auto allocator = cfg.allocator;
+  std::string library = cfg.allocator_path;
+  if (!library.empty() && access(library.c_str(), R_OK) != 0) {
+    log(LL::WARN, "malloc allocator_path \"%s\" is not readable - searching the usual locations", library.c_str());
+    library.clear();
+  }
+  if (library.empty() && allocator != ALLOCATOR::GLIBC) {
+    library = find_library(allocator == ALLOCATOR::TCMALLOC ? tcmalloc_libs : jemalloc_libs);
+    if (library.empty()) {
+      if (allocator != ALLOCATOR::AUTO) {
+        log(LL::WARN, "%s not found - the child JVM uses glibc malloc",
+            allocator == ALLOCATOR::TCMALLOC ? "tcmalloc" : "jemalloc");
+      }
+      allocator = ALLOCATOR::GLIBC;
+    }
+  }
+  if (allocator == ALLOCATOR::AUTO) allocator = library.empty() ? ALLOCATOR::GLIBC : ALLOCATOR::JEMALLOC;
+
+  // one arena per effective CPU (2 to 8), the minimum of 2 when memory is tight
+  const int64_t arenas = cfg.arena_max != malloc_settings::value_auto ? cfg.arena_max :
+                         is_small ? 2 : std::max(2L, std::min(8L, (long) std::ceil(cpus)));
+  if (allocator == ALLOCATOR::GLIBC) {
+    description = "glibc";
+    if (arenas > 0) {
+      set_env("MALLOC_ARENA_MAX", std::to_string(arenas));
+      description += format2str(" arena_max=%ld", (long) arenas);
+    }
+    const auto resolve = [this](int64_t value, int64_t auto_value) {
+      return value != malloc_settings::value_auto ? value : memory_limit != 0 ? auto_value : malloc_settings::value_unset;
+    };
+    const int64_t mmap_threshold = resolve(cfg.mmap_threshold, 128 * 1024);
+    const int64_t trim_threshold = resolve(cfg.trim_threshold, memory_limit <= (2ULL << 30) ? 128 * 1024 : 1024 * 1024);
+    std::string tunables;
+    for (const auto &tunable : { std::make_pair("glibc.malloc.mmap_threshold", mmap_threshold),
+                                 std::make_pair("glibc.malloc.trim_threshold", trim_threshold),
+                                 std::make_pair("glibc.malloc.tcache_count", cfg.tcache_count) })
+    {
+      if (tunable.second < 0) continue;
+      tunables += format2str("%s%s=%ld", tunables.empty() ? "" : ":", tunable.first, (long) tunable.second);
+      description += format2str(" %s=%ld", tunable.first + 13, (long) tunable.second);
+    }
+    if (!tunables.empty()) set_env("GLIBC_TUNABLES", tunables, true);
+  } else {
+    set_env("LD_PRELOAD", library, true);
+    description = allocator == ALLOCATOR::TCMALLOC ? "tcmalloc" : "jemalloc";
+    if (allocator == ALLOCATOR::JEMALLOC) {
+      // background purging returns freed memory without waiting on allocation activity
+      const auto conf = arenas > 0 ? format2str("narenas:%ld,background_thread:true", (long) arenas) :
+                                     std::string("background_thread:true");
+      set_env("MALLOC_CONF", conf);
+      description += " " + conf;
+    }
+  }
+  log(LL::INFO, "child native allocator policy: %s (effective CPUs %.1f, memory limit %lu MB)", description.c_str(),
+      cpus, (unsigned long) (memory_limit >> 20));
+}
+
+char* const* malloc_policy::envp() {
+  if (!cfg.enabled) return environ;
+  env_ptrs.clear();
+  for (auto &var : env) {
+    env_ptrs.push_back(var.data());
+  }
+  env_ptrs.push_back(nullptr);
+  return env_ptrs.data();
+}
+
+void malloc_policy::report(pid_t pid, long max_rss_kb, int64_t uptime_ms) const {
+  if (!cfg.enabled) return;
+  // the last launch under some other policy is the one to compare against
+  std::string before;
+  if (!cfg.report_file.empty()) {
+    const auto history = cgroup::read_file(cfg.report_file);
+    size_t end = history.size();
+    while (end > 0 && before.empty()) {
+      const auto eol = history.rfind('\n', end - 1);
+      const auto start = eol == std::string::npos ? 0 : eol + 1;
+      const auto line = history.substr(start, end - start);
+      const auto policy = json_field(line, "policy");
+      if (!policy.empty() && policy != json_escape(description)) {
+        before = format2str("; previous policy %s: peak RSS %ld MB", policy.c_str(),
+                            strtol(json_field(line, "peak_rss_kb").c_str(), nullptr, 10) / 1024);
+      }
+      end = eol == std::string::npos ? 0 : eol;
+    }
+  }
+  log(LL::INFO, "child process (pid:%d) peak RSS %ld MB over %ld s with allocator policy %s%s", pid,
+      max_rss_kb / 1024, (long) (uptime_ms / 1000), description.c_str(), before.c_str());
+  if (cfg.report_file.empty()) return;
+  FILE * const file = fopen(cfg.report_file.c_str(), "ae");
+  if (file == nullptr) {
+    log(LL::WARN, "could not append to malloc report file \"%s\": %s", cfg.report_file.c_str(), strerror(errno));
+    return;
+  }
+  char hostname[256] = "";
+  gethostname(hostname, sizeof(hostname) - 1);
+  fprintf(file, "{\"time\":%ld,\"host\":\"%s\",\"pid\":%d,\"uptime_s\":%ld,\"cpus\":%.2f,\"memory_limit_mb\":%lu,"
+          "\"policy\":\"%s\",\"peak_rss_kb\":%ld}\n", (long) time(nullptr), json_escape(hostname).c_str(), pid,
+          (long) (uptime_ms / 1000), cpus, (unsigned long) (memory_limit >> 20), json_escape(description).c_str(),
+          max_rss_kb);
+  fclose(file);
+}
@@ -0,0 +1,78 @@
+/* malloc-policy.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __MALLOC_POLICY_H__
+#define __MALLOC_POLICY_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "settings.h"
+
+/**
+ * Native allocator policy of the child JVM, applied through the environment
+ * it is exec'd with. glibc creates up to 8 malloc arenas per core, which on a
+ * container confined to a few CPUs of a many-core host bloats RSS for nothing,
+ * so by default the arena count follows the effective CPU quota; with a memory
+ * limit in place, the mmap and trim thresholds are pinned as well (glibc's
+ * dynamic thresholds otherwise grow and retain freed memory). Optionally
+ * jemalloc or tcmalloc is preloaded instead.
+ * <p>
+ * Variables already present in the watchdog's environment win over the
+ * policy (GLIBC_TUNABLES is merged tunable by tunable).
+ * <p>
+ * Each launch's peak RSS is reported along with the policy it ran under, so
+ * launches under different policies can be compared.
+ */
+class malloc_policy {
+private:
+  const malloc_settings &cfg;
+  std::vector<std::string> env;
+  std::vector<char*> env_ptrs;
+  std::string description{"default"};
+  double cpus{0.0};
+  uint64_t memory_limit{0};
+  void set_env(const std::string &name, const std::string &value, bool is_merged = false);
+public:
+  explicit malloc_policy(const malloc_settings &cfg) : cfg{cfg} {}
+  malloc_policy(const malloc_policy &) = delete;
+  malloc_policy& operator=(const malloc_policy &) = delete;
+
+  /**
+   * Computes the policy and the child environment; call prior to fork().
+   *
+   * @param bound_cpus the CPU list the child is bound to (e.g. "0-3,8") or empty if unbound
+   */
+  void plan(const std::string &bound_cpus);
+  // the environment the child is exec'd with (that of the watchdog when the policy is disabled)
+  char* const* envp();
+  const std::string& policy() const { return description; }
+
+  // logs (and appends to the report file) the peak RSS of a terminated launch
+  void report(pid_t pid, long max_rss_kb, int64_t uptime_ms) const;
+};
+
+// memory limit of the watchdog's cgroup (v2 or v1) in bytes; zero if there is none
+uint64_t memory_limit_bytes();
+
+// effective number of CPUs per the affinity mask (or bound_cpus) and the cgroup CPU quota
+double effective_cpus(const std::string &bound_cpus);
+
+#endif //__MALLOC_POLICY_H__
@@ -0,0 +1,242 @@
+/* numa.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/syscall.h>
+#include "format2str.h"
+#include "path-concat.h"
+#include "cgroup.h"
+#include "log.h"
+#include "numa.h"
+
+using namespace logger;
+
+// set_mempolicy() modes (per <numaif.h>, which is not needed otherwise)
+enum : int { MPOL_DEFAULT_ = 0, MPOL_PREFERRED_ = 1, MPOL_BIND_ = 2, MPOL_INTERLEAVE_ = 3 };
+
+static const char * const node_root = "/sys/devices/system/node";
+
+struct node_info {
+  int id;
+  uint64_t free_kb;
+  std::vector<int> cpus;
+};
+
+// parses the kernel list format (e.g. "0-3,8,10-11")
+static std::vector<int> parse_list(const std::string_view text) {
+  std::vector<int> ids;
+  const std::string str{text};
+  for (const char *p = str.c_str(); *p != '\0';) {
+    char *end = nullptr;
+    const long first = strtol(p, &end, 10);
+    if (end == p) break;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      last = strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (long id = first; id <= last; id++) {
+      ids.push_back((int) id);
+    }
+    while (*p == ',' || *p == '\n' || *p == ' ') p++;
+  }
+  return ids;
+}
+
+// formats ids (ascending) in the kernel list format
+static std::string format_list(const std::vector<int> &ids) {
+  std::string list;
+  for (size_t i = 0; i < ids.size();) {
+    size_t j = i;
+    while (j + 1 < ids.size() && ids[j + 1] == ids[j] + 1) j++;
+    if (!list.empty()) list += ',';
+    list += j == i ? std::to_string(ids[i]) : format2str("%d-%d", ids[i], ids[j]);
+    i = j + 1;
+  }
+  return list;
+}
+
+static uint64_t node_free_kb(int id) {
+  const auto meminfo = cgroup::read_file(path_concat(node_root, format2str("node%d/meminfo", id)));
+  const auto pos = meminfo.find("MemFree:");
+  return pos == std::string::npos ? 0 : strtoull(meminfo.c_str() + pos + 8, nullptr, 10);
+}
+
+// memory nodes permitted by the watchdog's cpuset (empty if unrestricted or unknown)
+static std::vector<int> allowed_mems() {
+  auto path = cgroup::v2_file("cpuset.mems.effective");
+  if (path.empty()) {
+    const auto dir = cgroup::v1_dir("cpuset");
+    if (!dir.empty()) path = path_concat(dir, "cpuset.effective_mems");
+  }
+  return path.empty() ? std::vector<int>() : parse_list(cgroup::read_file(path));
+}
+
+static std::vector<node_info> read_topology() {
+  std::vector<node_info> topology;
+  auto node_ids = parse_list(cgroup::read_file(path_concat(node_root, "has_memory")));
+  if (node_ids.empty()) {
+    node_ids = parse_list(cgroup::read_file(path_concat(node_root, "online")));
+  }
+  const auto mems = allowed_mems();
+  cpu_set_t allowed_cpus;
+  CPU_ZERO(&allowed_cpus);
+  sched_getaffinity(0, sizeof(allowed_cpus), &allowed_cpus); // reflects the cpuset's cpus
+  for (const int id : node_ids) {
+    if (!mems.empty() && std::find(mems.begin(), mems.end(), id) == mems.end()) continue;
+    node_info info{id, node_free_kb(id), {}};
+    for (const int cpu : parse_list(cgroup::read_file(path_concat(node_root, format2str("node%d/cpulist", id))))) {
+      if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed_cpus)) info.cpus.push_back(cpu);
+    }
+    topology.push_back(std::move(info));
+  }
+  return topology;
+}
+
+numa_placement::~numa_placement() {
+  if (lock_fd != -1) {
+    close(lock_fd);
+  }
+}
+
+bool numa_placement::claim_node(const std::string &lock_dir, int node_id) {
+  const auto path = path_concat(lock_dir, format2str("java-watchdog-numa-node%d.lock", node_id));
+  const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (fd == -1) {
+    log(LL::DEBUG, "could not open NUMA node lock file \"%s\": %s", path.c_str(), strerror(errno));
+    return false;
+  }
+  if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+    close(fd);
+    return false;
+  }
+  // the claiming watchdog's pid, for the benefit of whoever looks at the lock file
+  const auto pid_str = format2str("%d\n", getpid());
+  if (ftruncate(fd, 0) == 0 && pwrite(fd, pid_str.c_str(), pid_str.size(), 0) < 0) {
+    log(LL::DEBUG, "could not write NUMA node lock file \"%s\": %s", path.c_str(), strerror(errno));
+  }
+  lock_fd = fd;
+  return true;
+}
+
+void numa_placement::plan(const numa_settings &cfg) {
+  if (cfg.node == numa_settings::node_none && cfg.memory_policy != MEMORY_POLICY::INTERLEAVE) return;
+  auto topology = read_topology();
+  if (topology.empty()) {
+    log(LL::DEBUG, "no NUMA topology found - child process placement skipped");
+    return;
+  }
+
+  if (cfg.node == numa_settings::node_auto) {
+    std::stable_sort(topology.begin(), topology.end(),
+                     [](const node_info &a, const node_info &b) { return a.free_kb > b.free_kb; });
+    for (const auto &info : topology) {
+      if (claim_node(cfg.lock_dir, info.id)) {
+        node = info.id;
+        break;
+      }
+    }
+    if (node == -1) {
+      node = topology.front().id;
+      log(LL::WARN, "all NUMA nodes already claimed by other watchdogs - sharing node %d", node);
+    }
+  } else if (cfg.node >= 0) {
+    if (std::none_of(topology.begin(), topology.end(), [&cfg](const node_info &info) { return info.id == cfg.node; })) {
+      log(LL::WARN, "NUMA node %d is not available to the watchdog - child process placement skipped", cfg.node);
+      return;
+    }
+    node = cfg.node;
+    if (!claim_node(cfg.lock_dir, node)) {
+      log(LL::INFO, "NUMA node %d is shared with another watchdog", node);
+    }
+  }
+
+  const auto chosen = std::find_if(topology.begin(), topology.end(),
+                                   [this](const node_info &info) { return info.id == node; });
+  if (chosen != topology.end() && cfg.bind_cpus) {
+    CPU_ZERO(&cpus);
+    for (const int cpu : chosen->cpus) {
+      CPU_SET(cpu, &cpus);
+    }
+    has_cpus = !chosen->cpus.empty();
+    if (!has_cpus) log(LL::WARN, "NUMA node %d has no CPUs available to the watchdog - not binding CPUs", node);
+  }
+
+  nodes.fill(0);
+  const auto add_node = [this](int id) { nodes[id / 64] |= 1UL << (id % 64); };
+  switch (cfg.memory_policy) {
+    case MEMORY_POLICY::PREFERRED:
+      mpol_mode = MPOL_PREFERRED_;
+      add_node(node);
+      break;
+    case MEMORY_POLICY::BIND:
+      mpol_mode = MPOL_BIND_;
+      add_node(node);
+      break;
+    case MEMORY_POLICY::INTERLEAVE:
+      mpol_mode = MPOL_INTERLEAVE_;
+      for (const auto &info : topology) {
+        add_node(info.id);
+      }
+      break;
+    default:
+      mpol_mode = MPOL_DEFAULT_;
+      break;
+  }
+
+  static const char * const policy_names[] = { "default", "preferred", "bind", "interleave" };
+  const auto where = node >= 0 ? format2str("node %d", node) : std::string("all nodes");
+  log(LL::INFO, "child process placement: %s, cpus [%s], memory policy %s [%s]", where.c_str(), cpu_list().c_str(),
+      policy_names[mpol_mode], node_list().c_str());
+}
+
+void numa_placement::apply_child() const {
+  if (has_cpus && sched_setaffinity(0, sizeof(cpus), &cpus) == -1) {
+    log(LL::WARN, "pid(%d): sched_setaffinity() failed: %s", getpid(), strerror(errno));
+  }
+  if (mpol_mode != MPOL_DEFAULT_ &&
+      syscall(SYS_set_mempolicy, mpol_mode, nodes.data(), nodes.size() * sizeof(unsigned long) * 8) == -1)
+  {
+    log(LL::WARN, "pid(%d): set_mempolicy() failed: %s", getpid(), strerror(errno));
+  }
+}
+
+std::string numa_placement::cpu_list() const {
+  std::vector<int> ids;
+  for (int cpu = 0; has_cpus && cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &cpus)) ids.push_back(cpu);
+  }
+  return format_list(ids);
+}
+
+std::string numa_placement::node_list() const {
+  std::vector<int> ids;
+  for (int id = 0; id < (int) (nodes.size() * 64); id++) {
+    if ((nodes[id / 64] & (1UL << (id % 64))) != 0) ids.push_back(id);
+  }
+  return format_list(ids);
+}
@@ -0,0 +1,65 @@
+/* numa.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __NUMA_H__
+#define __NUMA_H__
+
+#include <array>
+#include <string>
+#include <sched.h>
+#include "settings.h"
+
+/**
+ * Works out the CPU affinity and NUMA memory policy of the child JVM from the
+ * node topology under /sys/devices/system/node, restricted to the CPUs and
+ * memory nodes the watchdog's cpuset allows.
+ * <p>
+ * A chosen node is claimed with an flock() on a per-node lock file held for
+ * the lifetime of the watchdog, so that co-located watchdogs with node=auto
+ * each land on a node of their own.
+ */
+class numa_placement {
+private:
+  using node_mask = std::array<unsigned long, 16>;  // room for 1024 nodes
+  int node{-1};
+  int lock_fd{-1};
+  int mpol_mode{0};
+  bool has_cpus{false};
+  cpu_set_t cpus{};
+  node_mask nodes{};
+  bool claim_node(const std::string &lock_dir, int node_id);
+public:
+  numa_placement() = default;
+  numa_placement(const numa_placement &) = delete;
+  numa_placement& operator=(const numa_placement &) = delete;
+  ~numa_placement();
+
+  // decides the placement of the child per the [numa] settings; call prior to fork()
+  void plan(const numa_settings &cfg);
+  // called in the forked child prior to execv(); the placement is inherited across execv()
+  void apply_child() const;
+
+  bool is_active() const { return has_cpus || mpol_mode != 0; }
+  int chosen_node() const { return node; }
+  // the placement in the list format of cpuset.cpus and cpuset.mems (e.g. "0-7,16-23")
+  std::string cpu_list() const;
+  std::string node_list() const;
+};
+
+#endif //__NUMA_H__
@@ -0,0 +1,132 @@
+/* output-relay.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "format2str.h"
+#include "proc-stats.h"
+#include "output-relay.h"
+
+output_relay::output_relay(size_t tail_size) : tail(tail_size > 0 ? tail_size : 1) {}
+
+void output_relay::close_pipes() {
+  for (int *fd : { &out_pipe[0], &out_pipe[1], &err_pipe[0], &err_pipe[1] }) {
+    if (*fd != -1) {
+      if (loop != nullptr) loop->remove_fd(*fd);
+      close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
+void output_relay::open_pipes() {
+  close_pipes();
+  listeners.clear();
+  if (pipe2(out_pipe, O_CLOEXEC) == -1 || pipe2(err_pipe, O_CLOEXEC) == -1) {
+    throw output_relay_exception(format2str("pipe2() failed: %s", strerror(errno)));
+  }
+  fcntl(out_pipe[0], F_SETFL, O_NONBLOCK);
+  fcntl(err_pipe[0], F_SETFL, O_NONBLOCK);
+  first_output_ns = 0;
+}
+
+void output_relay::redirect_child() const {
+  // dup2() clears close-on-exec on the duplicated descriptors
+  dup2(out_pipe[1], STDOUT_FILENO);
+  dup2(err_pipe[1], STDERR_FILENO);
+}
+
+void output_relay::attach(event_loop &event_loop) {
+  loop = &event_loop;
+  // parent keeps only the read ends so that EOF is seen once the child exits
+  close(out_pipe[1]);
+  close(err_pipe[1]);
+  out_pipe[1] = err_pipe[1] = -1;
+  const auto on_readable = [this](int from_fd, int to_fd) {
+    return [this, from_fd, to_fd](uint32_t events) {
+      if (!relay(from_fd, to_fd) || (events & (EPOLLHUP | EPOLLERR)) != 0) {
+        loop->remove_fd(from_fd);
+      }
+    };
+  };
+  loop->add_fd(out_pipe[0], EPOLLIN, on_readable(out_pipe[0], STDOUT_FILENO));
+  loop->add_fd(err_pipe[0], EPOLLIN, on_readable(err_pipe[0], STDERR_FILENO));
+}
+
+void output_relay::drain() {
+  if (out_pipe[0] != -1) relay(out_pipe[0], STDOUT_FILENO);
+  if (err_pipe[0] != -1) relay(err_pipe[0], STDERR_FILENO);
+  // the event loop doesn't outlive the child's supervision
+  if (loop != nullptr) {
+    loop->remove_fd(out_pipe[0]);
+    loop->remove_fd(err_pipe[0]);
+    loop = nullptr;
+  }
+}
+
+// relays whatever is presently readable; returns false on EOF
+bool output_relay::relay(int from_fd, int to_fd) {
+  char buf[64 * 1024];
+  for (;;) {
+    const ssize_t n = read(from_fd, buf, sizeof(buf));
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EINTR;
+    if (first_output_ns == 0) {
+      first_output_ns = monotonic_ns();
+    }
+    for (ssize_t off = 0; off < n;) {
+      const ssize_t w = write(to_fd, buf + off, (size_t) (n - off));
+      if (w <= 0) {
+        if (w < 0 && errno == EINTR) continue;
+        break; // the watchdog's own output is gone; keep capturing regardless
+      }
+      off += w;
+    }
+    append_tail(buf, (size_t) n);
+    for (const auto &listener : listeners) {
+      listener(std::string_view(buf, (size_t) n));
+    }
+  }
+}
+
+void output_relay::append_tail(const char *data, size_t len) {
+  if (len >= tail.size()) {
+    memcpy(tail.data(), data + len - tail.size(), tail.size());
+    tail_pos = 0;
+    is_wrapped = true;
+    return;
+  }
+  const size_t first = std::min(len, tail.size() - tail_pos);
+  memcpy(tail.data() + tail_pos, data, first);
+  memcpy(tail.data(), data + first, len - first);
+  if (tail_pos + len >= tail.size()) is_wrapped = true;
+  tail_pos = (tail_pos + len) % tail.size();
+}
+
+std::string output_relay::tail_text() const {
+  if (!is_wrapped) {
+    return std::string(tail.data(), tail_pos);
+  }
+  std::string text(tail.data() + tail_pos, tail.size() - tail_pos);
+  text.append(tail.data(), tail_pos);
+  return text;
+}
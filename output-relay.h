@@ -0,0 +1,77 @@
+/* output-relay.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __OUTPUT_RELAY_H__
+#define __OUTPUT_RELAY_H__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "decl-exception.h"
+#include "event-loop.h"
+
+// declare output_relay_exception
+DECL_EXCEPTION(output_relay)
+
+/**
+ * Captures the stdout and stderr of the child process through pipes, relays
+ * it on to the watchdog's own stdout and stderr, and retains the most recent
+ * output in a fixed-size tail buffer (for crash bundles and diagnostics).
+ */
+class output_relay {
+public:
+  using output_listener_t = std::function<void(const std::string_view chunk)>;
+private:
+  int out_pipe[2]{ -1, -1 };
+  int err_pipe[2]{ -1, -1 };
+  std::vector<char> tail;
+  size_t tail_pos{0};
+  bool is_wrapped{false};
+  int64_t first_output_ns{0};
+  std::vector<output_listener_t> listeners;
+  event_loop *loop{nullptr};
+  void close_pipes();
+  bool relay(int from_fd, int to_fd);
+  void append_tail(const char *data, size_t len);
+public:
+  explicit output_relay(size_t tail_size);
+  output_relay(const output_relay &) = delete;
+  output_relay& operator=(const output_relay &) = delete;
+  ~output_relay() { close_pipes(); }
+
+  // creates the pipes, must be called prior to fork() (anew for each launch; listeners are per launch)
+  void open_pipes();
+  // called in the forked child; redirects stdout/stderr into the pipes (async-signal-safe)
+  void redirect_child() const;
+  // called in the parent after fork(); starts relaying the child's output
+  void attach(event_loop &event_loop);
+  // reads any output still buffered in the pipes once the child has terminated (and detaches from the event loop)
+  void drain();
+
+  // listeners see each chunk of captured output as it is relayed
+  void add_listener(output_listener_t listener) { listeners.emplace_back(std::move(listener)); }
+  // monotonic time of the first output of the child process (zero if none yet)
+  int64_t first_output_time_ns() const { return first_output_ns; }
+  // the most recent output of the child process (up to tail_size bytes)
+  std::string tail_text() const;
+};
+
+#endif //__OUTPUT_RELAY_H__
@@ -21,7 +21,9 @@ limitations under the License.
 #include "path-concat.h"
 
 std::string path_concat(const std::string_view str1, const std::string_view str2) {
-  std::string path_rslt{str1};
+  std::string path_rslt;
+  path_rslt.reserve(str1.size() + 1 + str2.size()); // (the one allocation of the result)
+  path_rslt = str1;
   const auto len = path_rslt.length();
   if (len > 0) {
     auto &last_ch = path_rslt[len - 1];
@@ -0,0 +1,213 @@
+/* pgzip.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cerrno>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "format2str.h"
+#include "pgzip.h"
+
+namespace {
+
+  struct work_item {
+    std::vector<uint8_t> in;
+    size_t in_len{0};
+    std::vector<uint8_t> out;
+    size_t out_len{0};
+    bool is_done{false};
+    bool is_failed{false};
+  };
+
+  // compresses one chunk of input as a complete gzip member
+  bool deflate_item(work_item &item, int level) {
+    z_stream zs{};
+    // window bits of 15 + 16 selects the gzip wrapper
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+    const auto bound = deflateBound(&zs, (uLong) item.in_len);
+    if (item.out.size() < bound) item.out.resize(bound);
+    zs.next_in = item.in.data();
+    zs.avail_in = (uInt) item.in_len;
+    zs.next_out = item.out.data();
+    zs.avail_out = (uInt) item.out.size();
+    const int rc = deflate(&zs, Z_FINISH);
+    item.out_len = zs.total_out;
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END;
+  }
+
+  ssize_t read_full(int fd, uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+      const ssize_t n = read(fd, buf + total, len - total);
+      if (n == 0) break;
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        return -1;
+      }
+      total += (size_t) n;
+    }
+    return (ssize_t) total;
+  }
+
+  bool write_full(int fd, const uint8_t *buf, size_t len) {
+    while (len > 0) {
+      const ssize_t n = write(fd, buf, len);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      buf += n;
+      len -= (size_t) n;
+    }
+    return true;
+  }
+
+  // owns the worker threads and descriptors so every exit path cleans up
+  struct compressor {
+    std::vector<work_item> items;
+    std::deque<size_t> queue;
+    std::mutex mtx;
+    std::condition_variable cv_work;
+    std::condition_variable cv_done;
+    bool is_closing{false};
+    std::vector<std::thread> workers;
+    int in_fd{-1};
+    int out_fd{-1};
+    std::string dst_path;
+    bool is_complete{false};
+
+    ~compressor() {
+      {
+        std::lock_guard<std::mutex> lk(mtx);
+        is_closing = true;
+      }
+      cv_work.notify_all();
+      for (auto &worker : workers) {
+        worker.join();
+      }
+      if (in_fd != -1) close(in_fd);
+      if (out_fd != -1) close(out_fd);
+      if (!is_complete && !dst_path.empty()) unlink(dst_path.c_str());
+    }
+
+    void work(int level) {
+      for (;;) {
+        size_t idx;
+        {
+          std::unique_lock<std::mutex> lk(mtx);
+          cv_work.wait(lk, [this] { return is_closing || !queue.empty(); });
+          if (is_closing) return;
+          idx = queue.front();
+          queue.pop_front();
+        }
+        const bool is_ok = deflate_item(items[idx], level);
+        {
+          std::lock_guard<std::mutex> lk(mtx);
+          items[idx].is_failed = !is_ok;
+          items[idx].is_done = true;
+        }
+        cv_done.notify_all();
+      }
+    }
+  };
+
+}
+
+uint64_t pgzip_file(const std::string &src_path, const std::string &dst_path, const pgzip_options &options) {
+  compressor cmp;
+  cmp.in_fd = open(src_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (cmp.in_fd == -1) {
+    throw pgzip_exception(format2str("can't open '%s': %s", src_path.c_str(), strerror(errno)));
+  }
+  posix_fadvise(cmp.in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  cmp.out_fd = open(dst_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+  if (cmp.out_fd == -1) {
+    throw pgzip_exception(format2str("can't create '%s': %s", dst_path.c_str(), strerror(errno)));
+  }
+  cmp.dst_path = dst_path;
+
+  const unsigned threads = options.threads > 0 ? options.threads : 1;
+  const size_t chunk_size = options.chunk_size >= 64 * 1024 ? options.chunk_size : 64 * 1024;
+  const size_t depth = threads * 2;
+  cmp.items.resize(depth);
+  for (auto &item : cmp.items) {
+    item.in.resize(chunk_size);
+  }
+  for (unsigned i = 0; i < threads; i++) {
+    cmp.workers.emplace_back(&compressor::work, &cmp, options.level);
+  }
+
+  uint64_t written = 0;
+  size_t next_read = 0;
+  size_t next_write = 0;
+  bool is_eof = false;
+  for (;;) {
+    // keep every free slot filled with input for the workers
+    while (!is_eof && next_read - next_write < depth) {
+      auto &item = cmp.items[next_read % depth];
+      const ssize_t n = read_full(cmp.in_fd, item.in.data(), chunk_size);
+      if (n < 0) {
+        throw pgzip_exception(format2str("failed reading '%s': %s", src_path.c_str(), strerror(errno)));
+      }
+      if ((size_t) n < chunk_size) is_eof = true;
+      if (n == 0) break;
+      item.in_len = (size_t) n;
+      {
+        std::lock_guard<std::mutex> lk(cmp.mtx);
+        item.is_done = false;
+        cmp.queue.push_back(next_read % depth);
+      }
+      cmp.cv_work.notify_one();
+      next_read++;
+    }
+    if (next_write == next_read) break;
+
+    // write out the oldest chunk once compressed, thereby preserving order
+    auto &item = cmp.items[next_write % depth];
+    {
+      std::unique_lock<std::mutex> lk(cmp.mtx);
+      cmp.cv_done.wait(lk, [&item] { return item.is_done; });
+    }
+    if (item.is_failed) {
+      throw pgzip_exception(format2str("deflate failed compressing '%s'", src_path.c_str()));
+    }
+    if (!write_full(cmp.out_fd, item.out.data(), item.out_len)) {
+      throw pgzip_exception(format2str("failed writing '%s': %s", dst_path.c_str(), strerror(errno)));
+    }
+    written += item.out_len;
+    if (written > options.max_output) {
+      throw pgzip_exception(format2str("compressing '%s' exceeded output budget of %lu bytes",
+                                       src_path.c_str(), (unsigned long) options.max_output));
+    }
+    next_write++;
+  }
+
+  if (fsync(cmp.out_fd) == -1 && errno != EINVAL) {
+    throw pgzip_exception(format2str("failed syncing '%s': %s", dst_path.c_str(), strerror(errno)));
+  }
+  cmp.is_complete = true;
+  return written;
+}
@@ -0,0 +1,53 @@
+/* pgzip.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __PGZIP_H__
+#define __PGZIP_H__
+
+#include <cstdint>
+#include <string>
+#include "decl-exception.h"
+
+// declare pgzip_exception
+DECL_EXCEPTION(pgzip)
+
+struct pgzip_options {
+  unsigned threads = 4;             // compression worker threads
+  size_t chunk_size = 1024 * 1024;  // bytes of input compressed per work item
+  int level = 1;                    // zlib compression level (1 is fastest)
+  uint64_t max_output = UINT64_MAX; // abandon compression once output exceeds this (UINT64_MAX is unlimited)
+};
+
+/**
+ * Compresses a (potentially very large) file to gzip format using a bounded
+ * pool of worker threads, in the manner of pigz. The input is split into
+ * fixed size chunks which are deflated concurrently and written out in
+ * order, each as its own gzip member - a concatenation of gzip members is
+ * itself a valid gzip file (RFC 1952) that gunzip decompresses in one go.
+ * <p>
+ * Memory use is bounded to roughly 2 x threads x chunk_size.
+ *
+ * @param src_path path of the file to compress
+ * @param dst_path path of the .gz file to create (removed on failure)
+ * @param options thread count, chunk size, compression level and output budget
+ * @return number of compressed bytes written; throws pgzip_exception on failure
+ */
+uint64_t pgzip_file(const std::string &src_path, const std::string &dst_path, const pgzip_options &options);
+
+#endif //__PGZIP_H__
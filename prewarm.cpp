@@ -0,0 +1,151 @@
+/* prewarm.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "path-concat.h"
+#include "log.h"
+#include "proc-stats.h"
+#include "prewarm.h"
+
+using namespace logger;
+
+namespace {
+
+  struct prewarm_file {
+    int rank;             // lower is read ahead sooner
+    std::string path;
+    uint64_t size;
+  };
+
+  bool ends_with(const std::string_view str, const std::string_view suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  // what the JVM touches first: the VM itself, the class library image and the CDS archives
+  int jdk_file_rank(const std::string_view name) {
+    if (name == "libjvm.so" || name == "modules" || name == "rt.jar" || ends_with(name, ".jsa")) return 0;
+    if (ends_with(name, ".so")) return 1;
+    if (ends_with(name, ".jar")) return 3;
+    return -1; // not read by a booting JVM (src.zip, ct.sym, fonts, ...)
+  }
+
+  void add_file(std::vector<prewarm_file> &files, int rank, const std::string &path) {
+    struct stat statbuf{};
+    if (stat(path.c_str(), &statbuf) == 0 && S_ISREG(statbuf.st_mode) && statbuf.st_size > 0) {
+      files.push_back({rank, path, (uint64_t) statbuf.st_size});
+    }
+  }
+
+  void add_tree(std::vector<prewarm_file> &files, const std::string &dir_path, int fixed_rank, int depth = 0) {
+    DIR * const dir = opendir(dir_path.c_str());
+    if (dir == nullptr) {
+      if (fixed_rank >= 0) add_file(files, fixed_rank, dir_path); // a plain file
+      return;
+    }
+    for (const struct dirent *ent = readdir(dir); ent != nullptr; ent = readdir(dir)) {
+      if (ent->d_name[0] == '.') continue;
+      const auto path = path_concat(dir_path, ent->d_name);
+      if (ent->d_type == DT_DIR) {
+        if (depth < 4) add_tree(files, path, fixed_rank, depth + 1);
+        continue;
+      }
+      const int rank = fixed_rank >= 0 ? fixed_rank : jdk_file_rank(ent->d_name);
+      if (rank >= 0) add_file(files, rank, path);
+    }
+    closedir(dir);
+  }
+
+  void read_ahead(const prewarm_file &file, uint64_t len) {
+    const int fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return;
+    if (readahead(fd, 0, len) == -1) {
+      posix_fadvise(fd, 0, (off_t) len, POSIX_FADV_WILLNEED);
+    }
+    close(fd);
+  }
+
+}
+
+void prewarmer::start(const std::string &jdk_home, std::vector<std::string> classpath, const std::string &cds_archive) {
+  if (!cfg.enabled || planner.joinable()) return;
+  std::vector<std::string> priority_paths;
+  if (!cds_archive.empty()) priority_paths.push_back(cds_archive);
+  if (!jdk_home.empty()) priority_paths.push_back(path_concat(jdk_home, "lib"));
+  planner = std::thread(&prewarmer::run, this, std::move(priority_paths), std::move(classpath));
+}
+
+void prewarmer::run(std::vector<std::string> priority_paths, std::vector<std::string> classpath) {
+  const auto start_ns = monotonic_ns();
+  std::vector<prewarm_file> files;
+  for (const auto &path : priority_paths) {
+    add_tree(files, path, ends_with(path, ".jsa") ? 0 : -1);
+  }
+  for (const auto &path : classpath) {
+    add_file(files, 2, path);
+  }
+  size_t pos = 0;
+  while (pos <= cfg.paths.size()) {
+    auto colon = cfg.paths.find(':', pos);
+    if (colon == std::string::npos) colon = cfg.paths.size();
+    if (colon > pos) add_tree(files, cfg.paths.substr(pos, colon - pos), 4);
+    pos = colon + 1;
+  }
+  std::stable_sort(files.begin(), files.end(),
+                   [](const prewarm_file &a, const prewarm_file &b) { return a.rank < b.rank; });
+
+  // the IO budget cuts off the lowest priority files (the last one within budget is read ahead in part)
+  std::vector<uint64_t> lengths;
+  uint64_t total = 0;
+  for (const auto &file : files) {
+    if (total >= cfg.io_budget) break;
+    lengths.push_back(std::min(file.size, cfg.io_budget - total));
+    total += lengths.back();
+  }
+
+  std::atomic<size_t> next{0};
+  const auto worker = [this, &files, &lengths, &next]() {
+    for (size_t i = next++; i < lengths.size() && !is_stopping; i = next++) {
+      read_ahead(files[i], lengths[i]);
+    }
+  };
+  std::vector<std::thread> workers;
+  const unsigned threads = std::max(1u, std::min(cfg.threads, (unsigned) lengths.size()));
+  for (unsigned i = 1; i < threads; i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto &thrd : workers) {
+    thrd.join();
+  }
+  log(LL::DEBUG, "prewarmed %zu of %zu files (%lu MB) in %ld ms with %u threads%s", std::min(next.load(), lengths.size()),
+      files.size(), (unsigned long) (total / (1024 * 1024)), (long) ((monotonic_ns() - start_ns) / 1000000), threads,
+      is_stopping ? " (stopped)" : "");
+}
+
+void prewarmer::stop() {
+  is_stopping = true;
+  if (planner.joinable()) {
+    planner.join();
+  }
+}
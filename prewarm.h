@@ -0,0 +1,63 @@
+/* prewarm.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __PREWARM_H__
+#define __PREWARM_H__
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "settings.h"
+
+/**
+ * Reads the files the JVM is about to fault in - libjvm.so, the JDK modules
+ * image, the CDS archives and the class path jars - into the page cache with
+ * readahead(), in that priority order across a small pool of threads and up to
+ * an IO budget.
+ * <p>
+ * The prewarm runs in the watchdog alongside the booting JVM (threads are only
+ * started after fork(), so the child never inherits a multi-threaded address
+ * space), so that the JVM's major page faults are served by reads already in flight.
+ */
+class prewarmer {
+private:
+  const prewarm_settings &cfg;
+  std::thread planner;
+  std::atomic<bool> is_stopping{false};
+  void run(std::vector<std::string> priority_paths, std::vector<std::string> classpath);
+public:
+  explicit prewarmer(const prewarm_settings &cfg) : cfg{cfg} {}
+  prewarmer(const prewarmer &) = delete;
+  prewarmer& operator=(const prewarmer &) = delete;
+  ~prewarmer() { stop(); }
+
+  /**
+   * Starts the prewarm in the background; call in the parent after fork().
+   *
+   * @param jdk_home the JDK home directory (its lib/ directory is read ahead)
+   * @param classpath the class path jars in class path order
+   * @param cds_archive the AppCDS archive in use or empty
+   */
+  void start(const std::string &jdk_home, std::vector<std::string> classpath, const std::string &cds_archive);
+  // abandons the remaining prewarm and waits for the threads to finish
+  void stop();
+};
+
+#endif //__PREWARM_H__
@@ -0,0 +1,163 @@
+/* proc-stats.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include "format2str.h"
+#include "cgroup.h"
+#include "proc-stats.h"
+
+const std::array<std::string_view, metric_count> metric_names = {
+  "rss_kb",
+  "cpu_pct",
+  "threads",
+  "cpu_pressure",
+  "mem_pressure",
+  "io_pressure",
+  "gc_young_count",
+  "gc_young_ms",
+  "gc_old_count",
+  "gc_old_ms",
+  "safepoints",
+  "safepoint_ms",
+  "heap_used_kb",
+  "metaspace_used_kb",
+  "anon_kb",
+  "leak_kb_per_h",
+  "leak_hours_to_limit",
+  "throttled_pct",
+};
+
+int64_t monotonic_ns() {
+  struct timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t wall_clock_ms() {
+  struct timespec ts{};
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t) ts.tv_sec * 1000LL + ts.tv_nsec / 1000000L;
+}
+
+// reads a small file from offset zero into buf (null terminated); returns bytes read
+static ssize_t pread_all(int fd, char *buf, size_t buf_size) {
+  if (fd == -1) return -1;
+  const ssize_t n = pread(fd, buf, buf_size - 1, 0);
+  buf[n > 0 ? n : 0] = '\0';
+  return n;
+}
+
+// the "some avg10=" value of a pressure stall information file
+static double read_pressure(int fd) {
+  char buf[256];
+  if (pread_all(fd, buf, sizeof(buf)) <= 0) return 0.0;
+  const char * const avg10 = strstr(buf, "avg10=");
+  return avg10 != nullptr ? strtod(avg10 + 6, nullptr) : 0.0;
+}
+
+proc_sampler::proc_sampler() {
+  clock_ticks = sysconf(_SC_CLK_TCK);
+  page_kb = sysconf(_SC_PAGESIZE) / 1024;
+  static const char * const pressure_files[] = { "cpu.pressure", "memory.pressure", "io.pressure" };
+  static const char * const system_pressure_files[] = {
+      "/proc/pressure/cpu", "/proc/pressure/memory", "/proc/pressure/io" };
+  for (size_t i = 0; i < pressure_fds.size(); i++) {
+    // prefer the container's own pressure stall info over that of the whole host
+    auto path = cgroup::v2_file(pressure_files[i]);
+    if (path.empty()) path = system_pressure_files[i];
+    pressure_fds[i] = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  }
+}
+
+void proc_sampler::close_fds() {
+  if (stat_fd != -1) close(stat_fd);
+  stat_fd = -1;
+  for (auto &fd : pressure_fds) {
+    if (fd != -1) close(fd);
+    fd = -1;
+  }
+}
+
+void proc_sampler::attach(pid_t child_pid) {
+  if (stat_fd != -1) close(stat_fd);
+  pid = child_pid;
+  stat_fd = open(format2str("/proc/%d/stat", pid).c_str(), O_RDONLY | O_CLOEXEC);
+  prev_cpu_ticks = 0;
+  prev_mono_ns = 0;
+  hsperf.detach();
+}
+
+bool proc_sampler::sample(metric_values &values) {
+  values.fill(0.0);
+
+  char buf[1024];
+  if (pread_all(stat_fd, buf, sizeof(buf)) <= 0) return false;
+  // fields following the parenthesized command name start with field 3 (state)
+  const char *p = strrchr(buf, ')');
+  if (p == nullptr) return false;
+  p += 2;
+  uint64_t utime = 0, stime = 0;
+  long threads = 0, rss_pages = 0;
+  for (int field = 3; *p != '\0' && field <= 24; field++) {
+    switch (field) {
+      case 14: utime = strtoull(p, nullptr, 10); break;
+      case 15: stime = strtoull(p, nullptr, 10); break;
+      case 20: threads = strtol(p, nullptr, 10); break;
+      case 24: rss_pages = strtol(p, nullptr, 10); break;
+    }
+    p = strchr(p, ' ');
+    if (p == nullptr) break;
+    p++;
+  }
+  at(values, METRIC::RSS_KB) = (double) rss_pages * page_kb;
+  at(values, METRIC::THREADS) = (double) threads;
+
+  const auto cpu_ticks = utime + stime;
+  const auto now_ns = monotonic_ns();
+  if (prev_mono_ns != 0 && now_ns > prev_mono_ns) {
+    const double cpu_secs = (double) (cpu_ticks - prev_cpu_ticks) / clock_ticks;
+    at(values, METRIC::CPU_PCT) = 100.0 * cpu_secs / ((double) (now_ns - prev_mono_ns) / 1e9);
+  }
+  prev_cpu_ticks = cpu_ticks;
+  prev_mono_ns = now_ns;
+
+  at(values, METRIC::CPU_PRESSURE) = read_pressure(pressure_fds[0]);
+  at(values, METRIC::MEM_PRESSURE) = read_pressure(pressure_fds[1]);
+  at(values, METRIC::IO_PRESSURE)  = read_pressure(pressure_fds[2]);
+
+  if (!hsperf.is_attached() && !hsperf.attach(pid)) return true;
+  // absent counters (e.g. of a collector the JVM isn't using) read as zero
+  const auto counter = [this](const std::string_view name) -> int64_t {
+    const auto value = hsperf.get(name);
+    return value > 0 ? value : 0;
+  };
+  at(values, METRIC::GC_YOUNG_COUNT) = (double) counter("sun.gc.collector.0.invocations");
+  at(values, METRIC::GC_YOUNG_MS) = hsperf.ticks_to_ms(counter("sun.gc.collector.0.time"));
+  at(values, METRIC::GC_OLD_COUNT) = (double) counter("sun.gc.collector.1.invocations");
+  at(values, METRIC::GC_OLD_MS) = hsperf.ticks_to_ms(counter("sun.gc.collector.1.time"));
+  at(values, METRIC::SAFEPOINTS) = (double) counter("sun.rt.safepoints");
+  at(values, METRIC::SAFEPOINT_MS) = hsperf.ticks_to_ms(counter("sun.rt.safepointTime"));
+  at(values, METRIC::HEAP_USED_KB) = (double) hsperf.sum("sun.gc.generation.", ".used") / 1024.0;
+  at(values, METRIC::METASPACE_USED_KB) = (double) counter("sun.gc.metaspace.used") / 1024.0;
+  return true;
+}
@@ -0,0 +1,94 @@
+/* proc-stats.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __PROC_STATS_H__
+#define __PROC_STATS_H__
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <sys/types.h>
+#include "hsperf.h"
+
+// the sampled metric series (index into a sample's values array)
+enum class METRIC : int {
+  RSS_KB = 0,
+  CPU_PCT,
+  THREADS,
+  CPU_PRESSURE,
+  MEM_PRESSURE,
+  IO_PRESSURE,
+  GC_YOUNG_COUNT,
+  GC_YOUNG_MS,
+  GC_OLD_COUNT,
+  GC_OLD_MS,
+  SAFEPOINTS,
+  SAFEPOINT_MS,
+  HEAP_USED_KB,
+  METASPACE_USED_KB,
+  ANON_KB,              // published by the leak detector (zero when it is off)
+  LEAK_KB_PER_H,
+  LEAK_HOURS_TO_LIMIT,  // zero when no leak is projected to reach a memory limit
+  THROTTLED_PCT,        // published by the throttle monitor: share of CFS periods throttled
+  COUNT
+};
+
+const size_t metric_count = static_cast<size_t>(METRIC::COUNT);
+using metric_values = std::array<double, metric_count>;
+
+extern const std::array<std::string_view, metric_count> metric_names;
+
+inline double& at(metric_values &values, METRIC m) { return values[static_cast<size_t>(m)]; }
+inline double at(const metric_values &values, METRIC m) { return values[static_cast<size_t>(m)]; }
+
+/**
+ * Samples resource usage of the child JVM process from procfs, the cgroup
+ * pressure stall (PSI) files and the JVM's own hsperfdata counters.
+ * <p>
+ * File descriptors are opened once and re-read via pread() on each sample,
+ * so sampling costs a handful of syscalls and no allocations.
+ */
+class proc_sampler {
+private:
+  pid_t pid{0};
+  int stat_fd{-1};
+  std::array<int, 3> pressure_fds{ -1, -1, -1 };
+  uint64_t prev_cpu_ticks{0};
+  int64_t prev_mono_ns{0};
+  long clock_ticks{100};
+  long page_kb{4};
+  hsperf_reader hsperf;
+  void close_fds();
+public:
+  proc_sampler();
+  proc_sampler(const proc_sampler &) = delete;
+  proc_sampler& operator=(const proc_sampler &) = delete;
+  ~proc_sampler() { close_fds(); }
+
+  void attach(pid_t child_pid);
+  // fills in values; returns false if the process could no longer be sampled
+  bool sample(metric_values &values);
+  hsperf_reader& jvm_counters() { return hsperf; }
+};
+
+// monotonic and wall clock time helpers shared by the samplers
+int64_t monotonic_ns();
+int64_t wall_clock_ms();
+
+#endif //__PROC_STATS_H__
@@ -0,0 +1,217 @@
+/* proc-tree.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "path-concat.h"
+#include "cgroup.h"
+#include "log.h"
+#include "proc-tree.h"
+
+using namespace logger;
+
+static bool write_value(const std::string &path, const char *value) {
+  const int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+  if (fd == -1) return false;
+  const size_t len = strlen(value);
+  const bool is_ok = write(fd, value, len) == (ssize_t) len;
+  const int write_errno = errno;
+  close(fd);
+  errno = write_errno;
+  return is_ok;
+}
+
+bool process_tree::try_create_cgroup(const std::string_view name) {
+  const auto &parent = cgroup::v2_dir();
+  if (parent.empty() || access(parent.c_str(), W_OK) != 0) return false;
+  auto path = path_concat(parent, name);
+  if (mkdir(path.c_str(), 0755) == -1 && errno != EEXIST) {
+    log(LL::DEBUG, "could not create child cgroup \"%s\": %s", path.c_str(), strerror(errno));
+    return false;
+  }
+  procs_path = path_concat(path, "cgroup.procs");
+  if (access(procs_path.c_str(), W_OK) != 0) {
+    rmdir(path.c_str());
+    procs_path.clear();
+    return false;
+  }
+  // cgroup.kill appeared with Linux 5.14; older kernels get the processes killed one by one
+  kill_path = path_concat(path, "cgroup.kill");
+  if (access(kill_path.c_str(), W_OK) != 0) kill_path.clear();
+  cgroup_path = std::move(path);
+  return true;
+}
+
+void process_tree::prepare(const std::string_view name) {
+  if (mode == TEARDOWN::AUTO || mode == TEARDOWN::CGROUP) {
+    if (try_create_cgroup(name)) {
+      mode = TEARDOWN::CGROUP;
+      log(LL::DEBUG, "child process tree confined to cgroup \"%s\"", cgroup_path.c_str());
+      return;
+    }
+    if (mode == TEARDOWN::CGROUP) {
+      log(LL::WARN, "could not create a child cgroup - falling back to process group teardown");
+    } else if (isatty(STDIN_FILENO)) {
+      // a background process group reading the terminal would be stopped by SIGTTIN
+      log(LL::DEBUG, "no child cgroup and stdin is a terminal - process tree teardown disabled");
+      mode = TEARDOWN::NONE;
+      return;
+    }
+    mode = TEARDOWN::PROCESS_GROUP;
+  }
+}
+
+void process_tree::enter_child() const {
+  switch (mode) {
+    case TEARDOWN::CGROUP:
+      // writing 0 moves the writing process itself
+      write_value(procs_path, "0");
+      break;
+    case TEARDOWN::PROCESS_GROUP:
+      setpgid(0, 0);
+      break;
+    default:
+      break;
+  }
+}
+
+void process_tree::adopt(pid_t pid) {
+  leader = pid;
+  if (mode == TEARDOWN::PROCESS_GROUP) {
+    // also done by the parent so the process group exists regardless of which side runs first
+    setpgid(pid, pid);
+  }
+}
+
+bool process_tree::set_cpuset(const std::string &cpus, const std::string &mems) {
+  if (mode != TEARDOWN::CGROUP) return false;
+  const auto &parent = cgroup::v2_dir();
+  const auto subtree_control = path_concat(parent, "cgroup.subtree_control");
+  if (!write_value(subtree_control, "+cpuset") && errno == EBUSY) {
+    // controllers can't be enabled for a cgroup having processes of its own, so move into a leaf
+    const auto leaf = path_concat(parent, "watchdog");
+    mkdir(leaf.c_str(), 0755);
+    if (write_value(path_concat(leaf, "cgroup.procs"), "0")) {
+      log(LL::DEBUG, "watchdog moved into leaf cgroup \"%s\"", leaf.c_str());
+      write_value(subtree_control, "+cpuset");
+    }
+  }
+  const auto cpus_path = path_concat(cgroup_path, "cpuset.cpus");
+  const auto mems_path = path_concat(cgroup_path, "cpuset.mems");
+  if ((!cpus.empty() && !write_value(cpus_path, cpus.c_str())) ||
+      (!mems.empty() && !write_value(mems_path, mems.c_str())))
+  {
+    log(LL::WARN, "could not set cpuset of child cgroup \"%s\": %s", cgroup_path.c_str(), strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+void process_tree::kill_all() const {
+  switch (mode) {
+    case TEARDOWN::CGROUP: {
+      if (!kill_path.empty() && write_value(kill_path, "1")) return;
+      // processes may fork while being killed, so make a few passes
+      for (int pass = 0; pass < 10; pass++) {
+        const auto procs = cgroup::read_file(procs_path);
+        if (procs.empty()) return;
+        for (const char *p = procs.c_str(); *p != '\0';) {
+          char *end = nullptr;
+          const long pid = strtol(p, &end, 10);
+          if (end == p) break;
+          if (pid > 0) kill((pid_t) pid, SIGKILL);
+          p = end;
+        }
+      }
+      break;
+    }
+    case TEARDOWN::PROCESS_GROUP:
+      if (leader > 0) kill(-leader, SIGKILL);
+      break;
+    default:
+      if (leader > 0) kill(leader, SIGKILL);
+      break;
+  }
+}
+
+bool process_tree::is_empty() const {
+  switch (mode) {
+    case TEARDOWN::CGROUP:
+      // a terminated process leaves cgroup.procs at once (its zombie is reaped along with the watchdog's others)
+      return cgroup::read_file(procs_path).empty();
+    case TEARDOWN::PROCESS_GROUP:
+      if (leader <= 0) return true;
+      while (waitpid(-leader, nullptr, WNOHANG) > 0) {}
+      return kill(-leader, 0) == -1 && errno == ESRCH;
+    default:
+      return true;
+  }
+}
+
+void process_tree::release() {
+  if (cgroup_path.empty()) return;
+  if (rmdir(cgroup_path.c_str()) == -1 && errno != ENOENT) {
+    log(LL::DEBUG, "could not remove child cgroup \"%s\": %s", cgroup_path.c_str(), strerror(errno));
+  }
+  cgroup_path.clear();
+}
+
+void become_subreaper() {
+  if (getpid() == 1) return; // init already inherits all orphans
+  if (prctl(PR_SET_CHILD_SUBREAPER, 1, 0, 0, 0) == -1) {
+    log(LL::WARN, "could not become child subreaper: %s", strerror(errno));
+  }
+}
+
+bool reap_children(pid_t watched, int &status, struct rusage *usage) {
+  bool is_reaped = false;
+  for (;;) {
+    int wstatus = 0;
+    struct rusage ru{};
+    const pid_t pid = wait4(-1, &wstatus, WNOHANG, &ru);
+    if (pid == -1 && errno == EINTR) continue;
+    if (pid <= 0) break;
+    if (pid == watched) {
+      status = wstatus;
+      if (usage != nullptr) *usage = ru;
+      is_reaped = true;
+    } else {
+      log(LL::TRACE, "reaped orphaned descendant process (pid:%d)", pid);
+    }
+  }
+  return is_reaped;
+}
+
+void reap_children(const std::function<void(pid_t pid, int status, const struct rusage &usage)> &on_reaped) {
+  for (;;) {
+    int wstatus = 0;
+    struct rusage ru{};
+    const pid_t pid = wait4(-1, &wstatus, WNOHANG, &ru);
+    if (pid == -1 && errno == EINTR) continue;
+    if (pid <= 0) break;
+    on_reaped(pid, wstatus, ru);
+  }
+}
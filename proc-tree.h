@@ -0,0 +1,88 @@
+/* proc-tree.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __PROC_TREE_H__
+#define __PROC_TREE_H__
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include "settings.h"
+
+/**
+ * Confines the child JVM and everything it spawns to a process tree that can
+ * be torn down as a whole: either a dedicated child cgroup (killed with one
+ * write to cgroup.kill) or a dedicated process group (killed with one kill()
+ * of the negated process group id). Either way teardown is a single syscall
+ * regardless of how many processes the tree holds.
+ */
+class process_tree {
+private:
+  TEARDOWN mode;
+  std::string cgroup_path;
+  std::string procs_path;     // <cgroup>/cgroup.procs, written by the forked child
+  std::string kill_path;      // <cgroup>/cgroup.kill, empty on kernels prior to 5.14
+  pid_t leader{0};
+  bool try_create_cgroup(const std::string_view name);
+public:
+  explicit process_tree(TEARDOWN teardown) : mode{teardown} {}
+  process_tree(const process_tree &) = delete;
+  process_tree& operator=(const process_tree &) = delete;
+  ~process_tree() { release(); }
+
+  // decides the teardown mode and creates the child cgroup (if any); call prior to fork()
+  void prepare(const std::string_view name);
+  // called in the forked child prior to execv() to join the tree (async-signal-safe)
+  void enter_child() const;
+  // called in the parent after fork() with the child's pid
+  void adopt(pid_t pid);
+  // confines the child cgroup to the given CPUs and memory nodes (cgroup teardown only)
+  bool set_cpuset(const std::string &cpus, const std::string &mems);
+  // sends SIGKILL to every process of the tree
+  void kill_all() const;
+  // true once the processes of the tree have terminated after kill_all(), reaping those that are children
+  // of the watchdog (children outside the tree are left alone); does not block, so it is polled
+  bool is_empty() const;
+  // removes the child cgroup (if any) once it is no longer populated
+  void release();
+
+  TEARDOWN teardown_mode() const { return mode; }
+  const std::string& cgroup_dir() const { return cgroup_path; }
+};
+
+// makes the watchdog a child subreaper so orphaned descendants of the JVM get reparented to it
+void become_subreaper();
+
+/**
+ * Reaps every terminated child process without blocking (orphans reparented
+ * to the watchdog included) so none are left as zombies.
+ *
+ * @param watched the pid of the child process of interest
+ * @param status receives the waitpid() status of watched should it be reaped
+ * @param usage receives the resource usage of watched should it be reaped (unless nullptr)
+ * @return true if the watched child process was reaped
+ */
+bool reap_children(pid_t watched, int &status, struct rusage *usage = nullptr);
+
+// reaps every terminated child process without blocking, reporting each to on_reaped (pid, waitpid() status, usage)
+void reap_children(const std::function<void(pid_t pid, int status, const struct rusage &usage)> &on_reaped);
+
+#endif //__PROC_TREE_H__
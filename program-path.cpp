@@ -0,0 +1,114 @@
+/* program-path.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <sys/stat.h>
+#include "format2str.h"
+#include "path-concat.h"
+#include "trace.h"
+#include "log.h"
+#include "program-path.h"
+
+using namespace logger;
+
+/**
+ * Returns the value string of a specified environment variable.
+ *
+ * @param name specified environment variable
+ * @return if environment variable exist then returns its string value, otherwise returns empty string
+ */
+static std::string get_env_var(const char * const name) {
+  char * const val = getenv(name);
+  return val != nullptr ? std::string(val) : std::string();
+}
+
+std::string find_program_path(const char * const prog, const char * const path_var_name, ACCEPT_ORDINAL ao) {
+  trace::span span{"find_program_path"};
+  const std::string path_env_var = get_env_var(path_var_name);
+
+  if (path_env_var.empty()) {
+    const char * const err_msg_fmt = "there is no %s environment variable defined";
+    throw find_program_path_exception(format2str(err_msg_fmt, path_var_name));
+  }
+
+  const char * const path_env_var_dup = strdupa(path_env_var.c_str());
+
+  static const char * const delim = ":";
+  char *save = nullptr;
+  const char * path = strtok_r(const_cast<char*>(path_env_var_dup), delim, &save);
+
+  std::string last_found_valid_path;
+  std::string full_path; // (reused for each directory, so only allocates when a longer path needs it)
+
+  for (int i = 0; path != nullptr;) {
+    log(LL::TRACE, "'%s'", path);
+    const std::string_view sv_path{path};
+    full_path.clear();
+    if (sv_path.back() == kPathSeparator) {
+      format_append(full_path, "%s%s", path, prog);
+    } else {
+      format_append(full_path, "%s%c%s", path, kPathSeparator, prog);
+    }
+    log(LL::TRACE, "'%s'", full_path.c_str());
+    // check to see if program file path exist
+    struct stat statbuf{0};
+    if (stat(full_path.c_str(), &statbuf) != -1 &&
+        ((statbuf.st_mode & S_IFMT) == S_IFREG || (statbuf.st_mode & S_IFMT) == S_IFLNK))
+    {
+      last_found_valid_path = full_path;
+      log(LL::DEBUG, "'%s'", last_found_valid_path.c_str());
+      bool matches_ao = false;
+      switch(++i) {
+        case 1:
+          matches_ao = ao == AO::FIRST_FOUND;
+          break;
+        case 2:
+          matches_ao = ao == AO::SECOND_FOUND;
+          break;
+        case 3:
+          matches_ao = ao == AO::THIRD_FOUND;
+          break;
+        case 4:
+          matches_ao = ao == AO::FOURTH_FOUND;
+          break;
+        case 5:
+          matches_ao = ao == AO::FIFTH_FOUND;
+          break;
+        case 6:
+          matches_ao = ao == AO::SIXTH_FOUND;
+          break;
+        case 7:
+          matches_ao = ao == AO::SEVENTH_FOUND;
+          break;
+      }
+      if (matches_ao) {
+        return last_found_valid_path;
+      }
+    }
+    path = strtok_r(nullptr, delim, &save);
+    if (ao == AO::LAST_FOUND && path == nullptr) {
+      return last_found_valid_path;
+    }
+  }
+
+  const char * const err_msg_fmt = "could not locate program '%s' via %s environment variable";
+  throw find_program_path_exception(format2str(err_msg_fmt, prog, path_var_name));
+}
@@ -0,0 +1,53 @@
+/* program-path.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __PROGRAM_PATH_H__
+#define __PROGRAM_PATH_H__
+
+#include <string>
+#include "decl-exception.h"
+
+DECL_EXCEPTION(find_program_path)
+
+enum class ACCEPT_ORDINAL : char {
+  FIRST_FOUND = 0,
+  SECOND_FOUND,
+  THIRD_FOUND,
+  FOURTH_FOUND,
+  FIFTH_FOUND,
+  SIXTH_FOUND,
+  SEVENTH_FOUND,
+  LAST_FOUND = -1,
+};
+using AO = ACCEPT_ORDINAL;
+
+/**
+ * Searches a specified environment variable (typically PATH), where assumes are
+ * directory paths seperated by the platform path separator character (e.g., ':').
+ * Looks for occurrence of the specified program. An ACCEPT_ORDINAL parameter is
+ * used to specify which occurrence to accept and return as the function's result.
+ *
+ * @param prog the program to search for
+ * @param path_var_name the environment path variable to search the directories of
+ * @param ao the ordinal sequence of any found occurrences of prog to be returned
+ * @return a found occurrence of prog; throws an exception if none found
+ */
+std::string find_program_path(const char * const prog, const char * const path_var_name, ACCEPT_ORDINAL ao);
+
+#endif //__PROGRAM_PATH_H__
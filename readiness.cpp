@@ -0,0 +1,306 @@
+/* readiness.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include "cgroup.h"
+#include "format2str.h"
+#include "log.h"
+#include "path-concat.h"
+#include "proc-stats.h"
+#include "trace.h"
+#include "readiness.h"
+
+using namespace logger;
+
+namespace {
+
+  struct listener {
+    uint16_t port;
+    uint64_t inode;
+  };
+
+  /**
+   * Builds the sock_diag dump request of TCP sockets in LISTEN state on any of
+   * the ports, both filters applied by the kernel: the state per the request's
+   * idiag_states, the ports per an INET_DIAG_REQ_BYTECODE program of, for each
+   * port, sport >= port && sport <= port - on to the next port's test
+   * otherwise, and a match jumping to the end (accept); falling off the last
+   * test jumps past the end (reject).
+   */
+  std::vector<char> make_listeners_request(const std::vector<uint16_t> &ports) {
+    const auto block_len = (uint32_t) (5 * sizeof(struct inet_diag_bc_op));
+    const auto code_len = (uint32_t) (block_len * ports.size());
+    std::vector<inet_diag_bc_op> code;
+    code.reserve(code_len / sizeof(struct inet_diag_bc_op));
+    for (size_t i = 0; i < ports.size(); i++) {
+      const auto offset = (uint32_t) (block_len * i);
+      const bool is_last = i + 1 == ports.size();
+      // (yes and no are byte offsets from the op; each port comparison is followed by an op holding the port)
+      code.push_back({INET_DIAG_BC_S_GE, 8, (unsigned short) (is_last ? code_len + 4 - offset : block_len)});
+      code.push_back({0, 0, ports[i]});
+      code.push_back({INET_DIAG_BC_S_LE, 8, (unsigned short) (is_last ? code_len + 4 - offset - 8 : block_len - 8)});
+      code.push_back({0, 0, ports[i]});
+      // (a jump is always taken via no; its yes leads the kernel's audit of the program on to the next op)
+      code.push_back({INET_DIAG_BC_JMP, 4, (unsigned short) (code_len - offset - 16)});
+    }
+
+    std::vector<char> request(NLMSG_LENGTH(sizeof(struct inet_diag_req_v2)) + NLA_HDRLEN + NLA_ALIGN(code_len));
+    const auto nlh = (struct nlmsghdr *) request.data();
+    nlh->nlmsg_len = (uint32_t) request.size();
+    nlh->nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    const auto req = (struct inet_diag_req_v2 *) NLMSG_DATA(nlh);
+    req->sdiag_protocol = IPPROTO_TCP;
+    req->idiag_states = 1U << TCP_LISTEN;
+    const auto attr = (struct nlattr *) (request.data() + NLMSG_LENGTH(sizeof(struct inet_diag_req_v2)));
+    attr->nla_type = INET_DIAG_REQ_BYTECODE;
+    attr->nla_len = (uint16_t) (NLA_HDRLEN + code_len);
+    memcpy((char *) attr + NLA_HDRLEN, code.data(), code_len);
+    return request;
+  }
+
+  // dumps the TCP listeners of a family per the request of make_listeners_request()
+  bool query_listeners(int diag_fd, uint8_t family, std::vector<char> &request, std::vector<listener> &listeners) {
+    ((struct inet_diag_req_v2 *) NLMSG_DATA((struct nlmsghdr *) request.data()))->sdiag_family = family;
+    if (send(diag_fd, request.data(), request.size(), 0) == -1) return false;
+
+    alignas(struct nlmsghdr) char buf[16 * 1024];
+    for (;;) {
+      const ssize_t n = recv(diag_fd, buf, sizeof(buf), 0);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      int len = (int) n;
+      for (auto nlh = (const struct nlmsghdr *) buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+        if (nlh->nlmsg_type == NLMSG_DONE) return true;
+        if (nlh->nlmsg_type == NLMSG_ERROR) return false;
+        const auto msg = (const struct inet_diag_msg *) NLMSG_DATA(nlh);
+        listeners.push_back({ntohs(msg->id.idiag_sport), msg->idiag_inode});
+      }
+    }
+  }
+
+  // true if the process holds a descriptor of the socket inode
+  bool holds_socket(pid_t pid, uint64_t inode) {
+    // (polled until ready, so formatted on the stack)
+    char fd_dir[32], target_buf[48];
+    format_to(fd_dir, "/proc/%d/fd", pid);
+    DIR * const dir = opendir(fd_dir);
+    if (dir == nullptr) return false;
+    const auto target = format_to(target_buf, "socket:[%lu]", (unsigned long) inode);
+    char link[64];
+    bool is_held = false;
+    for (const struct dirent *ent = readdir(dir); ent != nullptr && !is_held; ent = readdir(dir)) {
+      if (ent->d_name[0] == '.') continue;
+      const ssize_t n = readlinkat(dirfd(dir), ent->d_name, link, sizeof(link) - 1);
+      if (n > 0) {
+        link[n] = '\0';
+        is_held = target == link;
+      }
+    }
+    closedir(dir);
+    return is_held;
+  }
+
+  bool write_ready_file(const std::string &path, long ms) {
+    const auto tmp_path = path + ".tmp";
+    FILE * const file = fopen(tmp_path.c_str(), "we");
+    if (file == nullptr) return false;
+    fprintf(file, "%ld\n", ms);
+    if (fclose(file) != 0 || rename(tmp_path.c_str(), path.c_str()) != 0) {
+      unlink(tmp_path.c_str());
+      return false;
+    }
+    return true;
+  }
+
+}
+
+void readiness_detector::attach(event_loop &event_loop, pid_t child_pid, const process_tree &child_tree,
+                                output_relay *relay, int64_t launch_time_ns)
+{
+  if (!is_enabled()) return;
+  loop = &event_loop;
+  pid = child_pid;
+  tree = &child_tree;
+  launch_ns = launch_time_ns;
+  ready_ns = 0;
+  is_port_found.assign(cfg.ports.size(), false);
+  is_output_matched = cfg.output_match.empty();
+  output_carry.clear();
+  foreign_inodes.clear();
+
+  if (!cfg.ready_file.empty()) {
+    unlink(cfg.ready_file.c_str()); // left behind by a prior launch
+  }
+  if (!cfg.socket_path.empty()) {
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (cfg.socket_path.size() >= sizeof(addr.sun_path)) {
+      log(LL::WARN, "readiness socket path \"%s\" is too long", cfg.socket_path.c_str());
+      close(listen_fd);
+      listen_fd = -1;
+    } else if (listen_fd != -1) {
+      strcpy(addr.sun_path, cfg.socket_path.c_str());
+      unlink(addr.sun_path);
+      if (bind(listen_fd, (const struct sockaddr *) &addr, sizeof(addr)) == -1 || listen(listen_fd, 16) == -1) {
+        log(LL::WARN, "could not listen on readiness socket \"%s\": %s", cfg.socket_path.c_str(), strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+      } else {
+        loop->add_fd(listen_fd, EPOLLIN, [this](uint32_t) { serve_status(); });
+      }
+    }
+  }
+
+  if (!cfg.output_match.empty()) {
+    if (relay != nullptr) {
+      relay->add_listener([this](const std::string_view chunk) { on_output(chunk); });
+    } else {
+      log(LL::WARN, "readiness output_match requires [output] capture=true - ignored");
+      is_output_matched = true;
+    }
+  }
+
+  if (!cfg.ports.empty()) {
+    diag_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (diag_fd == -1) {
+      log(LL::WARN, "could not open sock_diag netlink socket - readiness ports ignored: %s", strerror(errno));
+      is_port_found.assign(cfg.ports.size(), true);
+    } else {
+      diag_request = make_listeners_request(cfg.ports);
+      poll_timer = loop->add_timer(cfg.poll_interval, [this]() { poll_listeners(); });
+    }
+  }
+  check_ready(); // e.g. output_match ignored and no ports
+}
+
+void readiness_detector::detach() {
+  if (loop != nullptr) {
+    if (poll_timer != -1) loop->cancel_timer(poll_timer);
+    if (listen_fd != -1) loop->remove_fd(listen_fd);
+    loop = nullptr;
+  }
+  poll_timer = -1;
+  if (diag_fd != -1) {
+    close(diag_fd);
+    diag_fd = -1;
+  }
+  if (listen_fd != -1) {
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(cfg.socket_path.c_str());
+  }
+  if (ready_ns != 0 && !cfg.ready_file.empty()) {
+    unlink(cfg.ready_file.c_str());
+  }
+}
+
+void readiness_detector::poll_listeners() {
+  std::vector<listener> listeners;
+  for (const uint8_t family : { AF_INET, AF_INET6 }) {
+    if (!query_listeners(diag_fd, family, diag_request, listeners)) {
+      log(LL::DEBUG, "sock_diag query of family %d failed: %s", (int) family, strerror(errno));
+    }
+  }
+  for (const auto &entry : listeners) {
+    for (size_t i = 0; i < cfg.ports.size(); i++) {
+      if (!is_port_found[i] && cfg.ports[i] == entry.port && is_tree_socket(entry.inode)) {
+        is_port_found[i] = true;
+        log(LL::DEBUG, "%s (pid:%d) listening on port %u", label.c_str(), pid, (unsigned) entry.port);
+      }
+    }
+  }
+  for (const bool is_found : is_port_found) {
+    if (!is_found) return;
+  }
+  loop->cancel_timer(poll_timer);
+  poll_timer = -1;
+  check_ready();
+}
+
+// a listener is the child's if a member of its process tree holds the socket
+bool readiness_detector::is_tree_socket(uint64_t inode) {
+  if (foreign_inodes.count(inode) > 0) return false;
+  std::vector<pid_t> pids{pid};
+  if (!tree->cgroup_dir().empty()) {
+    const auto procs = cgroup::read_file(path_concat(tree->cgroup_dir(), "cgroup.procs"));
+    for (const char *p = procs.c_str(); *p != '\0';) {
+      char *end = nullptr;
+      const auto member = (pid_t) strtol(p, &end, 10);
+      if (end == p) break;
+      if (member != pid) pids.push_back(member);
+      p = end;
+    }
+  }
+  for (const pid_t member : pids) {
+    if (holds_socket(member, inode)) return true;
+  }
+  foreign_inodes.insert(inode);
+  return false;
+}
+
+void readiness_detector::on_output(const std::string_view chunk) {
+  if (is_output_matched || loop == nullptr) return;
+  const auto &match = cfg.output_match;
+  output_carry.append(chunk);
+  if (output_carry.find(match) != std::string::npos) {
+    is_output_matched = true;
+    output_carry.clear();
+    check_ready();
+    return;
+  }
+  if (output_carry.size() >= match.size()) {
+    output_carry.erase(0, output_carry.size() - (match.size() - 1));
+  }
+}
+
+void readiness_detector::check_ready() {
+  if (ready_ns != 0 || !is_output_matched) return;
+  for (const bool is_found : is_port_found) {
+    if (!is_found) return;
+  }
+  ready_ns = monotonic_ns();
+  trace::instant("ready");
+  log(LL::INFO, "%s (pid:%d) ready; time to ready: %ld ms", label.c_str(), pid, time_to_ready_ms());
+  if (!cfg.ready_file.empty() && !write_ready_file(cfg.ready_file, time_to_ready_ms())) {
+    log(LL::WARN, "could not write readiness file \"%s\": %s", cfg.ready_file.c_str(), strerror(errno));
+  }
+}
+
+void readiness_detector::serve_status() {
+  for (;;) {
+    const int conn_fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (conn_fd == -1) return;
+    const auto status = is_ready() ? format2str("ready %ld\n", time_to_ready_ms()) : std::string("starting\n");
+    send(conn_fd, status.data(), status.size(), MSG_NOSIGNAL);
+    close(conn_fd);
+  }
+}
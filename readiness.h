@@ -0,0 +1,98 @@
+/* readiness.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __READINESS_H__
+#define __READINESS_H__
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+#include "output-relay.h"
+#include "proc-tree.h"
+
+/**
+ * Detects when the child JVM is ready to serve: its process tree listens on
+ * every configured TCP port and (optionally) its captured output contains a
+ * readiness line.
+ * <p>
+ * Listening sockets are found with NETLINK_SOCK_DIAG queries filtered in the
+ * kernel to the LISTEN state and the configured ports, so the cost grows with
+ * neither the number of established connections (the way reading
+ * /proc/net/tcp does) nor that of the node's other listeners. The kernel
+ * offers no notification of a socket entering LISTEN, hence the query runs on
+ * an event loop timer until the ports are all found. A listener is only
+ * credited to the child if its socket inode is held open by the child (or,
+ * with cgroup teardown, by any process of the child's cgroup).
+ * <p>
+ * Readiness is published as a file and/or a unix socket for health checks.
+ */
+class readiness_detector {
+private:
+  const readiness_settings &cfg;
+  const std::string &label;           // how logging refers to the JVM
+  pid_t pid{0};
+  const process_tree *tree{nullptr};
+  event_loop *loop{nullptr};
+  int64_t launch_ns{0};
+  int64_t ready_ns{0};
+  int diag_fd{-1};
+  std::vector<char> diag_request;     // the sock_diag query of the ports' listeners
+  int listen_fd{-1};
+  int poll_timer{-1};
+  std::vector<bool> is_port_found;
+  bool is_output_matched{false};
+  std::string output_carry;           // tail of the previous output chunk (a match may straddle chunks)
+  std::unordered_set<uint64_t> foreign_inodes; // listeners on a configured port held by other processes
+  void poll_listeners();
+  bool is_tree_socket(uint64_t inode);
+  void on_output(const std::string_view chunk);
+  void check_ready();
+  void serve_status();
+public:
+  // (label must outlive the detector)
+  readiness_detector(const readiness_settings &cfg, const std::string &label) : cfg{cfg}, label{label} {}
+  readiness_detector(const readiness_detector &) = delete;
+  readiness_detector& operator=(const readiness_detector &) = delete;
+  ~readiness_detector() { detach(); }
+
+  bool is_enabled() const { return !cfg.ports.empty() || !cfg.output_match.empty(); }
+
+  /**
+   * Starts detecting readiness of a launched child process; call in the parent after fork().
+   *
+   * @param loop the event loop supervising the child
+   * @param pid the child process
+   * @param tree the process tree of the child (its members may hold the listening sockets)
+   * @param relay the captured output of the child (nullptr if not captured)
+   * @param launch_ns monotonic time of the launch, from which time-to-ready is measured
+   */
+  void attach(event_loop &loop, pid_t pid, const process_tree &tree, output_relay *relay, int64_t launch_ns);
+  // stops detecting and withdraws the readiness file and socket (the child has terminated)
+  void detach();
+
+  bool is_ready() const { return ready_ns != 0; }
+  // milliseconds from launch to ready (-1 if not ready)
+  long time_to_ready_ms() const { return is_ready() ? (long) ((ready_ns - launch_ns) / 1000000) : -1; }
+};
+
+#endif //__READINESS_H__
@@ -0,0 +1,1019 @@
+/* settings.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/un.h>
+#include "log.h"
+#include "settings.h"
+
+using namespace logger;
+
+static std::string to_lower(const std::string_view value) {
+  std::string str{value};
+  std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+  return str;
+}
+
+bool cfg_to_bool(const std::string_view value, bool &result) {
+  const auto str = to_lower(value);
+  if (str == "true" || str == "yes" || str == "on" || str == "1") {
+    result = true;
+    return true;
+  }
+  if (str == "false" || str == "no" || str == "off" || str == "0") {
+    result = false;
+    return true;
+  }
+  return false;
+}
+
+bool cfg_to_size(const std::string_view value, uint64_t &result) {
+  const std::string str{value};
+  char *end = nullptr;
+  errno = 0;
+  const auto n = strtoull(str.c_str(), &end, 10);
+  if (errno != 0 || end == str.c_str()) return false;
+  uint64_t scale = 1;
+  switch (::tolower(*end)) {
+    case '\0': break;
+    case 'k': scale = 1024ULL; end++; break;
+    case 'm': scale = 1024ULL * 1024; end++; break;
+    case 'g': scale = 1024ULL * 1024 * 1024; end++; break;
+    default: return false;
+  }
+  if (::tolower(*end) == 'b') end++;
+  if (*end != '\0') return false;
+  result = n * scale;
+  return true;
+}
+
+bool cfg_to_duration(const std::string_view value, milliseconds &result) {
+  const std::string str{value};
+  char *end = nullptr;
+  errno = 0;
+  const auto n = strtoull(str.c_str(), &end, 10);
+  if (errno != 0 || end == str.c_str()) return false;
+  const auto unit = to_lower(end);
+  if (unit.empty() || unit == "s") {
+    result = milliseconds(n * 1000);
+  } else if (unit == "ms") {
+    result = milliseconds(n);
+  } else if (unit == "m") {
+    result = milliseconds(n * 60 * 1000);
+  } else if (unit == "h") {
+    result = milliseconds(n * 60 * 60 * 1000);
+  } else if (unit == "d") {
+    result = milliseconds(n * 24 * 60 * 60 * 1000);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static void warn_invalid(const char * const section, const std::string_view name, const std::string_view value) {
+  log(LL::WARN, "invalid config section %s %s value '%s' ignored - using default",
+      section, std::string(name).c_str(), std::string(value).c_str());
+}
+
+bool parse_metrics_setting(const std::string_view name, const std::string_view value, metrics_settings &settings) {
+  static const char * const section = "metrics";
+  uint64_t size = 0;
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "sample_interval") {
+    if (!cfg_to_duration(value, settings.sample_interval) || settings.sample_interval.count() < 10) {
+      settings.sample_interval = metrics_settings{}.sample_interval;
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "ring_budget") {
+    if (cfg_to_size(value, size) && size >= 16 * 1024) {
+      settings.ring_budget = size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "postmortem_window") {
+    if (!cfg_to_duration(value, settings.postmortem_window)) warn_invalid(section, name, value);
+  } else if (name == "postmortem_dir") {
+    settings.postmortem_dir = value;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_output_setting(const std::string_view name, const std::string_view value, output_settings &settings) {
+  static const char * const section = "output";
+  uint64_t size = 0;
+  if (name == "capture") {
+    if (!cfg_to_bool(value, settings.capture)) warn_invalid(section, name, value);
+  } else if (name == "tail_size") {
+    if (cfg_to_size(value, size) && size > 0) {
+      settings.tail_size = size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_crash_setting(const std::string_view name, const std::string_view value, crash_settings &settings) {
+  static const char * const section = "crash";
+  uint64_t size = 0;
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "bundle_dir") {
+    settings.bundle_dir = value;
+  } else if (name == "threads") {
+    if (cfg_to_size(value, size) && size <= 256) {
+      settings.threads = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "chunk_size") {
+    if (cfg_to_size(value, size) && size >= 64 * 1024) {
+      settings.chunk_size = size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "compression_level") {
+    if (cfg_to_size(value, size) && size >= 1 && size <= 9) {
+      settings.compression_level = (int) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "disk_budget") {
+    if (!cfg_to_size(value, settings.disk_budget)) warn_invalid(section, name, value);
+  } else if (name == "min_free_space") {
+    if (!cfg_to_size(value, settings.min_free_space)) warn_invalid(section, name, value);
+  } else if (name == "max_bundles") {
+    if (cfg_to_size(value, size) && size >= 1) {
+      settings.max_bundles = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "keep_heap_dump") {
+    if (!cfg_to_bool(value, settings.keep_heap_dump)) warn_invalid(section, name, value);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_shutdown_setting(const std::string_view name, const std::string_view value, shutdown_settings &settings) {
+  static const char * const section = "shutdown";
+  uint64_t size = 0;
+  if (name == "timeout") {
+    if (!cfg_to_duration(value, settings.timeout)) warn_invalid(section, name, value);
+  } else if (name == "thread_dump_wait") {
+    if (!cfg_to_duration(value, settings.thread_dump_wait)) warn_invalid(section, name, value);
+  } else if (name == "deadline_exit_status") {
+    if (cfg_to_size(value, size) && size >= 1 && size <= 255) {
+      settings.deadline_exit_status = (int) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_process_tree_setting(const std::string_view name, const std::string_view value,
+                                process_tree_settings &settings)
+{
+  static const char * const section = "process_tree";
+  if (name == "subreaper") {
+    if (!cfg_to_bool(value, settings.subreaper)) warn_invalid(section, name, value);
+  } else if (name == "teardown") {
+    const auto str = to_lower(value);
+    if (str == "auto") {
+      settings.teardown = TEARDOWN::AUTO;
+    } else if (str == "cgroup") {
+      settings.teardown = TEARDOWN::CGROUP;
+    } else if (str == "process_group") {
+      settings.teardown = TEARDOWN::PROCESS_GROUP;
+    } else if (str == "none") {
+      settings.teardown = TEARDOWN::NONE;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_numa_setting(const std::string_view name, const std::string_view value, numa_settings &settings) {
+  static const char * const section = "numa";
+  uint64_t size = 0;
+  if (name == "node") {
+    const auto str = to_lower(value);
+    if (str == "none") {
+      settings.node = numa_settings::node_none;
+    } else if (str == "auto") {
+      settings.node = numa_settings::node_auto;
+    } else if (cfg_to_size(value, size) && size < 1024) {
+      settings.node = (int) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "memory_policy") {
+    const auto str = to_lower(value);
+    if (str == "none") {
+      settings.memory_policy = MEMORY_POLICY::NONE;
+    } else if (str == "preferred") {
+      settings.memory_policy = MEMORY_POLICY::PREFERRED;
+    } else if (str == "bind") {
+      settings.memory_policy = MEMORY_POLICY::BIND;
+    } else if (str == "interleave") {
+      settings.memory_policy = MEMORY_POLICY::INTERLEAVE;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "bind_cpus") {
+    if (!cfg_to_bool(value, settings.bind_cpus)) warn_invalid(section, name, value);
+  } else if (name == "cpuset") {
+    if (!cfg_to_bool(value, settings.cpuset)) warn_invalid(section, name, value);
+  } else if (name == "lock_dir") {
+    settings.lock_dir = value;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_cds_setting(const std::string_view name, const std::string_view value, cds_settings &settings) {
+  static const char * const section = "cds";
+  uint64_t size = 0;
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "archive_dir") {
+    settings.archive_dir = value;
+  } else if (name == "max_archives") {
+    if (cfg_to_size(value, size) && size >= 1) {
+      settings.max_archives = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "dump_timeout") {
+    if (!cfg_to_duration(value, settings.dump_timeout)) warn_invalid(section, name, value);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_prewarm_setting(const std::string_view name, const std::string_view value, prewarm_settings &settings) {
+  static const char * const section = "prewarm";
+  uint64_t size = 0;
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "threads") {
+    if (cfg_to_size(value, size) && size >= 1 && size <= 64) {
+      settings.threads = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "io_budget") {
+    if (!cfg_to_size(value, settings.io_budget)) warn_invalid(section, name, value);
+  } else if (name == "paths") {
+    settings.paths = value;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_trace_setting(const std::string_view name, const std::string_view value, trace_settings &settings) {
+  static const char * const section = "trace";
+  uint64_t size = 0;
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "file") {
+    settings.file = value;
+  } else if (name == "buffer_events") {
+    if (cfg_to_size(value, size) && size >= 64 && size <= 16 * 1024 * 1024) {
+      settings.buffer_events = size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_stats_setting(const std::string_view name, const std::string_view value, stats_settings &settings) {
+  static const char * const section = "stats";
+  milliseconds interval{0};
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "dir") {
+    settings.dir = value;
+  } else if (name == "interval") {
+    if (cfg_to_duration(value, interval) && interval >= milliseconds(10)) {
+      settings.interval = interval;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_readiness_setting(const std::string_view name, const std::string_view value, readiness_settings &settings) {
+  static const char * const section = "readiness";
+  if (name == "ports") {
+    std::vector<uint16_t> ports;
+    size_t pos = 0;
+    while (pos <= value.size()) {
+      auto comma = value.find(',', pos);
+      if (comma == std::string_view::npos) comma = value.size();
+      auto item = value.substr(pos, comma - pos);
+      while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+      while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+      if (!item.empty()) {
+        const std::string str{item};
+        char *end = nullptr;
+        const auto port = strtoul(str.c_str(), &end, 10);
+        if (*end != '\0' || port == 0 || port > 65535) {
+          warn_invalid(section, name, value);
+          return true;
+        }
+        ports.push_back((uint16_t) port);
+      }
+      pos = comma + 1;
+    }
+    settings.ports = std::move(ports);
+  } else if (name == "output_match") {
+    settings.output_match = value;
+  } else if (name == "poll_interval") {
+    milliseconds interval{0};
+    if (cfg_to_duration(value, interval) && interval.count() >= 10) {
+      settings.poll_interval = interval;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "ready_file") {
+    settings.ready_file = value;
+  } else if (name == "socket") {
+    settings.socket_path = value;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_hang_setting(const std::string_view name, const std::string_view value, hang_settings &settings) {
+  static const char * const section = "hang";
+  uint64_t size = 0;
+  milliseconds interval{0};
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "check_interval") {
+    if (cfg_to_duration(value, interval) && interval.count() >= 100) {
+      settings.check_interval = interval;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "timeout") {
+    if (cfg_to_duration(value, interval) && interval.count() > 0) {
+      settings.timeout = interval;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "heartbeat_file") {
+    settings.heartbeat_file = value;
+  } else if (name == "heartbeat_socket") {
+    settings.heartbeat_socket = value;
+  } else if (name == "gc_thrash_pct") {
+    if (cfg_to_size(value, size) && size <= 100) {
+      settings.gc_thrash_pct = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "thread_dump_wait") {
+    if (!cfg_to_duration(value, settings.thread_dump_wait)) warn_invalid(section, name, value);
+  } else if (name == "action") {
+    const auto str = to_lower(value);
+    if (str == "exit") {
+      settings.action = HANG_ACTION::EXIT;
+    } else if (str == "restart") {
+      settings.action = HANG_ACTION::RESTART;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "max_restarts") {
+    if (cfg_to_size(value, size) && size <= 1000) {
+      settings.max_restarts = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_leak_setting(const std::string_view name, const std::string_view value, leak_settings &settings) {
+  static const char * const section = "leak";
+  milliseconds interval{0};
+  const auto to_interval = [&](milliseconds min_interval, milliseconds &result) {
+    if (cfg_to_duration(value, interval) && interval >= min_interval) {
+      result = interval;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  };
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "sample_interval") {
+    to_interval(milliseconds(1000), settings.sample_interval);
+  } else if (name == "window") {
+    to_interval(milliseconds(60 * 1000), settings.window);
+  } else if (name == "min_slope") {
+    if (!cfg_to_size(value, settings.min_slope)) warn_invalid(section, name, value);
+  } else if (name == "alert_horizon") {
+    to_interval(milliseconds(60 * 1000), settings.alert_horizon);
+  } else if (name == "alert_interval") {
+    to_interval(milliseconds(1000), settings.alert_interval);
+  } else if (name == "nmt") {
+    if (!cfg_to_bool(value, settings.nmt)) warn_invalid(section, name, value);
+  } else if (name == "nmt_interval") {
+    to_interval(milliseconds(60 * 1000), settings.nmt_interval);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_malloc_setting(const std::string_view name, const std::string_view value, malloc_settings &settings) {
+  static const char * const section = "malloc";
+  // a size, or auto (computed), or unset (left to the allocator's own default)
+  const auto to_value = [&](int64_t &result) {
+    const auto str = to_lower(value);
+    uint64_t size = 0;
+    if (str == "auto") {
+      result = malloc_settings::value_auto;
+    } else if (str == "unset" || str == "none") {
+      result = malloc_settings::value_unset;
+    } else if (cfg_to_size(value, size) && size <= (uint64_t) INT64_MAX) {
+      result = (int64_t) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  };
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "allocator") {
+    const auto str = to_lower(value);
+    if (str == "glibc") {
+      settings.allocator = ALLOCATOR::GLIBC;
+    } else if (str == "jemalloc") {
+      settings.allocator = ALLOCATOR::JEMALLOC;
+    } else if (str == "tcmalloc") {
+      settings.allocator = ALLOCATOR::TCMALLOC;
+    } else if (str == "auto") {
+      settings.allocator = ALLOCATOR::AUTO;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "allocator_path") {
+    settings.allocator_path = value;
+  } else if (name == "arena_max") {
+    to_value(settings.arena_max);
+  } else if (name == "trim_threshold") {
+    to_value(settings.trim_threshold);
+  } else if (name == "mmap_threshold") {
+    to_value(settings.mmap_threshold);
+  } else if (name == "tcache_count") {
+    to_value(settings.tcache_count);
+  } else if (name == "report_file") {
+    settings.report_file = value;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_throttle_setting(const std::string_view name, const std::string_view value, throttle_settings &settings) {
+  static const char * const section = "throttle";
+  uint64_t size = 0;
+  milliseconds interval{0};
+  const auto to_interval = [&](milliseconds min_interval, milliseconds &result) {
+    if (cfg_to_duration(value, interval) && interval >= min_interval) {
+      result = interval;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  };
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "sample_interval") {
+    to_interval(milliseconds(100), settings.sample_interval);
+  } else if (name == "window") {
+    to_interval(milliseconds(1000), settings.window);
+  } else if (name == "threshold_pct") {
+    if (cfg_to_size(value, size) && size > 0 && size <= 100) {
+      settings.threshold_pct = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "alert_interval") {
+    to_interval(milliseconds(1000), settings.alert_interval);
+  } else if (name == "recommend_file") {
+    settings.recommend_file = value;
+  } else if (name == "apply") {
+    if (!cfg_to_bool(value, settings.apply)) warn_invalid(section, name, value);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_tuning_setting(const std::string_view name, const std::string_view value, tuning_settings &settings) {
+  static const char * const section = "tuning";
+  uint64_t size = 0;
+  milliseconds interval{0};
+  const auto to_interval = [&](milliseconds min_interval, milliseconds &result) {
+    if (cfg_to_duration(value, interval) && interval >= min_interval) {
+      result = interval;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  };
+  const auto to_pct = [&](unsigned &result) {
+    if (cfg_to_size(value, size) && size > 0 && size <= 100) {
+      result = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  };
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "state_file") {
+    settings.state_file = value;
+  } else if (name == "apply") {
+    if (!cfg_to_bool(value, settings.apply)) warn_invalid(section, name, value);
+  } else if (name == "sample_interval") {
+    to_interval(milliseconds(100), settings.sample_interval);
+  } else if (name == "min_uptime") {
+    to_interval(milliseconds(0), settings.min_uptime);
+  } else if (name == "pause_target") {
+    to_interval(milliseconds(1), settings.pause_target);
+  } else if (name == "gc_overhead_pct") {
+    to_pct(settings.gc_overhead_pct);
+  } else if (name == "throttle_pct") {
+    to_pct(settings.throttle_pct);
+  } else if (name == "step_pct") {
+    to_pct(settings.step_pct);
+  } else if (name == "memory_pct") {
+    to_pct(settings.memory_pct);
+  } else if (name == "min_heap") {
+    if (!cfg_to_size(value, settings.min_heap)) warn_invalid(section, name, value);
+  } else if (name == "max_heap") {
+    if (!cfg_to_size(value, settings.max_heap)) warn_invalid(section, name, value);
+  } else if (name == "max_code_cache") {
+    if (!cfg_to_size(value, settings.max_code_cache)) warn_invalid(section, name, value);
+  } else if (name == "max_gc_threads") {
+    if (cfg_to_size(value, size) && size <= 1024) {
+      settings.max_gc_threads = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_syslog_setting(const std::string_view name, const std::string_view value, syslog_settings &settings) {
+  static const char * const section = "syslog";
+  static const char * const facilities[] = {
+      "kern", "user", "mail", "daemon", "auth", "syslog", "lpr", "news", "uucp", "cron", "authpriv", "ftp",
+      nullptr, nullptr, nullptr, nullptr, "local0", "local1", "local2", "local3", "local4", "local5", "local6", "local7",
+  };
+  uint64_t size = 0;
+  milliseconds interval{0};
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "socket") {
+    settings.socket = value;
+  } else if (name == "format") {
+    const auto str = to_lower(value);
+    if (str == "auto") {
+      settings.format = SYSLOG_FORMAT::AUTO;
+    } else if (str == "rfc5424") {
+      settings.format = SYSLOG_FORMAT::RFC5424;
+    } else if (str == "journald") {
+      settings.format = SYSLOG_FORMAT::JOURNALD;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "facility") {
+    const auto str = to_lower(value);
+    const auto it = std::find_if(std::begin(facilities), std::end(facilities),
+                                 [&str](const char *facility) { return facility != nullptr && str == facility; });
+    if (it != std::end(facilities)) {
+      settings.facility = (int) (it - std::begin(facilities));
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "level") {
+    const auto str = to_lower(value);
+    if (str == "fatal" || str == "error" || str == "warn" || str == "info" || str == "debug") {
+      settings.level = str == "error" ? logger::LL::ERR : logger::str_to_level(str);
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "rate") {
+    if (cfg_to_size(value, size) && size <= 100000) {
+      settings.rate = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "burst") {
+    if (cfg_to_size(value, size) && size > 0 && size <= 100000) {
+      settings.burst = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "dedup_window") {
+    if (!cfg_to_duration(value, settings.dedup_window)) warn_invalid(section, name, value);
+  } else if (name == "batch_size") {
+    if (cfg_to_size(value, size) && size > 0 && size <= 256) {
+      settings.batch_size = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "flush_interval") {
+    if (cfg_to_duration(value, interval) && interval.count() >= 10) {
+      settings.flush_interval = interval;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::string> split_command_line(const std::string_view line) {
+  std::vector<std::string> args;
+  std::string arg;
+  bool is_arg = false;
+  char quote = '\0';
+  for (size_t i = 0; i < line.size(); i++) {
+    const char c = line[i];
+    if (quote != '\0') {
+      if (c == quote) {
+        quote = '\0';
+      } else if (c == '\\' && quote == '"' && i + 1 < line.size()) {
+        arg += line[++i];
+      } else {
+        arg += c;
+      }
+    } else if (c == '\'' || c == '"') {
+      quote = c;
+      is_arg = true;
+    } else if (c == '\\' && i + 1 < line.size()) {
+      arg += line[++i];
+      is_arg = true;
+    } else if (c == ' ' || c == '\t') {
+      if (is_arg) args.push_back(std::move(arg));
+      arg.clear();
+      is_arg = false;
+    } else {
+      arg += c;
+      is_arg = true;
+    }
+  }
+  if (is_arg) args.push_back(std::move(arg));
+  return args;
+}
+
+bool parse_arbiter_setting(const std::string_view name, const std::string_view value, arbiter_settings &settings) {
+  static const char * const section = "arbiter";
+  uint64_t size = 0;
+  milliseconds interval{0};
+  const auto to_pct = [&](unsigned &result) {
+    if (cfg_to_size(value, size) && size > 0 && size <= 100) {
+      result = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  };
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "socket") {
+    if (!value.empty() && value.size() < sizeof(sockaddr_un::sun_path)) {
+      settings.socket = value;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "name") {
+    settings.name = value;
+  } else if (name == "priority") {
+    const std::string str{value};
+    char *end = nullptr;
+    const long priority = strtol(str.c_str(), &end, 10);
+    if (end != str.c_str() && *end == '\0' && priority >= -1000 && priority <= 1000) {
+      settings.priority = (int) priority;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "report_interval") {
+    if (cfg_to_duration(value, interval) && interval >= milliseconds(100)) {
+      settings.report_interval = interval;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "memory_limit") {
+    if (!cfg_to_size(value, settings.memory_limit)) warn_invalid(section, name, value);
+  } else if (name == "high_pct") {
+    to_pct(settings.high_pct);
+  } else if (name == "low_pct") {
+    to_pct(settings.low_pct);
+  } else if (name == "shed_interval") {
+    if (!cfg_to_duration(value, settings.shed_interval)) warn_invalid(section, name, value);
+  } else if (name == "shed_commands") {
+    settings.shed_commands = value;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_control_setting(const std::string_view name, const std::string_view value, control_settings &settings) {
+  static const char * const section = "control";
+  // comma separated uids or gids
+  const auto to_ids = [&](std::vector<uint32_t> &result) {
+    std::vector<uint32_t> ids;
+    size_t pos = 0;
+    while (pos <= value.size()) {
+      auto comma = value.find(',', pos);
+      if (comma == std::string_view::npos) comma = value.size();
+      auto item = value.substr(pos, comma - pos);
+      while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+      while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+      if (!item.empty()) {
+        const std::string str{item};
+        char *end = nullptr;
+        errno = 0;
+        const auto id = strtoul(str.c_str(), &end, 10);
+        if (*end != '\0' || errno != 0 || id > UINT32_MAX) {
+          warn_invalid(section, name, value);
+          return;
+        }
+        ids.push_back((uint32_t) id);
+      }
+      pos = comma + 1;
+    }
+    result = std::move(ids);
+  };
+  if (name == "enabled") {
+    if (!cfg_to_bool(value, settings.enabled)) warn_invalid(section, name, value);
+  } else if (name == "socket") {
+    settings.socket = value;
+  } else if (name == "allow_uids") {
+    to_ids(settings.allow_uids);
+  } else if (name == "allow_gids") {
+    to_ids(settings.allow_gids);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_listen_setting(const std::string_view name, const std::string_view value, listen_settings &settings) {
+  static const char * const section = "listen";
+  uint64_t size = 0;
+  if (name == "sockets") {
+    // comma separated [NAME=]ADDRESS items
+    std::vector<listen_socket> sockets;
+    size_t pos = 0;
+    while (pos <= value.size()) {
+      auto comma = value.find(',', pos);
+      if (comma == std::string_view::npos) comma = value.size();
+      auto item = value.substr(pos, comma - pos);
+      while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+      while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+      if (!item.empty()) {
+        listen_socket socket;
+        const auto eq = item.find('=');
+        socket.name = eq != std::string_view::npos ? item.substr(0, eq) : "";
+        socket.address = eq != std::string_view::npos ? item.substr(eq + 1) : item;
+        if (socket.name.empty()) socket.name = "listen" + std::to_string(sockets.size());
+        // (LISTEN_FDNAMES is colon separated)
+        if (socket.address.empty() || socket.name.find(':') != std::string::npos) {
+          warn_invalid(section, name, value);
+          return true;
+        }
+        sockets.push_back(std::move(socket));
+      }
+      pos = comma + 1;
+    }
+    settings.sockets = std::move(sockets);
+  } else if (name == "backlog") {
+    if (cfg_to_size(value, size) && size > 0 && size <= 65535) {
+      settings.backlog = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "inherited_channel") {
+    if (!cfg_to_bool(value, settings.inherited_channel)) warn_invalid(section, name, value);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_process_setting(const std::string_view name, const std::string_view value, process_settings &settings) {
+  static const char * const section = "process";
+  static const char * const ordinals[] = {
+      "first_found", "second_found", "third_found", "fourth_found", "fifth_found", "sixth_found", "seventh_found",
+  };
+  uint64_t size = 0;
+  if (name == "args") {
+    settings.args = split_command_line(value);
+  } else if (name == "accept_ordinal") {
+    const auto str = to_lower(value);
+    const auto it = std::find(std::begin(ordinals), std::end(ordinals), str);
+    if (it != std::end(ordinals)) {
+      settings.ordinal = (int) (it - std::begin(ordinals));
+    } else if (str == "last_found") {
+      settings.ordinal = -1;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "restart") {
+    const auto str = to_lower(value);
+    if (str == "never") {
+      settings.restart = RESTART_POLICY::NEVER;
+    } else if (str == "on_failure" || str == "on-failure") {
+      settings.restart = RESTART_POLICY::ON_FAILURE;
+    } else if (str == "always") {
+      settings.restart = RESTART_POLICY::ALWAYS;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "max_restarts") {
+    if (cfg_to_size(value, size) && size <= 1000000) {
+      settings.max_restarts = (unsigned) size;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "restart_delay") {
+    if (!cfg_to_duration(value, settings.restart_delay)) warn_invalid(section, name, value);
+  } else if (name == "cpus") {
+    settings.cpus = value;
+  } else if (name == "order") {
+    const std::string str{value};
+    char *end = nullptr;
+    const long order = strtol(str.c_str(), &end, 10);
+    if (end != str.c_str() && *end == '\0' && order >= -1000 && order <= 1000) {
+      settings.order = (int) order;
+    } else {
+      warn_invalid(section, name, value);
+    }
+  } else if (name == "required") {
+    if (!cfg_to_bool(value, settings.required)) warn_invalid(section, name, value);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// a condition of an optional comparison operator and a number (or size) - e.g. ">=17", "<4g" or "8"
+static bool cfg_to_condition(const std::string_view value, bool is_size, rewrite_condition &result) {
+  static const std::pair<const char*, COMPARISON> operators[] = {
+      { "<=", COMPARISON::LE }, { ">=", COMPARISON::GE }, { "!=", COMPARISON::NE }, { "==", COMPARISON::EQ },
+      { "<", COMPARISON::LT }, { ">", COMPARISON::GT }, { "=", COMPARISON::EQ },
+  };
+  auto str = value;
+  auto op = COMPARISON::EQ;
+  for (const auto &[text, comparison] : operators) {
+    if (str.compare(0, strlen(text), text) == 0) {
+      op = comparison;
+      str.remove_prefix(strlen(text));
+      break;
+    }
+  }
+  while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) str.remove_prefix(1);
+  if (is_size) {
+    uint64_t size = 0;
+    if (!cfg_to_size(str, size)) return false;
+    result = { op, (double) size };
+    return true;
+  }
+  const std::string num{str};
+  char *end = nullptr;
+  const double number = strtod(num.c_str(), &end);
+  if (num.empty() || *end != '\0') return false;
+  result = { op, number };
+  return true;
+}
+
+bool parse_rewrite_setting(const std::string_view name, const std::string_view value, rewrite_settings &settings) {
+  static const char * const section = "rewrite";
+  // the option lists accumulate over repeated lines (quoting as in [process.NAME] args)
+  const auto append = [&value](std::vector<std::string> &list) {
+    for (auto &arg : split_command_line(value)) {
+      list.push_back(std::move(arg));
+    }
+  };
+  if (name == "process") {
+    settings.process = value;
+  } else if (name == "when_jdk") {
+    if (!cfg_to_condition(value, false, settings.jdk)) warn_invalid(section, name, value);
+  } else if (name == "when_memory") {
+    if (!cfg_to_condition(value, true, settings.memory)) warn_invalid(section, name, value);
+  } else if (name == "when_cpus") {
+    if (!cfg_to_condition(value, false, settings.cpus)) warn_invalid(section, name, value);
+  } else if (name == "when_env") {
+    append(settings.env);
+  } else if (name == "remove") {
+    append(settings.remove);
+  } else if (name == "set") {
+    append(settings.set);
+  } else if (name == "add") {
+    append(settings.add);
+  } else if (name == "dedupe") {
+    if (!cfg_to_bool(value, settings.dedupe)) warn_invalid(section, name, value);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parse_section_setting(const std::string_view section, const std::string_view name, const std::string_view value,
+                           watchdog_settings &settings)
+{
+  if (section == "metrics")  return parse_metrics_setting(name, value, settings.metrics);
+  if (section == "output")   return parse_output_setting(name, value, settings.output);
+  if (section == "crash")    return parse_crash_setting(name, value, settings.crash);
+  if (section == "shutdown") return parse_shutdown_setting(name, value, settings.shutdown);
+  if (section == "process_tree") return parse_process_tree_setting(name, value, settings.process_tree);
+  if (section == "numa")     return parse_numa_setting(name, value, settings.numa);
+  if (section == "cds")      return parse_cds_setting(name, value, settings.cds);
+  if (section == "prewarm")  return parse_prewarm_setting(name, value, settings.prewarm);
+  if (section == "trace")    return parse_trace_setting(name, value, settings.trace);
+  if (section == "stats")    return parse_stats_setting(name, value, settings.stats);
+  if (section == "readiness") return parse_readiness_setting(name, value, settings.readiness);
+  if (section == "hang")     return parse_hang_setting(name, value, settings.hang);
+  if (section == "leak")     return parse_leak_setting(name, value, settings.leak);
+  if (section == "malloc")   return parse_malloc_setting(name, value, settings.malloc);
+  if (section == "throttle") return parse_throttle_setting(name, value, settings.throttle);
+  if (section == "tuning")   return parse_tuning_setting(name, value, settings.tuning);
+  if (section == "syslog")   return parse_syslog_setting(name, value, settings.syslog);
+  if (section == "arbiter")  return parse_arbiter_setting(name, value, settings.arbiter);
+  if (section == "control")  return parse_control_setting(name, value, settings.control);
+  if (section == "listen")   return parse_listen_setting(name, value, settings.listen);
+  if (section.compare(0, 8, "process.") == 0 && section.size() > 8) {
+    // each [process.NAME] section adds a JVM
+    const auto process_name = section.substr(8);
+    auto it = std::find_if(settings.processes.begin(), settings.processes.end(),
+                           [&process_name](const process_settings &process) { return process.name == process_name; });
+    if (it == settings.processes.end()) {
+      settings.processes.emplace_back();
+      it = settings.processes.end() - 1;
+      it->name = process_name;
+    }
+    return parse_process_setting(name, value, *it);
+  }
+  if (section.compare(0, 8, "rewrite.") == 0 && section.size() > 8) {
+    // each [rewrite.NAME] section adds a rule
+    const auto rule_name = section.substr(8);
+    auto it = std::find_if(settings.rewrites.begin(), settings.rewrites.end(),
+                           [&rule_name](const rewrite_settings &rule) { return rule.name == rule_name; });
+    if (it == settings.rewrites.end()) {
+      settings.rewrites.emplace_back();
+      it = settings.rewrites.end() - 1;
+      it->name = rule_name;
+    }
+    return parse_rewrite_setting(name, value, *it);
+  }
+  return false;
+}
@@ -0,0 +1,400 @@
+/* settings.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __SETTINGS_H__
+#define __SETTINGS_H__
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "log.h"
+
+using std::chrono::milliseconds;
+
+// [metrics] section of config.ini
+struct metrics_settings {
+  bool enabled = false;
+  milliseconds sample_interval{1000};
+  size_t ring_budget = 256 * 1024;        // bytes of compressed samples retained in memory
+  milliseconds postmortem_window{5 * 60 * 1000};
+  std::string postmortem_dir;             // empty means next to the JVM crash log
+};
+
+// [output] section of config.ini
+struct output_settings {
+  bool capture = false;                   // relay child stdout/stderr through pipes
+  size_t tail_size = 64 * 1024;           // bytes of most recent output retained
+};
+
+// [crash] section of config.ini
+struct crash_settings {
+  bool enabled = false;
+  std::string bundle_dir;                 // empty means the JVM crash log directory
+  unsigned threads = 0;                   // heap dump compression threads (zero is one per CPU, up to 4)
+  size_t chunk_size = 1024 * 1024;
+  int compression_level = 1;
+  uint64_t disk_budget = 0;               // maximum bytes per crash bundle (zero is unlimited)
+  uint64_t min_free_space = 1024ULL * 1024 * 1024;
+  unsigned max_bundles = 3;               // older crash bundles are removed
+  bool keep_heap_dump = false;            // retain the uncompressed heap dump once compressed
+};
+
+// [shutdown] section of config.ini
+struct shutdown_settings {
+  milliseconds timeout{0};                // deadline after a forwarded SIGTERM/SIGINT/SIGHUP (zero is none)
+  milliseconds thread_dump_wait{2000};    // time allowed for the SIGQUIT thread dump prior to SIGKILL
+  int deadline_exit_status = 124;         // watchdog exit status when the deadline forced a SIGKILL
+};
+
+// how the process tree of the child is torn down once the child terminates
+enum class TEARDOWN : char {
+  AUTO = 0,       // cgroup if a child cgroup can be created, else process group
+  CGROUP,         // child placed in its own cgroup, torn down via cgroup.kill
+  PROCESS_GROUP,  // child placed in its own process group, torn down via kill(-pgid)
+  NONE,
+};
+
+// [process_tree] section of config.ini
+struct process_tree_settings {
+  bool subreaper = true;                  // orphaned descendants get reparented to (and reaped by) the watchdog
+  TEARDOWN teardown = TEARDOWN::AUTO;
+};
+
+// NUMA memory policy applied to the child process
+enum class MEMORY_POLICY : char {
+  NONE = 0,       // kernel default (local allocation)
+  PREFERRED,      // allocate on the chosen node, falling back to others when it is full
+  BIND,           // allocate only on the chosen node
+  INTERLEAVE,     // interleave allocations across all allowed nodes
+};
+
+// [numa] section of config.ini
+struct numa_settings {
+  static constexpr int node_none = -1;
+  static constexpr int node_auto = -2;    // allowed node with the most free memory not claimed by another watchdog
+  int node = node_none;
+  MEMORY_POLICY memory_policy = MEMORY_POLICY::PREFERRED;
+  bool bind_cpus = true;                  // restrict the child to the CPUs of the chosen node
+  bool cpuset = false;                    // also set cpuset.cpus/cpuset.mems of the child cgroup
+  std::string lock_dir{"/tmp"};           // node claim lock files (must be shared by co-located watchdogs)
+};
+
+// [cds] section of config.ini
+struct cds_settings {
+  bool enabled = false;
+  std::string archive_dir;                // empty: /tmp/java-watchdog-cds-<euid>, created 0700
+  unsigned max_archives = 4;              // least recently used archives beyond this are removed
+  milliseconds dump_timeout{2 * 60 * 1000}; // bound on the -Xshare:dump run of JDKs prior to 13
+};
+
+// [prewarm] section of config.ini
+struct prewarm_settings {
+  bool enabled = false;
+  unsigned threads = 4;
+  uint64_t io_budget = 1024ULL * 1024 * 1024; // bytes of files read ahead at most
+  std::string paths;                      // additional files or directories (':' separated) read ahead last
+};
+
+// [trace] section of config.ini (the JAVA_WATCHDOG_TRACE environment variable also turns tracing on)
+struct trace_settings {
+  bool enabled = false;
+  std::string file{"/tmp/java-watchdog-trace-%p.json"};
+  size_t buffer_events = 16384;
+};
+
+// [stats] section of config.ini
+struct stats_settings {
+  bool enabled = true;
+  std::string dir{"/dev/shm"};            // where java-watchdog-<pid>.stats is published
+  milliseconds interval{1000};            // metrics sampling when [metrics] is off (else its sample_interval)
+};
+
+// [readiness] section of config.ini (detection is on once ports or output_match is set)
+struct readiness_settings {
+  std::vector<uint16_t> ports;            // TCP ports the child process tree must be listening on
+  std::string output_match;               // text the captured child output must contain
+  milliseconds poll_interval{250};        // interval of the sock_diag query of the ports' listening sockets
+  std::string ready_file;                 // created holding the time-to-ready (ms) once ready
+  std::string socket_path;                // unix socket answering "ready <ms>" or "starting" to each connection
+};
+
+// what the watchdog does once the child has been killed for hanging
+enum class HANG_ACTION : char {
+  EXIT = 0,       // the watchdog exits (with a failure status)
+  RESTART,        // the child is launched anew (up to max_restarts times)
+};
+
+// [hang] section of config.ini
+struct hang_settings {
+  bool enabled = false;
+  milliseconds check_interval{1000};
+  milliseconds timeout{60 * 1000};        // period without progress that is declared a hang
+  std::string heartbeat_file;             // progress is the application touching this file (mtime)
+  std::string heartbeat_socket;           // progress is the application sending a datagram to this unix socket
+  unsigned gc_thrash_pct = 98;            // share of time spent in GC, sustained for timeout, declared a hang (zero is off)
+  milliseconds thread_dump_wait{5000};    // time allowed for the SIGQUIT thread dump prior to SIGKILL
+  HANG_ACTION action = HANG_ACTION::EXIT;
+  unsigned max_restarts = 3;
+};
+
+// [leak] section of config.ini
+struct leak_settings {
+  bool enabled = false;
+  milliseconds sample_interval{60 * 1000}; // smaps_rollup sampling (walks every mapping of the JVM)
+  milliseconds window{6 * 60 * 60 * 1000}; // span of samples the trend is fitted over
+  uint64_t min_slope = 1024 * 1024;       // bytes per hour of anonymous memory growth deemed a leak
+  milliseconds alert_horizon{7 * 24 * 60 * 60 * 1000LL}; // alert when the memory limit is projected within this
+  milliseconds alert_interval{60 * 60 * 1000}; // a standing alert is repeated this often
+  bool nmt = false;                       // run the JVM with native memory tracking and log its diffs
+  milliseconds nmt_interval{10 * 60 * 1000};
+};
+
+// native memory allocator the child JVM runs with
+enum class ALLOCATOR : char {
+  GLIBC = 0,
+  JEMALLOC,       // LD_PRELOAD of libjemalloc (if present)
+  TCMALLOC,       // LD_PRELOAD of libtcmalloc (if present)
+  AUTO,           // jemalloc if present, else glibc
+};
+
+// [malloc] section of config.ini (auto values are computed from the cgroup CPU quota and memory limit)
+struct malloc_settings {
+  static constexpr int64_t value_auto = -1;
+  static constexpr int64_t value_unset = -2;
+  bool enabled = false;
+  ALLOCATOR allocator = ALLOCATOR::GLIBC;
+  std::string allocator_path;             // library to preload instead of searching the usual locations
+  int64_t arena_max = value_auto;         // MALLOC_ARENA_MAX (glibc) or narenas (jemalloc)
+  int64_t trim_threshold = value_auto;    // GLIBC_TUNABLES glibc.malloc.trim_threshold
+  int64_t mmap_threshold = value_auto;    // GLIBC_TUNABLES glibc.malloc.mmap_threshold
+  int64_t tcache_count = value_unset;     // GLIBC_TUNABLES glibc.malloc.tcache_count
+  std::string report_file;                // a JSON line per launch: the policy and the resulting RSS
+};
+
+// [throttle] section of config.ini
+struct throttle_settings {
+  bool enabled = false;
+  milliseconds sample_interval{1000};     // cpu.stat sampling (a single pread)
+  milliseconds window{60 * 1000};         // throttling sustained over this span is logged
+  unsigned threshold_pct = 10;            // share of CFS periods throttled deemed sustained throttling
+  milliseconds alert_interval{10 * 60 * 1000}; // a standing alert is repeated this often
+  std::string recommend_file;             // the recommended JVM options are written here for the next launch
+  bool apply = false;                     // inject the options of recommend_file (those not set by the user)
+};
+
+// [tuning] section of config.ini (feedback-directed JVM tuning across launches)
+struct tuning_settings {
+  bool enabled = false;
+  std::string state_file;                 // the run profile of the last launch (one file per application)
+  bool apply = true;                      // inject the adjusted options (else they are only logged)
+  milliseconds sample_interval{1000};     // hsperfdata and RSS sampling
+  milliseconds min_uptime{60 * 1000};     // a shorter run is too thin a profile to tune from
+  milliseconds pause_target{200};         // p99 GC pause beyond which the heap is grown
+  unsigned gc_overhead_pct = 5;           // share of the run spent in GC beyond which the heap is grown
+  unsigned throttle_pct = 10;             // share of CFS periods throttled beyond which GC threads are cut
+  unsigned step_pct = 25;                 // largest change of a value per launch
+  uint64_t min_heap = 64 * 1024 * 1024;
+  uint64_t max_heap = 0;                  // zero is no bound beyond memory_pct
+  unsigned memory_pct = 85;               // heap plus peak native memory stay within this share of the memory limit
+  uint64_t max_code_cache = 512 * 1024 * 1024;
+  unsigned max_gc_threads = 0;            // zero is the effective CPUs
+};
+
+// wire format of the syslog transport
+enum class SYSLOG_FORMAT : char {
+  AUTO = 0,       // journald native on the journal socket, else RFC 5424
+  RFC5424,
+  JOURNALD,
+};
+
+// [syslog] section of config.ini
+struct syslog_settings {
+  bool enabled = true;
+  std::string socket;                     // empty means the journal socket if present, else /dev/log
+  SYSLOG_FORMAT format = SYSLOG_FORMAT::AUTO;
+  int facility = 3;                       // LOG_DAEMON
+  logger::LOGGING_LEVEL level = logger::LL::ERR; // the least severe log level forwarded
+  unsigned rate = 10;                     // messages per second (token bucket refill); zero is unlimited
+  unsigned burst = 50;                    // token bucket capacity
+  milliseconds dedup_window{10 * 1000};   // repeats of a message within this are counted instead of sent
+  unsigned batch_size = 16;               // datagrams per sendmmsg()
+  milliseconds flush_interval{250};       // a partial batch is sent after this
+};
+
+// [arbiter] section of config.ini
+struct arbiter_settings {
+  bool enabled = false;
+  std::string socket{"/run/java-watchdog/arbiter.sock"}; // shared by the node's watchdogs (bind-mount its directory)
+  std::string name;                       // identifies the JVM in the arbiter's log; empty is <hostname>:<child pid>
+  int priority = 0;                       // JVMs of the lowest priority are asked to shed memory first
+  milliseconds report_interval{2000};     // each watchdog reports its JVM's memory usage this often
+  uint64_t memory_limit = 0;              // bytes the JVMs' combined RSS may use; zero is the node's memory
+  unsigned high_pct = 90;                 // shedding starts once this share of the limit is in use
+  unsigned low_pct = 80;                  // ... and asks JVMs to free enough to get back down to this share
+  milliseconds shed_interval{30 * 1000};  // a JVM is asked to shed memory at most this often
+  std::string shed_commands{"GC.run"};    // comma separated jcmd commands a JVM asked to shed memory is sent
+};
+
+// [control] section of config.ini
+struct control_settings {
+  bool enabled = false;
+  std::string socket;                     // empty is /dev/shm/java-watchdog-<pid>.sock
+  std::vector<uint32_t> allow_uids;       // beyond root and the watchdog's own uid
+  std::vector<uint32_t> allow_gids;       // a client whose gid is listed is allowed too
+};
+
+// a listening socket of the [listen] section
+struct listen_socket {
+  std::string name;                       // LISTEN_FDNAMES entry
+  std::string address;                    // PORT, HOST:PORT, [IPV6]:PORT or unix:PATH
+};
+
+// [listen] section of config.ini: sockets the watchdog binds and holds across launches of the JVM
+struct listen_settings {
+  std::vector<listen_socket> sockets;     // passed to the JVM as fds 3, 4, ... in this order
+  unsigned backlog = 1024;                // connections the kernel queues while no JVM accepts
+  bool inherited_channel = false;         // the first socket is the JVM's stdin too (System.inheritedChannel())
+};
+
+// when a [process.NAME] JVM is launched anew after it terminates
+enum class RESTART_POLICY : char {
+  NEVER = 0,
+  ON_FAILURE,     // after a non-zero exit status or death by a signal
+  ALWAYS,
+};
+
+// [process.NAME] section of config.ini: one of the JVMs of a multi-JVM watchdog
+struct process_settings {
+  std::string name;
+  std::vector<std::string> args;          // the java command line (JVM options, main class or -jar, arguments)
+  int ordinal = 0;                        // which java found via PATH: 0 (first) to 6 (seventh), -1 the last
+  RESTART_POLICY restart = RESTART_POLICY::ON_FAILURE;
+  unsigned max_restarts = 5;
+  milliseconds restart_delay{1000};       // doubled for each restart, up to a minute
+  std::string cpus;                       // CPU list the JVM is bound to (e.g. "2-3"); empty is unbound
+  int order = 0;                          // started in ascending order, shut down in descending order
+  bool required = false;                  // its final termination shuts down the others and ends the watchdog
+};
+
+// the comparison of a [rewrite.NAME] condition
+enum class COMPARISON : char {
+  ANY = 0,        // no condition
+  LT, LE, EQ, NE, GE, GT,
+};
+
+// a [rewrite.NAME] condition such as ">=17" (no comparison operator means equal)
+struct rewrite_condition {
+  COMPARISON op = COMPARISON::ANY;
+  double value = 0.0;
+};
+
+// [rewrite.NAME] section of config.ini: a rule rewriting the JVM options of the java command line
+struct rewrite_settings {
+  std::string name;
+  std::string process{"*"};               // glob of the JVM names it applies to ("main" is the command line's)
+  rewrite_condition jdk;                  // JDK feature release (e.g. ">=17"); fails if the JDK is unknown
+  rewrite_condition memory;               // cgroup memory limit in bytes (e.g. "<4g"); no limit is infinite
+  rewrite_condition cpus;                 // effective CPUs per affinity and cgroup quota (e.g. ">=8")
+  std::vector<std::string> env;           // NAME=GLOB (or NAME, for set and not empty) conditions, all must hold
+  std::vector<std::string> remove;        // glob patterns of options to remove
+  std::vector<std::string> set;           // options replacing those of the same name (else appended)
+  std::vector<std::string> add;           // options appended
+  bool dedupe = false;                    // drops options repeated later on with the same name
+};
+
+// the config.ini sections beyond [settings]
+struct watchdog_settings {
+  metrics_settings metrics;
+  output_settings output;
+  crash_settings crash;
+  shutdown_settings shutdown;
+  process_tree_settings process_tree;
+  numa_settings numa;
+  cds_settings cds;
+  prewarm_settings prewarm;
+  trace_settings trace;
+  stats_settings stats;
+  readiness_settings readiness;
+  hang_settings hang;
+  leak_settings leak;
+  malloc_settings malloc;
+  throttle_settings throttle;
+  tuning_settings tuning;
+  syslog_settings syslog;
+  arbiter_settings arbiter;
+  control_settings control;
+  listen_settings listen;
+  std::vector<process_settings> processes;
+  std::vector<rewrite_settings> rewrites;   // in the order of their sections
+};
+
+/**
+ * Helpers for interpreting config.ini values. Each returns false if the
+ * value could not be interpreted (the result argument is left unchanged).
+ * <p>
+ * Sizes accept an optional k, m or g suffix (powers of 1024).
+ * <p>
+ * Durations accept an optional ms, s, m, h or d suffix (default is seconds).
+ */
+bool cfg_to_bool(const std::string_view value, bool &result);
+bool cfg_to_size(const std::string_view value, uint64_t &result);
+bool cfg_to_duration(const std::string_view value, milliseconds &result);
+
+/**
+ * Each parse function is handed a (lower-cased) name and the raw value of a
+ * name=value pair from its config.ini section. Returns false if the name is
+ * not recognized; invalid values are logged and the default retained.
+ */
+bool parse_metrics_setting(const std::string_view name, const std::string_view value, metrics_settings &settings);
+bool parse_output_setting(const std::string_view name, const std::string_view value, output_settings &settings);
+bool parse_crash_setting(const std::string_view name, const std::string_view value, crash_settings &settings);
+bool parse_shutdown_setting(const std::string_view name, const std::string_view value, shutdown_settings &settings);
+bool parse_process_tree_setting(const std::string_view name, const std::string_view value,
+                                process_tree_settings &settings);
+bool parse_numa_setting(const std::string_view name, const std::string_view value, numa_settings &settings);
+bool parse_cds_setting(const std::string_view name, const std::string_view value, cds_settings &settings);
+bool parse_prewarm_setting(const std::string_view name, const std::string_view value, prewarm_settings &settings);
+bool parse_trace_setting(const std::string_view name, const std::string_view value, trace_settings &settings);
+bool parse_stats_setting(const std::string_view name, const std::string_view value, stats_settings &settings);
+bool parse_readiness_setting(const std::string_view name, const std::string_view value, readiness_settings &settings);
+bool parse_hang_setting(const std::string_view name, const std::string_view value, hang_settings &settings);
+bool parse_leak_setting(const std::string_view name, const std::string_view value, leak_settings &settings);
+bool parse_malloc_setting(const std::string_view name, const std::string_view value, malloc_settings &settings);
+bool parse_throttle_setting(const std::string_view name, const std::string_view value, throttle_settings &settings);
+bool parse_tuning_setting(const std::string_view name, const std::string_view value, tuning_settings &settings);
+bool parse_syslog_setting(const std::string_view name, const std::string_view value, syslog_settings &settings);
+bool parse_arbiter_setting(const std::string_view name, const std::string_view value, arbiter_settings &settings);
+bool parse_control_setting(const std::string_view name, const std::string_view value, control_settings &settings);
+bool parse_listen_setting(const std::string_view name, const std::string_view value, listen_settings &settings);
+bool parse_process_setting(const std::string_view name, const std::string_view value, process_settings &settings);
+bool parse_rewrite_setting(const std::string_view name, const std::string_view value, rewrite_settings &settings);
+
+// splits a command line into arguments per shell-like quoting ('...', "..." and backslash escapes)
+std::vector<std::string> split_command_line(const std::string_view line);
+
+/**
+ * Dispatches a name=value pair of a config.ini section (other than [settings])
+ * to its parse function. Returns false if the section or name is not recognized.
+ */
+bool parse_section_setting(const std::string_view section, const std::string_view name, const std::string_view value,
+                           watchdog_settings &settings);
+
+#endif //__SETTINGS_H__
@@ -0,0 +1,301 @@
+/* supervisor.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "format2str.h"
+#include "log.h"
+#include "proc-stats.h"
+#include "trace.h"
+#include "supervisor.h"
+
+using namespace logger;
+
+namespace {
+
+  const milliseconds max_restart_delay{60 * 1000};
+
+  std::string describe_status(int status) {
+    if (WIFSIGNALED(status)) {
+      return format2str("was killed by signal %d (%s)", WTERMSIG(status), strsignal(WTERMSIG(status)));
+    }
+    return format2str("exited with status %d", WEXITSTATUS(status));
+  }
+
+}
+
+void process_supervisor::add(const process_settings &process, const std::string &java_path) {
+  // a single JVM keeps the cgroup name and log wording of a watchdog that supervises just the one
+  const bool is_single = cfg.processes.empty();
+  auto jvm = std::make_unique<supervised_jvm>();
+  jvm->runner = std::make_unique<jvm_runner>(
+      cfg, process, java_path,
+      is_single ? format2str("jvm-%d", getpid()) : format2str("jvm-%d-%s", getpid(), process.name.c_str()),
+      is_single ? std::string("child process") : format2str("process \"%s\"", process.name.c_str()),
+      jvms.empty() ? &services : nullptr);
+  jvms.push_back(std::move(jvm));
+}
+
+void process_supervisor::launch(supervised_jvm &jvm) {
+  if (jvm.runner->launch(loop, orig_signals)) {
+    jvm.state = STATE::RUNNING;
+    return;
+  }
+  jvm.state = STATE::ENDED;
+  exit_status = EXIT_FAILURE;
+  if (jvm.runner->settings().required) {
+    shutdown(SIGTERM, format2str("required %s could not be launched", jvm.runner->description()).c_str());
+  } else {
+    check_progress();
+  }
+}
+
+void process_supervisor::on_exit(supervised_jvm &jvm, int status, const struct rusage &usage) {
+  jvm.state = STATE::FINISHING;
+  jvm.runner->finish(status, usage, [this, &jvm](const jvm_runner::outcome &outcome) { on_finished(jvm, outcome); });
+}
+
+void process_supervisor::on_finished(supervised_jvm &jvm, const jvm_runner::outcome &outcome) {
+  auto &runner = *jvm.runner;
+  const pid_t pid = runner.child_pid();
+  const int status = outcome.status;
+  const auto description = describe_status(status);
+
+  if (outcome.is_stop_requested) {
+    if (outcome.is_deadline_killed) {
+      log(LL::ERR, "%s (pid:%d) did not shut down within the deadline", runner.description(), pid);
+      exit_status = cfg.shutdown.deadline_exit_status;
+    } else {
+      // exit status per the JVM convention for termination by a (forwarded) signal is a clean shutdown
+      const bool is_clean = (WIFEXITED(status) && (WEXITSTATUS(status) == 0 || WEXITSTATUS(status) > 128))
+                            || WIFSIGNALED(status);
+      log(LL::DEBUG, "%s (pid:%d) shut down on request; it %s", runner.description(), pid, description.c_str());
+      if (!is_clean && exit_status == EXIT_SUCCESS) exit_status = EXIT_FAILURE;
+    }
+    jvm.state = STATE::ENDED;
+    check_progress();
+    return;
+  }
+
+  if (outcome.is_restart_requested && !is_shutting_down) {
+    if (outcome.is_deadline_killed) {
+      log(LL::ERR, "%s (pid:%d) did not stop within the deadline of its restart", runner.description(), pid);
+    }
+    log(LL::INFO, "relaunching %s (pid:%d) per control request; it %s", runner.description(), pid,
+        description.c_str());
+    jvm.is_failed = false;
+    relaunch(jvm, milliseconds(0));
+    return;
+  }
+
+  const bool is_abnormal = outcome.is_hang_killed || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+  log(is_abnormal ? LL::ERR : LL::INFO, "%s (pid:%d) %s", runner.description(), pid, description.c_str());
+  jvm.is_failed = is_abnormal;
+  if (!is_shutting_down) {
+    if (outcome.is_hang_killed && cfg.hang.action == HANG_ACTION::RESTART && jvm.hang_restarts < cfg.hang.max_restarts) {
+      log(LL::WARN, "restarting hung %s (pid:%d); restart %u of %u", runner.description(), pid, ++jvm.hang_restarts,
+          cfg.hang.max_restarts);
+      relaunch(jvm, milliseconds(0));
+      return;
+    }
+    const auto policy = runner.settings().restart;
+    if (policy == RESTART_POLICY::ALWAYS || (policy == RESTART_POLICY::ON_FAILURE && is_abnormal)) {
+      if (jvm.restarts < runner.settings().max_restarts) {
+        auto delay = runner.settings().restart_delay;
+        for (unsigned i = 0; i < jvm.restarts && delay < max_restart_delay; i++) {
+          delay *= 2;
+        }
+        delay = std::min(delay, max_restart_delay);
+        log(LL::WARN, "restarting %s in %ld ms; restart %u of %u", runner.description(), (long) delay.count(),
+            ++jvm.restarts, runner.settings().max_restarts);
+        relaunch(jvm, delay);
+        return;
+      }
+      log(LL::ERR, "%s not restarted - all %u restarts used", runner.description(), runner.settings().max_restarts);
+    }
+  }
+
+  jvm.state = STATE::ENDED;
+  if (is_abnormal) exit_status = EXIT_FAILURE;
+  if (runner.settings().required && !is_shutting_down) {
+    shutdown(SIGTERM, format2str("required %s terminated", runner.description()).c_str());
+    return;
+  }
+  check_progress();
+}
+
+void process_supervisor::relaunch(supervised_jvm &jvm, milliseconds delay) {
+  jvm.state = STATE::RESTART_PENDING;
+  if (jvm.runner->is_primary()) {
+    stats.set_state(WATCHDOG_STATE::RESTARTING);
+    if (control.paused()) {
+      hold_relaunch(jvm);
+      return;
+    }
+  }
+  // (one-shot timers fire at least a millisecond out)
+  jvm.restart_timer = loop.add_timer(std::max(delay, milliseconds(1)), [this, &jvm]() {
+    jvm.restart_timer = -1;
+    launch(jvm);
+  }, false);
+}
+
+// the control socket keeps serving its commands while the relaunch waits for resume (or a shutdown signal)
+void process_supervisor::hold_relaunch(supervised_jvm &jvm) {
+  log(LL::WARN, "restarts are paused - holding the relaunch of %s until resumed", jvm.runner->description());
+  jvm.is_held = true;
+  control.attach(loop, 0, jvm.runner->launch_count(), 0, [this, &jvm]() {
+    if (!jvm.is_held) return;
+    jvm.is_held = false;
+    // (relaunched from a timer, as the launch attaches the control socket anew)
+    jvm.restart_timer = loop.add_timer(milliseconds(1), [this, &jvm]() {
+      jvm.restart_timer = -1;
+      control.detach();
+      launch(jvm);
+    }, false);
+  });
+}
+
+void process_supervisor::shutdown(int signo, const char *reason) {
+  if (is_shutting_down) return;
+  is_shutting_down = true;
+  stop_signal = signo;
+  log(LL::INFO, "shutting down: %s", reason);
+  for (auto &jvm : jvms) {
+    if (jvm->state == STATE::RESTART_PENDING) {
+      if (jvm->restart_timer != -1) loop.cancel_timer(jvm->restart_timer);
+      jvm->restart_timer = -1;
+      if (jvm->runner->is_primary()) control.detach(); // (attached while its relaunch is held)
+      jvm->is_held = false;
+      jvm->state = STATE::ENDED;
+      // a JVM whose relaunch is called off ends as its last run did
+      if (jvm->is_failed) exit_status = EXIT_FAILURE;
+    } else if (jvm->state == STATE::IDLE) {
+      jvm->state = STATE::ENDED;
+    }
+  }
+  stop_next_group();
+}
+
+bool process_supervisor::is_any(STATE state) const {
+  return std::any_of(jvms.begin(), jvms.end(), [state](const auto &jvm) { return jvm->state == state; });
+}
+
+void process_supervisor::check_progress() {
+  if (is_shutting_down) {
+    // (an order group is stopped once the one before it has terminated and been torn down)
+    if (!is_any(STATE::STOPPING) && !is_any(STATE::FINISHING)) stop_next_group();
+  } else if (!is_any(STATE::RUNNING) && !is_any(STATE::RESTART_PENDING) && !is_any(STATE::IDLE) &&
+             !is_any(STATE::FINISHING)) {
+    loop.stop();
+  }
+}
+
+void process_supervisor::stop_next_group() {
+  bool is_found = false;
+  for (const auto &jvm : jvms) {
+    if (jvm->state != STATE::RUNNING) continue;
+    stopping_order = is_found ? std::max(stopping_order, jvm->runner->settings().order) : jvm->runner->settings().order;
+    is_found = true;
+  }
+  if (!is_found) {
+    if (!is_any(STATE::FINISHING)) loop.stop();
+    return;
+  }
+  for (auto &jvm : jvms) {
+    if (jvm->state != STATE::RUNNING || jvm->runner->settings().order != stopping_order) continue;
+    jvm->state = STATE::STOPPING;
+    jvm->runner->stop(stop_signal);
+  }
+}
+
+int process_supervisor::run() {
+  std::stable_sort(jvms.begin(), jvms.end(), [](const auto &a, const auto &b) {
+    return a->runner->settings().order < b->runner->settings().order;
+  });
+  control.open();
+  if (!listeners.open()) {
+    return EXIT_FAILURE;
+  }
+
+  // these signals are blocked so that they are instead reported via the event loop's signalfd
+  sigset_t signals;
+  sigemptyset(&signals);
+  for (const int signo : { SIGCHLD, SIGTERM, SIGINT, SIGHUP, SIGQUIT }) {
+    sigaddset(&signals, signo);
+  }
+  if (trace::enabled()) {
+    sigaddset(&signals, SIGUSR2); // dumps the trace on demand
+  }
+  sigprocmask(SIG_BLOCK, &signals, &orig_signals);
+  loop.set_signals(signals, [this](const signalfd_siginfo &info) {
+    const int signo = (int) info.ssi_signo;
+    if (signo == SIGUSR2) {
+      trace::dump();
+      return;
+    }
+    if (signo == SIGCHLD) {
+      // every terminated child is reaped, including orphaned descendants reparented to the watchdog
+      reap_children([this](pid_t pid, int status, const struct rusage &usage) {
+        for (auto &jvm : jvms) {
+          if (jvm->runner->child_pid() == pid && (jvm->state == STATE::RUNNING || jvm->state == STATE::STOPPING)) {
+            on_exit(*jvm, status, usage);
+            return;
+          }
+          if (jvm->state == STATE::FINISHING && jvm->runner->reaped(pid, status)) return;
+        }
+        log(LL::TRACE, "reaped orphaned descendant process (pid:%d)", pid);
+      });
+      return;
+    }
+    if (signo == SIGQUIT) {
+      for (const auto &jvm : jvms) {
+        if (jvm->state == STATE::RUNNING || jvm->state == STATE::STOPPING) jvm->runner->forward(SIGQUIT);
+      }
+      return;
+    }
+    shutdown(signo, format2str("received signal %d (%s)", signo, strsignal(signo)).c_str());
+  });
+  if (cfg.syslog.enabled && cfg.syslog.batch_size > 1) {
+    loop.add_timer(cfg.syslog.flush_interval, []() { logger::flush_syslog(); });
+  }
+
+  for (auto &jvm : jvms) {
+    if (is_shutting_down) break;
+    launch(*jvm);
+  }
+  check_progress();
+
+  try {
+    trace::span span{"supervise"};
+    loop.run();
+  } catch(const event_loop_exception &ex) {
+    log(LL::ERR, "failed supervising the JVMs:\n\t%s: %s", ex.name(), ex.what());
+    for (auto &jvm : jvms) {
+      if (jvm->state == STATE::RUNNING || jvm->state == STATE::STOPPING || jvm->state == STATE::FINISHING) {
+        jvm->runner->kill_all();
+      }
+    }
+    exit_status = EXIT_FAILURE;
+  }
+  sigprocmask(SIG_SETMASK, &orig_signals, nullptr);
+  return exit_status;
+}
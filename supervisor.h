@@ -0,0 +1,110 @@
+/* supervisor.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __SUPERVISOR_H__
+#define __SUPERVISOR_H__
+
+#include <csignal>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+#include "control.h"
+#include "listen-sockets.h"
+#include "live-stats.h"
+#include "jvm-runner.h"
+
+/**
+ * Supervises the JVMs of the watchdog from one event loop: the single JVM of
+ * the command line or, with [process.NAME] sections, several - e.g. a
+ * coordinator plus sidecars such as an exporter or a log shipper - instead of
+ * a watchdog per JVM. Each JVM is run by a jvm_runner, so every per-JVM
+ * feature applies to each of them alike; the control socket, the inherited
+ * listening sockets, the live stats and the readiness reporting serve the
+ * primary JVM (the command line's, else that of the first [process.NAME]
+ * section).
+ * <p>
+ * JVMs are started in ascending order and, when the watchdog is asked to shut
+ * down (or a required JVM terminates for good), stopped in descending order:
+ * each order group is forwarded the shutdown signal and waited on (each JVM up
+ * to the [shutdown] deadline, then a thread dump and SIGKILL) before the next.
+ * A JVM is relaunched per its restart policy, after being killed for hanging
+ * (per [hang]) or on a restart command of the control socket; a relaunch of
+ * the primary JVM is held while restarts are paused.
+ * <p>
+ * The watchdog exits once every JVM has terminated for good.
+ */
+class process_supervisor {
+private:
+  // (FINISHING: the JVM has terminated and its process tree is being torn down)
+  enum class STATE : char { IDLE, RUNNING, RESTART_PENDING, STOPPING, FINISHING, ENDED };
+  struct supervised_jvm {
+    std::unique_ptr<jvm_runner> runner;
+    STATE state{STATE::IDLE};
+    unsigned restarts{0};               // per its restart policy
+    unsigned hang_restarts{0};
+    int restart_timer{-1};
+    bool is_held{false};                // its relaunch waits for restarts to be resumed
+    bool is_failed{false};              // its last run ended abnormally
+  };
+  const watchdog_settings &cfg;
+  live_stats stats;
+  control_server control;
+  listen_sockets listeners;
+  jvm_runner::watchdog_services services{control, listeners, stats};
+  event_loop loop;
+  std::vector<std::unique_ptr<supervised_jvm>> jvms;
+  sigset_t orig_signals{};
+  bool is_shutting_down{false};
+  int stop_signal{SIGTERM};
+  int stopping_order{0};
+  int exit_status{EXIT_SUCCESS};
+  void launch(supervised_jvm &jvm);
+  void on_exit(supervised_jvm &jvm, int status, const struct rusage &usage);
+  void on_finished(supervised_jvm &jvm, const jvm_runner::outcome &outcome);
+  void relaunch(supervised_jvm &jvm, milliseconds delay);
+  void hold_relaunch(supervised_jvm &jvm);
+  void shutdown(int signo, const char *reason);
+  bool is_any(STATE state) const;
+  void check_progress();
+  void stop_next_group();
+public:
+  // (the live stats are published from here on, so monitoring agents see the watchdog starting up too)
+  explicit process_supervisor(const watchdog_settings &cfg)
+      : cfg{cfg}, stats{cfg.stats}, control{cfg.control}, listeners{cfg.listen} {}
+  process_supervisor(const process_supervisor &) = delete;
+  process_supervisor& operator=(const process_supervisor &) = delete;
+
+  /**
+   * Adds a JVM to supervise; the first one added is the primary JVM.
+   *
+   * @param process its settings - name and command line among them (must outlive the supervisor)
+   * @param java_path the java launcher program found for it
+   */
+  void add(const process_settings &process, const std::string &java_path);
+
+  // launches the JVMs and supervises them until all have terminated for good; returns the exit status
+  int run();
+};
+
+#endif //__SUPERVISOR_H__
@@ -0,0 +1,381 @@
+/* syslog-transport.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <pthread.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "syslog-transport.h"
+
+//#define TEST_SYSLOG_TRANSPORT // uncomment to enable the test code below
+
+using namespace logger;
+
+namespace {
+
+  const char * const journal_socket = "/run/systemd/journal/socket";
+  const char * const dev_log = "/dev/log";
+  const int64_t reconnect_interval_ns = 1000000000LL;
+
+  // serializes the transports' state among the threads that log (e.g. those of the prewarm planner)
+  std::mutex s_mutex;
+  std::once_flag s_atfork_once;
+
+  int64_t now_ns() {
+    struct timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+
+  int severity(LOGGING_LEVEL level) {
+    switch (level) {
+      case LL::FATAL: return LOG_CRIT;
+      case LL::ERR:   return LOG_ERR;
+      case LL::WARN:  return LOG_WARNING;
+      case LL::INFO:  return LOG_INFO;
+      default:        return LOG_DEBUG;
+    }
+  }
+
+}
+
+syslog_transport::syslog_transport(const syslog_settings &cfg, const std::string_view ident)
+    : cfg{cfg}, ident{ident}
+{
+  // a child forked while another thread holds the lock (and logs, say, a failed exec) would deadlock
+  std::call_once(s_atfork_once, []() {
+    pthread_atfork([]() { s_mutex.lock(); }, []() { s_mutex.unlock(); }, []() { s_mutex.unlock(); });
+  });
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+  hostname = host[0] != '\0' ? host : "-";
+  if (!cfg.socket.empty()) {
+    socket_path = cfg.socket;
+  } else if (cfg.format != SYSLOG_FORMAT::RFC5424 && access(journal_socket, W_OK) == 0) {
+    socket_path = journal_socket;
+  } else {
+    socket_path = dev_log;
+  }
+  is_journald = cfg.format == SYSLOG_FORMAT::JOURNALD ||
+                (cfg.format == SYSLOG_FORMAT::AUTO && socket_path.size() >= 14 &&
+                 socket_path.compare(socket_path.size() - 14, 14, "journal/socket") == 0);
+  tokens = cfg.burst;
+  refill_ns = now_ns();
+  queue.reserve(cfg.batch_size + 2);
+}
+
+syslog_transport::~syslog_transport() {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  flush_repeats();
+  flush_queue();
+  if (fd != -1) close(fd);
+}
+
+std::string syslog_transport::format(LOGGING_LEVEL level, const std::string_view msg) const {
+  char header[512];
+  if (is_journald) {
+    snprintf(header, sizeof(header), "PRIORITY=%d\nSYSLOG_FACILITY=%d\nSYSLOG_IDENTIFIER=%s\nSYSLOG_PID=%d\n",
+             severity(level), cfg.facility, ident.c_str(), getpid());
+    std::string datagram{header};
+    if (msg.find('\n') == std::string_view::npos) {
+      datagram.append("MESSAGE=").append(msg).append("\n");
+    } else {
+      // a multi-line value takes the binary form: name, newline, little endian 64 bit length, value, newline
+      datagram.append("MESSAGE\n");
+      uint64_t size = msg.size();
+      for (int i = 0; i < 8; i++, size >>= 8) {
+        datagram += (char) (size & 0xff);
+      }
+      datagram.append(msg).append("\n");
+    }
+    return datagram;
+  }
+  struct timespec ts{};
+  clock_gettime(CLOCK_REALTIME, &ts);
+  struct tm tm{};
+  gmtime_r(&ts.tv_sec, &tm);
+  // <PRI>VERSION TIMESTAMP HOSTNAME APP-NAME PROCID MSGID STRUCTURED-DATA MSG
+  snprintf(header, sizeof(header), "<%d>1 %04d-%02d-%02dT%02d:%02d:%02d.%06ldZ %s %s %d - - ",
+           cfg.facility * 8 + severity(level), tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min,
+           tm.tm_sec, ts.tv_nsec / 1000, hostname.c_str(), ident.c_str(), getpid());
+  return std::string(header).append(msg);
+}
+
+void syslog_transport::enqueue(LOGGING_LEVEL level, const std::string_view msg) {
+  if (queue.empty()) first_queued_ns = now_ns();
+  queue.push_back(format(level, msg));
+}
+
+void syslog_transport::flush_repeats() {
+  if (repeats == 0) return;
+  char msg[64];
+  snprintf(msg, sizeof(msg), "last message repeated %u times", repeats);
+  repeats = 0;
+  enqueue(last_level, msg);
+}
+
+void syslog_transport::send(LOGGING_LEVEL level, std::string_view msg) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  while (!msg.empty() && msg.back() == '\n') {
+    msg.remove_suffix(1);
+  }
+  const auto now = now_ns();
+  const int64_t dedup_ns = (int64_t) cfg.dedup_window.count() * 1000000;
+  if (dedup_ns > 0 && repeats < UINT32_MAX && level == last_level && msg == last_msg && now - last_sent_ns < dedup_ns) {
+    repeats++;
+  } else {
+    flush_repeats();
+    bool is_allowed = true;
+    if (cfg.rate > 0) {
+      tokens = std::min((double) cfg.burst, tokens + (double) (now - refill_ns) * cfg.rate / 1e9);
+      refill_ns = now;
+      is_allowed = tokens >= 1.0;
+      if (is_allowed) tokens -= 1.0;
+    }
+    if (!is_allowed) {
+      suppressed++;
+      total_suppressed++;
+    } else {
+      if (suppressed > 0) {
+        char notice[80];
+        snprintf(notice, sizeof(notice), "%lu messages suppressed by rate limit", (unsigned long) suppressed);
+        suppressed = 0;
+        enqueue(level, notice);
+      }
+      enqueue(level, msg);
+      last_msg = msg;
+      last_level = level;
+      last_sent_ns = now;
+    }
+  }
+  if (!queue.empty() && (queue.size() >= cfg.batch_size || level == LL::FATAL ||
+                         now - first_queued_ns >= (int64_t) cfg.flush_interval.count() * 1000000))
+  {
+    flush_queue();
+  }
+}
+
+bool syslog_transport::connect_socket(int64_t now) {
+  if (now < next_connect_ns) return false;
+  next_connect_ns = now + reconnect_interval_ns;
+  struct sockaddr_un addr{};
+  if (socket_path.size() >= sizeof(addr.sun_path)) return false;
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, socket_path.data(), socket_path.size());
+  fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == -1) return false;
+  if (connect(fd, (const struct sockaddr*) &addr, sizeof(addr)) == -1) {
+    close(fd);
+    fd = -1;
+    return false;
+  }
+  return true;
+}
+
+void syslog_transport::flush() {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  flush_queue();
+}
+
+void syslog_transport::flush_queue() {
+  const auto now = now_ns();
+  if (repeats > 0 && now - last_sent_ns >= (int64_t) cfg.dedup_window.count() * 1000000) {
+    flush_repeats();
+  }
+  if (queue.empty()) return;
+  if (fd == -1 && !connect_socket(now)) {
+    dropped += queue.size();
+    total_dropped += queue.size();
+    queue.clear();
+    return;
+  }
+  const bool has_notice = dropped > 0;
+  if (has_notice) {
+    char notice[96];
+    snprintf(notice, sizeof(notice), "%lu log messages dropped (syslog socket unavailable or full)",
+             (unsigned long) dropped);
+    queue.insert(queue.begin(), format(LL::WARN, notice));
+  }
+
+  std::vector<struct iovec> iovs(queue.size());
+  std::vector<struct mmsghdr> msgs(queue.size());
+  for (size_t i = 0; i < queue.size(); i++) {
+    iovs[i].iov_base = queue[i].data();
+    iovs[i].iov_len = queue[i].size();
+    msgs[i] = mmsghdr{};
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  size_t sent = 0;
+  bool is_reconnected = false;
+  while (sent < msgs.size()) {
+    const int rc = sendmmsg(fd, msgs.data() + sent, (unsigned) (msgs.size() - sent), MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (rc > 0) {
+      sent += (size_t) rc;
+      continue;
+    }
+    if (rc == -1 && errno == EINTR) continue;
+    // the daemon restarted (its socket is a new one) or went away
+    if (rc == -1 && !is_reconnected && (errno == ECONNREFUSED || errno == ENOTCONN || errno == ENOENT)) {
+      is_reconnected = true;
+      close(fd);
+      fd = -1;
+      next_connect_ns = 0;
+      if (connect_socket(now)) continue;
+    }
+    break; // EAGAIN: the daemon is not keeping up, and waiting for it is not an option
+  }
+  if (has_notice && sent > 0) dropped = 0;
+  const size_t failed = msgs.size() - sent - (has_notice && sent == 0 ? 1 : 0);
+  dropped += failed;
+  total_dropped += failed;
+  queue.clear();
+}
+
+#if defined(TEST_SYSLOG_TRANSPORT)
+
+#include <chrono>
+#include <thread>
+
+// receives whatever the stand-in syslog daemon has queued up
+static std::vector<std::string> receive_all(int sock) {
+  std::vector<std::string> datagrams;
+  char buf[8192];
+  ssize_t n;
+  while ((n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+    datagrams.emplace_back(buf, (size_t) n);
+  }
+  return datagrams;
+}
+
+static int failures = 0;
+
+static void expect(bool condition, const char *what) {
+  printf("%s: %s\n", condition ? "PASS" : "FAIL", what);
+  if (!condition) failures++;
+}
+
+int main(int argc, char **argv) {
+  // a unix datagram socket stands in for the syslog daemon
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/test-syslog-%d.sock", getpid());
+  const int sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  struct sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  unlink(path);
+  if (bind(sock, (const struct sockaddr*) &addr, sizeof(addr)) == -1) {
+    perror("bind");
+    return EXIT_FAILURE;
+  }
+
+  syslog_settings cfg;
+  cfg.socket = path;
+  cfg.rate = 5;
+  cfg.burst = 10;
+  cfg.dedup_window = milliseconds(200);
+  cfg.batch_size = 4;
+  {
+    syslog_transport transport(cfg, "test-syslog");
+
+    for (int i = 0; i < 100; i++) {
+      transport.send(LL::ERR, "same message\n");
+    }
+    transport.send(LL::ERR, "different message");
+    transport.flush();
+    auto datagrams = receive_all(sock);
+    for (const auto &datagram : datagrams) {
+      printf("  %s\n", datagram.c_str());
+    }
+    expect(datagrams.size() == 3, "a flood of duplicates is collapsed");
+    expect(datagrams.size() == 3 && datagrams[0].compare(0, 7, "<27>1 2") == 0 &&
+           datagrams[0].find(" test-syslog ") != std::string::npos &&
+           datagrams[0].find(" - - same message") != std::string::npos, "RFC 5424 header");
+    expect(datagrams.size() == 3 && datagrams[1].find("last message repeated 99 times") != std::string::npos,
+           "repeat count is reported");
+
+    // two tokens were spent above, eight remain
+    for (int i = 0; i < 20; i++) {
+      transport.send(LL::ERR, "burst message " + std::to_string(i));
+    }
+    transport.flush();
+    expect(receive_all(sock).size() == 8 && transport.suppressed_count() == 12, "the rate limit suppresses the excess");
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    transport.send(LL::ERR, "after the burst");
+    transport.flush();
+    datagrams = receive_all(sock);
+    expect(datagrams.size() == 2 && datagrams[0].find("12 messages suppressed by rate limit") != std::string::npos,
+           "suppressed messages are reported");
+
+    // the daemon goes away: sending must neither block nor fail
+    {
+      syslog_settings unlimited = cfg;
+      unlimited.rate = 0;
+      syslog_transport stalled(unlimited, "test-syslog");
+      const auto start_ns = now_ns();
+      for (int i = 0; i < 5000; i++) {
+        stalled.send(LL::ERR, "nobody reads " + std::to_string(i));
+      }
+      stalled.flush();
+      const auto elapsed_ms = (now_ns() - start_ns) / 1000000;
+      printf("  5000 messages to a stalled daemon in %ld ms, %lu dropped\n", (long) elapsed_ms,
+             (unsigned long) stalled.dropped_count());
+      expect(elapsed_ms < 1000 && stalled.dropped_count() > 0, "a stalled daemon doesn't block");
+    }
+    close(sock);
+    unlink(path);
+    const auto start_ns = now_ns();
+    for (int i = 0; i < 1000; i++) {
+      transport.send(LL::FATAL, "nobody listens " + std::to_string(i));
+    }
+    const auto elapsed_ms = (now_ns() - start_ns) / 1000000;
+    printf("  1000 messages to a dead daemon in %ld ms, %lu dropped\n", (long) elapsed_ms,
+           (unsigned long) transport.dropped_count());
+    expect(elapsed_ms < 1000 && transport.dropped_count() > 0, "a dead daemon doesn't block");
+  }
+
+  cfg.format = SYSLOG_FORMAT::JOURNALD;
+  cfg.socket = path;
+  const int journal = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  bind(journal, (const struct sockaddr*) &addr, sizeof(addr));
+  {
+    syslog_transport transport(cfg, "test-syslog");
+    transport.send(LL::WARN, "line one\nline two");
+    transport.flush();
+    const auto datagrams = receive_all(journal);
+    expect(datagrams.size() == 1 && datagrams[0].compare(0, 11, "PRIORITY=4\n") == 0 &&
+           datagrams[0].find("SYSLOG_IDENTIFIER=test-syslog\n") != std::string::npos &&
+           datagrams[0].find(std::string("MESSAGE\n\x11\0\0\0\0\0\0\0line one\nline two\n", 34)) != std::string::npos,
+           "journald native format");
+  }
+  close(journal);
+  unlink(path);
+
+  printf("%s: %d failure(s)\n", argv[0], failures);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
@@ -0,0 +1,93 @@
+/* syslog-transport.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __SYSLOG_TRANSPORT_H__
+#define __SYSLOG_TRANSPORT_H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include "settings.h"
+
+/**
+ * Native syslog transport of the logger: writes RFC 5424 or journald native
+ * datagrams straight to /dev/log (or the journal socket, or any configured
+ * unix socket) in batches of up to batch_size per sendmmsg() call.
+ * <p>
+ * A crash looping JVM must not flood the syslog daemon: repeats of the same
+ * message within dedup_window are counted and reported as "last message
+ * repeated N times", and a token bucket (rate messages per second, up to
+ * burst at once) suppresses the excess, reporting how many were suppressed
+ * once messages flow again.
+ * <p>
+ * The socket is non-blocking, so a stalled or dead daemon costs dropped
+ * messages (counted and reported on recovery) instead of a stalled watchdog;
+ * after a failed connect, reconnecting is attempted at most once a second.
+ * The transport never logs through the logger itself. Its state is guarded
+ * by a lock, as threads besides the main one log too.
+ */
+class syslog_transport {
+private:
+  const syslog_settings cfg;
+  std::string ident;
+  std::string hostname;
+  std::string socket_path;
+  bool is_journald{false};
+  int fd{-1};
+  int64_t next_connect_ns{0};
+  std::vector<std::string> queue;     // formatted datagrams awaiting the next sendmmsg()
+  int64_t first_queued_ns{0};
+  double tokens{0.0};
+  int64_t refill_ns{0};
+  uint64_t suppressed{0};             // messages suppressed by the rate limit since the last one sent
+  uint64_t dropped{0};                // datagrams the socket did not take since the last successful send
+  uint64_t total_suppressed{0};
+  uint64_t total_dropped{0};
+  std::string last_msg;
+  logger::LOGGING_LEVEL last_level{logger::LL::ERR};
+  int64_t last_sent_ns{0};
+  unsigned repeats{0};
+  void enqueue(logger::LOGGING_LEVEL level, const std::string_view msg);
+  void flush_repeats();
+  void flush_queue();
+  bool connect_socket(int64_t now_ns);
+  std::string format(logger::LOGGING_LEVEL level, const std::string_view msg) const;
+public:
+  /**
+   * @param cfg the [syslog] settings
+   * @param ident the program name the messages are tagged with
+   */
+  syslog_transport(const syslog_settings &cfg, const std::string_view ident);
+  syslog_transport(const syslog_transport &) = delete;
+  syslog_transport& operator=(const syslog_transport &) = delete;
+  ~syslog_transport();
+
+  // queues a log line (subject to dedup and the rate limit); sent once a batch fills or flush_interval passes
+  void send(logger::LOGGING_LEVEL level, const std::string_view msg);
+  // sends the queued datagrams without blocking; call prior to fork() so a child doesn't inherit them
+  void flush();
+
+  const std::string& path() const { return socket_path; }
+  uint64_t suppressed_count() const { return total_suppressed; }
+  uint64_t dropped_count() const { return total_dropped; }
+};
+
+#endif //__SYSLOG_TRANSPORT_H__
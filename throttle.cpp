@@ -0,0 +1,236 @@
+/* throttle.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cgroup.h"
+#include "format2str.h"
+#include "log.h"
+#include "path-concat.h"
+#include "throttle.h"
+
+using namespace logger;
+
+namespace {
+
+  // value of a "name 1234" line of cpu.stat
+  uint64_t stat_value(const char *stat, const char *name) {
+    const char * const p = strstr(stat, name);
+    return p != nullptr ? strtoull(p + strlen(name), nullptr, 10) : 0;
+  }
+
+  // CPUs worth of quota per a cgroup's quota files (zero if unlimited or absent)
+  double read_quota(const std::string &dir, bool is_v1) {
+    if (!is_v1) {
+      // "<quota> <period>" or "max <period>"
+      const auto str = cgroup::read_file(path_concat(dir, "cpu.max"));
+      if (str.empty() || str.compare(0, 3, "max") == 0) return 0.0;
+      char *end = nullptr;
+      const double quota = strtod(str.c_str(), &end);
+      const double period = strtod(end, nullptr);
+      return quota > 0 && period > 0 ? quota / period : 0.0;
+    }
+    const double quota = strtod(cgroup::read_file(path_concat(dir, "cpu.cfs_quota_us")).c_str(), nullptr);
+    const double period = strtod(cgroup::read_file(path_concat(dir, "cpu.cfs_period_us")).c_str(), nullptr);
+    return quota > 0 && period > 0 ? quota / period : 0.0;
+  }
+
+  // the watchdog's own cgroup or its nearest ancestor having a CPU quota (empty if there is none)
+  std::string find_quota_dir(bool &is_v1) {
+    // (on a hybrid hierarchy the cpu controller is a v1 one)
+    is_v1 = cgroup::v2_file("cpu.max").empty();
+    std::string dir = is_v1 ? cgroup::v1_dir("cpu") : cgroup::v2_dir();
+    const char * const quota_file = is_v1 ? "cpu.cfs_quota_us" : "cpu.max";
+    // the root of a hierarchy has no quota file, which ends the walk
+    while (!dir.empty() && access(path_concat(dir, quota_file).c_str(), R_OK) == 0) {
+      if (read_quota(dir, is_v1) > 0.0) return dir;
+      const auto slash = dir.rfind('/');
+      dir = slash == std::string::npos || slash == 0 ? std::string() : dir.substr(0, slash);
+    }
+    return std::string();
+  }
+
+}
+
+void throttle_monitor::prepare(jvm_args &args) {
+  if (!cfg.enabled || !cfg.apply || cfg.recommend_file.empty()) return;
+  const auto options = cgroup::read_file(cfg.recommend_file);
+  std::string applied;
+  size_t pos = 0;
+  while ((pos = options.find_first_not_of(" \t\n", pos)) != std::string::npos) {
+    const auto end = std::min(options.find_first_of(" \t\n", pos), options.size());
+    const auto option = options.substr(pos, end - pos);
+    pos = end;
+    if (option.compare(0, 4, "-XX:") != 0) continue; // only the options written by alert()
+    if (!args.has_option(option.substr(0, option.find('=') + 1))) {
+      args.inject(option);
+      applied += " " + option;
+    }
+  }
+  if (!applied.empty()) {
+    log(LL::INFO, "applying CPU throttling recommendations from \"%s\":%s", cfg.recommend_file.c_str(), applied.c_str());
+  }
+}
+
+void throttle_monitor::attach(event_loop &event_loop, pid_t child_pid) {
+  if (!cfg.enabled) return;
+  pid = child_pid;
+  window.clear();
+  totals = sample{};
+  throttled_in_pause_ms = pause_in_throttle_ms = throttled_pct = 0.0;
+  prev_throttled_ms = -1.0;
+  prev_pause_ticks = -1;
+  samples = 0;
+  last_alert_ns = 0;
+  if (quota_dir.empty()) {
+    quota_dir = find_quota_dir(is_v1);
+    if (quota_dir.empty()) {
+      log(LL::DEBUG, "no CPU quota applies to the watchdog's cgroup - CFS throttling is not monitored");
+      return;
+    }
+    log(LL::DEBUG, "monitoring CFS throttling of cgroup \"%s\" (quota %.2f CPUs)", quota_dir.c_str(),
+        read_quota(quota_dir, is_v1));
+  }
+  stat_fd = open(path_concat(quota_dir, "cpu.stat").c_str(), O_RDONLY | O_CLOEXEC);
+  if (stat_fd == -1) {
+    log(LL::WARN, "could not open cpu.stat of cgroup \"%s\" - CFS throttling is not monitored: %s",
+        quota_dir.c_str(), strerror(errno));
+    return;
+  }
+  loop = &event_loop;
+  sample_timer = loop->add_timer(cfg.sample_interval, [this]() { sample_stat(); });
+}
+
+void throttle_monitor::detach() {
+  if (loop != nullptr) {
+    if (sample_timer != -1) loop->cancel_timer(sample_timer);
+    loop = nullptr;
+  }
+  sample_timer = -1;
+  if (stat_fd != -1) {
+    close(stat_fd);
+    stat_fd = -1;
+  }
+  hsperf.detach();
+}
+
+double throttle_monitor::quota_cpus() const {
+  return read_quota(quota_dir, is_v1);
+}
+
+void throttle_monitor::add(const sample &s, int sign) {
+  totals.periods += sign * s.periods;
+  totals.throttled += sign * s.throttled;
+  totals.throttled_ms += sign * s.throttled_ms;
+  totals.pause_ms += sign * s.pause_ms;
+  if (s.pause_ms > 0.0) throttled_in_pause_ms += sign * s.throttled_ms;
+  if (s.throttled > 0) pause_in_throttle_ms += sign * s.pause_ms;
+}
+
+void throttle_monitor::sample_stat() {
+  char buf[1024];
+  const ssize_t n = pread(stat_fd, buf, sizeof(buf) - 1, 0);
+  if (n <= 0) return;
+  buf[n] = '\0';
+  const uint64_t periods = stat_value(buf, "nr_periods ");
+  const uint64_t throttled = stat_value(buf, "nr_throttled ");
+  const double throttled_ms = is_v1 ? (double) stat_value(buf, "throttled_time ") / 1e6 :
+                                      (double) stat_value(buf, "throttled_usec ") / 1e3;
+
+  // the hsperfdata file appears a while into JVM startup (retried less often once that is past)
+  samples++;
+  if (!hsperf.is_attached() && (samples < 30 || samples % 10 == 0)) {
+    hsperf.attach(pid);
+  }
+  int64_t pause_ticks = -1;
+  if (hsperf.is_attached()) {
+    // GC pauses happen within safepoints, so the greater of the two avoids counting them twice
+    pause_ticks = std::max(hsperf.get("sun.rt.safepointTime"), hsperf.sum("sun.gc.collector.", ".time"));
+  }
+
+  if (prev_throttled_ms >= 0.0 && periods >= prev_periods) {
+    sample s{monotonic_ns(), periods - prev_periods, throttled - prev_throttled,
+             std::max(0.0, throttled_ms - prev_throttled_ms), 0.0};
+    if (pause_ticks >= 0 && prev_pause_ticks >= 0) {
+      s.pause_ms = hsperf.ticks_to_ms(std::max<int64_t>(0, pause_ticks - prev_pause_ticks));
+    }
+    throttled_pct = s.periods > 0 ? 100.0 * (double) s.throttled / (double) s.periods : 0.0;
+    window.push_back(s);
+    add(s, 1);
+    const int64_t window_ns = (int64_t) cfg.window.count() * 1000000;
+    while (s.time_ns - window.front().time_ns >= window_ns) {
+      add(window.front(), -1);
+      window.pop_front();
+    }
+    // sustained means over the whole window, so a fresh launch (or a burst) doesn't qualify
+    const int64_t span_ns = s.time_ns - window.front().time_ns + (int64_t) cfg.sample_interval.count() * 1000000;
+    const double window_pct = totals.periods > 0 ? 100.0 * (double) totals.throttled / (double) totals.periods : 0.0;
+    if (span_ns >= window_ns && window_pct >= cfg.threshold_pct &&
+        (last_alert_ns == 0 || s.time_ns - last_alert_ns >= (int64_t) cfg.alert_interval.count() * 1000000))
+    {
+      last_alert_ns = s.time_ns;
+      alert();
+    }
+  }
+  prev_periods = periods;
+  prev_throttled = throttled;
+  prev_throttled_ms = throttled_ms;
+  prev_pause_ticks = pause_ticks;
+}
+
+void throttle_monitor::alert() {
+  const double window_pct = 100.0 * (double) totals.throttled / (double) totals.periods;
+  const double quota = quota_cpus();
+  std::string correlation;
+  double pause_share = 0.0;
+  if (hsperf.is_attached() && totals.throttled_ms > 0.0) {
+    pause_share = 100.0 * throttled_in_pause_ms / totals.throttled_ms;
+    correlation = format2str("; %.0f%% of the throttled time fell in GC/safepoint pause windows (%.0f of %.0f ms "
+                             "of pauses ran while throttled)", pause_share, pause_in_throttle_ms, totals.pause_ms);
+  }
+
+  // the JVM sizes its thread pools by ceil(quota) - rounding down instead keeps bursts within the quota
+  const long cpus = std::max(1L, (long) std::floor(quota));
+  auto options = format2str("-XX:ActiveProcessorCount=%ld", cpus);
+  if (pause_share >= 50.0) {
+    options += format2str(" -XX:ParallelGCThreads=%ld -XX:ConcGCThreads=%ld", cpus, std::max(1L, (cpus + 3) / 4));
+  }
+  log(LL::WARN, "child process (pid:%d) sustained CFS throttling: %.0f%% of %lu periods throttled over the last "
+      "%ld s (%.0f ms throttled, quota %.2f CPUs)%s; recommended for the next launch: %s", pid, window_pct,
+      (unsigned long) totals.periods, (long) (cfg.window.count() / 1000), totals.throttled_ms, quota,
+      correlation.c_str(), options.c_str());
+
+  if (cfg.recommend_file.empty()) return;
+  const auto tmp_file = cfg.recommend_file + ".tmp";
+  FILE * const file = fopen(tmp_file.c_str(), "we");
+  bool is_written = file != nullptr && fprintf(file, "%s\n", options.c_str()) > 0;
+  if (file != nullptr) is_written = fclose(file) == 0 && is_written;
+  if (!is_written || rename(tmp_file.c_str(), cfg.recommend_file.c_str()) != 0) {
+    log(LL::WARN, "could not write CPU throttling recommendations to \"%s\": %s", cfg.recommend_file.c_str(),
+        strerror(errno));
+  }
+}
+
+void throttle_monitor::publish(metric_values &values) const {
+  if (loop == nullptr) return;
+  at(values, METRIC::THROTTLED_PCT) = throttled_pct;
+}
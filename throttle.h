@@ -0,0 +1,98 @@
+/* throttle.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __THROTTLE_H__
+#define __THROTTLE_H__
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+#include "hsperf.h"
+#include "jvm-args.h"
+#include "proc-stats.h"
+
+/**
+ * Watches the container for CFS bandwidth throttling - latency spikes that
+ * come from the CPU quota running out mid-period rather than from the JVM.
+ * <p>
+ * The cpu.stat of the nearest cgroup (the watchdog's own or an ancestor) with
+ * a CPU quota is sampled each sample_interval for its nr_periods, nr_throttled
+ * and throttled time. Each sample also notes whether the JVM's hsperfdata GC
+ * and safepoint time counters advanced, marking it as a pause window, so that
+ * throttling can be correlated with pauses: parallel GC threads bursting
+ * across all cores are a common way to exhaust a quota within a period.
+ * <p>
+ * Throttling of at least threshold_pct of the periods sustained over window is
+ * logged, together with recommended -XX:ActiveProcessorCount (and, when the
+ * throttling concentrates in pauses, GC thread counts) for the next launch.
+ * These may be written to recommend_file and, with apply, injected into the
+ * JVM options of the following launch.
+ */
+class throttle_monitor {
+private:
+  struct sample {
+    int64_t time_ns;
+    uint64_t periods;
+    uint64_t throttled;
+    double throttled_ms;
+    double pause_ms;      // GC and safepoint time the JVM accrued within the sample
+  };
+  const throttle_settings &cfg;
+  pid_t pid{0};
+  event_loop *loop{nullptr};
+  std::string quota_dir;              // cgroup whose quota (and cpu.stat) is watched
+  bool is_v1{false};
+  int stat_fd{-1};
+  int sample_timer{-1};
+  hsperf_reader hsperf;
+  int samples{0};
+  std::deque<sample> window;
+  sample totals{};                    // sums over the window
+  double throttled_in_pause_ms{0.0};  // throttled time of the window's pause samples
+  double pause_in_throttle_ms{0.0};   // pause time of the window's throttled samples
+  uint64_t prev_periods{0};
+  uint64_t prev_throttled{0};
+  double prev_throttled_ms{-1.0};
+  int64_t prev_pause_ticks{-1};
+  double throttled_pct{0.0};
+  int64_t last_alert_ns{0};
+  void sample_stat();
+  void add(const sample &s, int sign);
+  void alert();
+  double quota_cpus() const;
+public:
+  explicit throttle_monitor(const throttle_settings &cfg) : cfg{cfg} {}
+  throttle_monitor(const throttle_monitor &) = delete;
+  throttle_monitor& operator=(const throttle_monitor &) = delete;
+  ~throttle_monitor() { detach(); }
+
+  // injects the options of recommend_file the user has not set (when apply is enabled); call prior to fork()
+  void prepare(jvm_args &args);
+  // starts sampling cpu.stat; call in the parent after fork()
+  void attach(event_loop &loop, pid_t pid);
+  void detach();
+
+  // fills in the throttling metric of a metrics sample
+  void publish(metric_values &values) const;
+};
+
+#endif //__THROTTLE_H__
@@ -0,0 +1,163 @@
+/* trace.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "log.h"
+#include "trace.h"
+
+using namespace logger;
+
+namespace trace {
+
+  bool is_on = false;
+
+  namespace {
+
+    struct event {
+      const char *name;
+      int64_t start_ns;
+      int64_t duration_ns;      // -1 marks an instant event
+      int32_t pid;
+      int32_t tid;
+    };
+
+    struct buffer {
+      std::atomic<uint32_t> count;
+      uint32_t capacity;
+      event events[];
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "trace buffer is shared across fork()");
+
+    buffer *s_buffer = nullptr;
+    std::string s_file_path;
+    pid_t s_owner_pid = 0;
+
+    void append(const char *name, int64_t start_ns, int64_t duration_ns) {
+      const uint32_t i = s_buffer->count.fetch_add(1, std::memory_order_relaxed);
+      if (i >= s_buffer->capacity) return; // full; the count still tells how many were dropped
+      event &ev = s_buffer->events[i];
+      ev.name = name;
+      ev.start_ns = start_ns;
+      ev.duration_ns = duration_ns;
+      ev.pid = (int32_t) getpid();
+      ev.tid = (int32_t) syscall(SYS_gettid);
+    }
+
+    // writes a JSON string literal (span names are plain identifiers, but escape regardless)
+    void write_json_string(FILE *file, const char *str) {
+      fputc('"', file);
+      for (const char *p = str; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') fputc('\\', file);
+        if ((unsigned char) *p >= 0x20) fputc(*p, file);
+      }
+      fputc('"', file);
+    }
+
+  }
+
+  void start(const std::string &file_path, size_t capacity_events) {
+    if (s_buffer != nullptr) return;
+    const size_t size = sizeof(buffer) + capacity_events * sizeof(event);
+    void * const mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+      log(LL::WARN, "could not allocate trace buffer of %zu bytes: %s", size, strerror(errno));
+      return;
+    }
+    s_buffer = new (mem) buffer{};
+    s_buffer->capacity = (uint32_t) capacity_events;
+    s_owner_pid = getpid();
+    s_file_path = file_path;
+    const auto pos = s_file_path.find("%p");
+    if (pos != std::string::npos) {
+      s_file_path.replace(pos, 2, std::to_string(s_owner_pid));
+    }
+    is_on = true;
+    atexit([]() { dump(); });
+  }
+
+  int64_t now_ns() {
+    struct timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+
+  void record(const char *name, int64_t start_ns, int64_t duration_ns) {
+    if (enabled()) append(name, start_ns, duration_ns);
+  }
+
+  void instant(const char *name) {
+    if (enabled()) append(name, now_ns(), -1);
+  }
+
+  bool dump() {
+    if (!enabled() || getpid() != s_owner_pid) return false;
+    const auto tmp_path = s_file_path + ".tmp";
+    // (by default in /tmp: a stale file is removed, and none other - nor a planted symlink - is ever written)
+    unlink(tmp_path.c_str());
+    const int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+    FILE * const file = fd != -1 ? fdopen(fd, "w") : nullptr;
+    if (file == nullptr) {
+      log(LL::WARN, "could not write trace file \"%s\": %s", tmp_path.c_str(), strerror(errno));
+      if (fd != -1) {
+        close(fd);
+        unlink(tmp_path.c_str());
+      }
+      return false;
+    }
+    const uint32_t count = s_buffer->count.load(std::memory_order_acquire);
+    const uint32_t n = count < s_buffer->capacity ? count : s_buffer->capacity;
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    bool is_first = true;
+    for (uint32_t i = 0; i < n; i++) {
+      const event &ev = s_buffer->events[i];
+      if (ev.name == nullptr) continue; // slot claimed but not yet filled in
+      fputs(is_first ? "\n{\"name\":" : ",\n{\"name\":", file);
+      is_first = false;
+      write_json_string(file, ev.name);
+      if (ev.duration_ns < 0) {
+        fprintf(file, ",\"ph\":\"i\",\"s\":\"p\",\"ts\":%.3f", (double) ev.start_ns / 1000.0);
+      } else {
+        fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", (double) ev.start_ns / 1000.0,
+                (double) ev.duration_ns / 1000.0);
+      }
+      fprintf(file, ",\"pid\":%d,\"tid\":%d}", ev.pid, ev.tid);
+    }
+    fprintf(file, "\n],\"otherData\":{\"dropped_events\":%u}}\n", count - n);
+    const bool is_ok = fclose(file) == 0 && rename(tmp_path.c_str(), s_file_path.c_str()) == 0;
+    if (is_ok) {
+      log(LL::INFO, "wrote %u trace events to \"%s\"", n, s_file_path.c_str());
+    } else {
+      log(LL::WARN, "could not write trace file \"%s\": %s", s_file_path.c_str(), strerror(errno));
+      unlink(tmp_path.c_str());
+    }
+    return is_ok;
+  }
+
+}
@@ -0,0 +1,70 @@
+/* trace.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Startup and lifecycle timeline tracing. Spans of monotonic nanosecond time
+ * are recorded into a buffer preallocated as a shared anonymous mapping, so
+ * that spans recorded by the forked child (prior to its execv()) land in the
+ * same buffer as those of the watchdog. The buffer is written out as Chrome
+ * trace-event JSON (viewable in chrome://tracing or Perfetto).
+ * <p>
+ * While tracing is off, a span costs a single predictable branch.
+ * <p>
+ * Span names must be string literals (or otherwise live for the process lifetime).
+ */
+namespace trace {
+
+  extern bool is_on;
+
+  inline bool enabled() { return __builtin_expect(is_on, false); }
+
+  // allocates the event buffer and turns tracing on; the trace is written to file_path (%p is the pid)
+  void start(const std::string &file_path, size_t capacity_events);
+  int64_t now_ns();
+  // records a completed span
+  void record(const char *name, int64_t start_ns, int64_t duration_ns);
+  // records a point in time event
+  void instant(const char *name);
+  // writes the trace file (only by the watchdog process itself); false on failure
+  bool dump();
+
+  // records the time from its construction to its destruction
+  class span {
+  private:
+    const char * const name;
+    const int64_t start_ns;
+  public:
+    explicit span(const char *name) : name{name}, start_ns{enabled() ? now_ns() : 0} {}
+    span(const span &) = delete;
+    span& operator=(const span &) = delete;
+    ~span() {
+      if (start_ns != 0) record(name, start_ns, now_ns() - start_ns);
+    }
+  };
+
+}
+
+#endif //__TRACE_H__
@@ -0,0 +1,319 @@
+/* tsdb.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include "format2str.h"
+#include "tsdb.h"
+
+static const char file_magic[8] = { 'J', 'W', 'T', 'S', 'D', 'B', '\0', '\1' };
+static const uint8_t no_window = 0xff;
+
+static inline uint64_t to_bits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static inline double from_bits(uint64_t bits) {
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+metric_ring::metric_ring(const std::vector<std::string_view> &series_names, size_t budget_bytes, size_t block_size)
+  : block_bytes{block_size}
+{
+  for (const auto &name : series_names) {
+    names.emplace_back(name);
+  }
+  if (names.empty() || block_bytes * 8 < 2 * worst_case_bits()) {
+    throw tsdb_exception(format2str("block size %zu too small for %zu series", block_bytes, names.size()));
+  }
+  const size_t block_count = budget_bytes / block_bytes < 2 ? 2 : budget_bytes / block_bytes;
+  blocks.resize(block_count);
+  storage.resize(block_count * block_bytes);
+  prev_bits.resize(names.size());
+  prev_leading.resize(names.size());
+  prev_trailing.resize(names.size());
+}
+
+size_t metric_ring::worst_case_bits() const {
+  // '1111' + 64 bit timestamp delta-of-delta; per value '11' + 5 + 6 + 64 bits
+  return 4 + 64 + names.size() * (2 + 5 + 6 + 64);
+}
+
+void metric_ring::put_bits(uint64_t value, unsigned nbits) {
+  auto &blk = blocks[head];
+  uint8_t * const base = storage.data() + head * block_bytes;
+  while (nbits > 0) {
+    const unsigned byte_idx = blk.bit_len / 8;
+    const unsigned bit_off = blk.bit_len % 8;
+    const unsigned room = 8 - bit_off;
+    const unsigned take = nbits < room ? nbits : room;
+    const auto chunk = (uint8_t) ((value >> (nbits - take)) & ((1u << take) - 1));
+    if (bit_off == 0) base[byte_idx] = 0;
+    base[byte_idx] |= (uint8_t) (chunk << (room - take));
+    blk.bit_len += take;
+    nbits -= take;
+  }
+}
+
+void metric_ring::start_block(int64_t ts, const double *values) {
+  if (used_blocks > 0) {
+    head = (head + 1) % blocks.size();
+  }
+  if (used_blocks < blocks.size()) {
+    used_blocks++;
+  }
+  blocks[head] = block{ts, ts, 1, 0};
+  put_bits((uint64_t) ts, 64);
+  for (size_t i = 0; i < names.size(); i++) {
+    prev_bits[i] = to_bits(values[i]);
+    prev_leading[i] = no_window;
+    prev_trailing[i] = 0;
+    put_bits(prev_bits[i], 64);
+  }
+  prev_ts = ts;
+  prev_delta = 0;
+}
+
+void metric_ring::append(int64_t ts_ms, const double *values) {
+  if (used_blocks == 0 || blocks[head].bit_len + worst_case_bits() > block_bytes * 8) {
+    start_block(ts_ms, values);
+    return;
+  }
+
+  const int64_t delta = ts_ms - prev_ts;
+  const int64_t dod = delta - prev_delta;
+  if (dod == 0) {
+    put_bits(0b0, 1);
+  } else if (dod >= -63 && dod <= 64) {
+    put_bits(0b10, 2);
+    put_bits((uint64_t) (dod + 63), 7);
+  } else if (dod >= -255 && dod <= 256) {
+    put_bits(0b110, 3);
+    put_bits((uint64_t) (dod + 255), 9);
+  } else if (dod >= -2047 && dod <= 2048) {
+    put_bits(0b1110, 4);
+    put_bits((uint64_t) (dod + 2047), 12);
+  } else {
+    put_bits(0b1111, 4);
+    put_bits((uint64_t) dod, 64);
+  }
+  prev_delta = delta;
+  prev_ts = ts_ms;
+
+  for (size_t i = 0; i < names.size(); i++) {
+    const uint64_t bits = to_bits(values[i]);
+    const uint64_t xor_bits = bits ^ prev_bits[i];
+    prev_bits[i] = bits;
+    if (xor_bits == 0) {
+      put_bits(0b0, 1);
+      continue;
+    }
+    auto leading = (uint8_t) __builtin_clzll(xor_bits);
+    const auto trailing = (uint8_t) __builtin_ctzll(xor_bits);
+    if (leading > 31) leading = 31;
+    if (prev_leading[i] != no_window && leading >= prev_leading[i] && trailing >= prev_trailing[i]) {
+      // meaningful bits fit within the previous value's window
+      const unsigned significant = 64 - prev_leading[i] - prev_trailing[i];
+      put_bits(0b10, 2);
+      put_bits(xor_bits >> prev_trailing[i], significant);
+    } else {
+      const unsigned significant = 64 - leading - trailing;
+      put_bits(0b11, 2);
+      put_bits(leading, 5);
+      put_bits(significant - 1, 6);
+      put_bits(xor_bits >> trailing, significant);
+      prev_leading[i] = leading;
+      prev_trailing[i] = trailing;
+    }
+  }
+
+  auto &blk = blocks[head];
+  blk.last_ts = ts_ms;
+  blk.count++;
+}
+
+size_t metric_ring::write_since(const std::string &path, int64_t since_ts_ms) const {
+  const auto tmp_path = path + ".tmp";
+  auto const close_file = [](FILE *f) { if (f != nullptr) fclose(f); };
+  std::unique_ptr<FILE, decltype(close_file)> file_sp(fopen(tmp_path.c_str(), "we"), close_file);
+  if (!file_sp) {
+    throw tsdb_exception(format2str("can't create '%s': %s", tmp_path.c_str(), strerror(errno)));
+  }
+  FILE * const file = file_sp.get();
+
+  std::vector<size_t> selected;
+  for (size_t i = 0; i < used_blocks; i++) {
+    const size_t idx = (head + blocks.size() - (used_blocks - 1) + i) % blocks.size();
+    if (blocks[idx].last_ts >= since_ts_ms) {
+      selected.push_back(idx);
+    }
+  }
+
+  fwrite(file_magic, sizeof(file_magic), 1, file);
+  const auto series_count = (uint32_t) names.size();
+  fwrite(&series_count, sizeof(series_count), 1, file);
+  for (const auto &name : names) {
+    const auto len = (uint16_t) name.size();
+    fwrite(&len, sizeof(len), 1, file);
+    fwrite(name.data(), len, 1, file);
+  }
+  const auto block_count = (uint32_t) selected.size();
+  fwrite(&block_count, sizeof(block_count), 1, file);
+  size_t samples = 0;
+  for (const auto idx : selected) {
+    const auto &blk = blocks[idx];
+    fwrite(&blk.first_ts, sizeof(blk.first_ts), 1, file);
+    fwrite(&blk.last_ts, sizeof(blk.last_ts), 1, file);
+    fwrite(&blk.count, sizeof(blk.count), 1, file);
+    fwrite(&blk.bit_len, sizeof(blk.bit_len), 1, file);
+    fwrite(storage.data() + idx * block_bytes, (blk.bit_len + 7) / 8, 1, file);
+    samples += blk.count;
+  }
+  if (ferror(file) || fflush(file) != 0) {
+    throw tsdb_exception(format2str("failed writing '%s': %s", tmp_path.c_str(), strerror(errno)));
+  }
+  file_sp.reset(nullptr);
+  if (rename(tmp_path.c_str(), path.c_str()) == -1) {
+    throw tsdb_exception(format2str("can't rename '%s': %s", tmp_path.c_str(), strerror(errno)));
+  }
+  return samples;
+}
+
+namespace {
+  // MSB first bit reader over one block's bytes
+  class bit_reader {
+    const std::vector<uint8_t> &buf;
+    size_t pos{0};
+  public:
+    explicit bit_reader(const std::vector<uint8_t> &bytes) : buf{bytes} {}
+    uint64_t get(unsigned nbits) {
+      uint64_t value = 0;
+      while (nbits > 0) {
+        if (pos / 8 >= buf.size()) throw tsdb_exception("truncated metrics block");
+        const unsigned bit_off = pos % 8;
+        const unsigned room = 8 - bit_off;
+        const unsigned take = nbits < room ? nbits : room;
+        const unsigned chunk = (buf[pos / 8] >> (room - take)) & ((1u << take) - 1);
+        value = (value << take) | chunk;
+        pos += take;
+        nbits -= take;
+      }
+      return value;
+    }
+  };
+}
+
+void metric_ring::decode_file(const std::string &path, const names_visitor_t &names_visitor,
+                              const sample_visitor_t &visitor)
+{
+  auto const close_file = [](FILE *f) { if (f != nullptr) fclose(f); };
+  std::unique_ptr<FILE, decltype(close_file)> file_sp(fopen(path.c_str(), "re"), close_file);
+  if (!file_sp) {
+    throw tsdb_exception(format2str("can't open '%s': %s", path.c_str(), strerror(errno)));
+  }
+  FILE * const file = file_sp.get();
+  const auto read_exact = [file, &path](void *dst, size_t size) {
+    if (size > 0 && fread(dst, size, 1, file) != 1) {
+      throw tsdb_exception(format2str("'%s' is truncated or not a metrics file", path.c_str()));
+    }
+  };
+
+  char magic[sizeof(file_magic)];
+  read_exact(magic, sizeof(magic));
+  if (memcmp(magic, file_magic, sizeof(file_magic)) != 0) {
+    throw tsdb_exception(format2str("'%s' is not a metrics file", path.c_str()));
+  }
+  uint32_t series_count = 0;
+  read_exact(&series_count, sizeof(series_count));
+  std::vector<std::string> series_names;
+  for (uint32_t i = 0; i < series_count; i++) {
+    uint16_t len = 0;
+    read_exact(&len, sizeof(len));
+    std::string name(len, '\0');
+    read_exact(name.data(), len);
+    series_names.emplace_back(std::move(name));
+  }
+  names_visitor(series_names);
+
+  uint32_t block_count = 0;
+  read_exact(&block_count, sizeof(block_count));
+  std::vector<uint8_t> bytes;
+  std::vector<uint64_t> prev_bits(series_count);
+  std::vector<uint8_t> prev_leading(series_count), prev_trailing(series_count);
+  std::vector<double> values(series_count);
+  for (uint32_t b = 0; b < block_count; b++) {
+    block blk;
+    read_exact(&blk.first_ts, sizeof(blk.first_ts));
+    read_exact(&blk.last_ts, sizeof(blk.last_ts));
+    read_exact(&blk.count, sizeof(blk.count));
+    read_exact(&blk.bit_len, sizeof(blk.bit_len));
+    bytes.resize((blk.bit_len + 7) / 8);
+    read_exact(bytes.data(), bytes.size());
+
+    bit_reader rd{bytes};
+    int64_t ts = (int64_t) rd.get(64);
+    int64_t delta = 0;
+    for (uint32_t i = 0; i < series_count; i++) {
+      prev_bits[i] = rd.get(64);
+      prev_leading[i] = no_window;
+      values[i] = from_bits(prev_bits[i]);
+    }
+    visitor(ts, values.data());
+
+    for (uint32_t n = 1; n < blk.count; n++) {
+      int64_t dod;
+      if (rd.get(1) == 0) {
+        dod = 0;
+      } else if (rd.get(1) == 0) {
+        dod = (int64_t) rd.get(7) - 63;
+      } else if (rd.get(1) == 0) {
+        dod = (int64_t) rd.get(9) - 255;
+      } else if (rd.get(1) == 0) {
+        dod = (int64_t) rd.get(12) - 2047;
+      } else {
+        dod = (int64_t) rd.get(64);
+      }
+      delta += dod;
+      ts += delta;
+      for (uint32_t i = 0; i < series_count; i++) {
+        if (rd.get(1) == 0) continue; // unchanged value
+        uint64_t xor_bits;
+        if (rd.get(1) == 0) {
+          const unsigned significant = 64 - prev_leading[i] - prev_trailing[i];
+          xor_bits = rd.get(significant) << prev_trailing[i];
+        } else {
+          const auto leading = (unsigned) rd.get(5);
+          const auto significant = (unsigned) rd.get(6) + 1;
+          const unsigned trailing = 64 - leading - significant;
+          xor_bits = rd.get(significant) << trailing;
+          prev_leading[i] = (uint8_t) leading;
+          prev_trailing[i] = (uint8_t) trailing;
+        }
+        prev_bits[i] ^= xor_bits;
+        values[i] = from_bits(prev_bits[i]);
+      }
+      visitor(ts, values.data());
+    }
+  }
+}
@@ -0,0 +1,93 @@
+/* tsdb.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __TSDB_H__
+#define __TSDB_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "decl-exception.h"
+
+// declare tsdb_exception
+DECL_EXCEPTION(tsdb)
+
+/**
+ * Fixed memory budget ring of compressed multi-series samples, encoded per
+ * the Gorilla paper (Pelkonen et al., VLDB 2015): timestamps are stored as
+ * delta-of-deltas and each value as the XOR against its predecessor in the
+ * same series, using variable length bit fields.
+ * <p>
+ * The budget is divided into fixed size blocks which are each independently
+ * decodable (the first sample of a block is stored verbatim). When the ring
+ * is full the oldest block is recycled, so memory use never grows.
+ * <p>
+ * The dump file is the raw compressed blocks plus a small header naming the
+ * series - read it back with decode_file() (java-watchdog --decode-metrics).
+ */
+class metric_ring {
+private:
+  struct block {
+    int64_t first_ts{0};
+    int64_t last_ts{0};
+    uint32_t count{0};
+    uint32_t bit_len{0};
+  };
+  std::vector<std::string> names;
+  size_t block_bytes;
+  std::vector<block> blocks;
+  std::vector<uint8_t> storage;       // blocks.size() * block_bytes, allocated up front
+  size_t head{0};                     // block currently being appended to
+  size_t used_blocks{0};
+  // encoder state of the head block
+  int64_t prev_ts{0};
+  int64_t prev_delta{0};
+  std::vector<uint64_t> prev_bits;
+  std::vector<uint8_t> prev_leading;
+  std::vector<uint8_t> prev_trailing;
+
+  size_t worst_case_bits() const;
+  void start_block(int64_t ts, const double *values);
+  void put_bits(uint64_t value, unsigned nbits);
+public:
+  metric_ring(const std::vector<std::string_view> &series_names, size_t budget_bytes, size_t block_size = 4096);
+  metric_ring(const metric_ring &) = delete;
+  metric_ring& operator=(const metric_ring &) = delete;
+
+  size_t series_count() const { return names.size(); }
+  size_t capacity_bytes() const { return storage.size(); }
+
+  // appends one sample, values must hold series_count() entries
+  void append(int64_t ts_ms, const double *values);
+
+  // writes the blocks holding samples at or after since_ts_ms to file path; returns samples written
+  size_t write_since(const std::string &path, int64_t since_ts_ms) const;
+
+  using names_visitor_t  = std::function<void(const std::vector<std::string> &series_names)>;
+  using sample_visitor_t = std::function<void(int64_t ts_ms, const double *values)>;
+
+  // decodes a file written by write_since(), visiting the series names then each sample (in time order)
+  static void decode_file(const std::string &path, const names_visitor_t &names_visitor,
+                          const sample_visitor_t &sample_visitor);
+};
+
+#endif //__TSDB_H__
@@ -0,0 +1,502 @@
+/* tuning.cpp
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "cgroup.h"
+#include "format2str.h"
+#include "log.h"
+#include "malloc-policy.h"
+#include "path-concat.h"
+#include "proc-stats.h"
+#include "tuning.h"
+
+using namespace logger;
+
+namespace {
+
+  // upper bounds of the pause histogram buckets (the last takes the rest)
+  constexpr double pause_bounds_ms[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, HUGE_VAL };
+
+  // the JVM warns so when its code cache (or a segment of it) fills up and it stops compiling
+  constexpr std::string_view code_cache_full = "is full. Compiler has been disabled";
+
+  constexpr uint64_t mb = 1024 * 1024;
+
+  // value of a "name 1234" line of cpu.stat
+  uint64_t stat_value(const std::string &stat, const char *name) {
+    const auto pos = stat.find(name);
+    return pos != std::string::npos ? strtoull(stat.c_str() + pos + strlen(name), nullptr, 10) : 0;
+  }
+
+  // cpu.stat of the watchdog's cgroup (v2 or v1); empty if there is none
+  std::string read_cpu_stat() {
+    const auto v2 = cgroup::v2_file("cpu.stat");
+    if (!v2.empty()) return cgroup::read_file(v2);
+    const auto v1 = cgroup::v1_dir("cpu");
+    return v1.empty() ? std::string() : cgroup::read_file(path_concat(v1, "cpu.stat"));
+  }
+
+  // the size an option sets (e.g. 1280m of -Xmx1280m, 32m of -XX:G1HeapRegionSize=32m); zero if none
+  uint64_t option_size(const std::vector<std::string> &options, const std::string_view name) {
+    for (const auto &option : options) {
+      if (jvm_option_name(option) != name) continue;
+      const auto eq = option.find('=');
+      uint64_t size = 0;
+      cfg_to_size(eq != std::string::npos ? option.substr(eq + 1) : option.substr(name.size()), size);
+      return size;
+    }
+    return 0;
+  }
+
+  // JVM defaults per HotSpot's ergonomics
+  uint64_t default_region_size(uint64_t heap) {
+    uint64_t region = mb;
+    while (region < 32 * mb && region * 2 <= heap / 2048) region *= 2;
+    return region;
+  }
+  unsigned default_gc_threads(unsigned cpus) {
+    return cpus <= 8 ? cpus : 8 + (cpus - 8) * 5 / 8;
+  }
+
+  std::string to_mb_str(uint64_t size) {
+    return format2str("%lum", (unsigned long) (size / mb));
+  }
+
+}
+
+double jvm_tuner::profile::pause_pct(double pct) const {
+  uint64_t total = 0;
+  for (const auto count : pauses) total += count;
+  if (total == 0) return 0.0;
+  const auto rank = (uint64_t) std::ceil((double) total * pct / 100.0);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < pause_buckets; i++) {
+    seen += pauses[i];
+    if (seen >= rank) return std::min(pause_bounds_ms[i], max_pause_ms);
+  }
+  return max_pause_ms;
+}
+
+bool jvm_tuner::read_profile(profile &prior) const {
+  const auto content = cgroup::read_file(cfg.state_file);
+  if (content.empty()) return false;
+  size_t pos = 0;
+  while (pos < content.size()) {
+    auto eol = content.find('\n', pos);
+    if (eol == std::string::npos) eol = content.size();
+    const std::string line = content.substr(pos, eol - pos);
+    pos = eol + 1;
+    const auto eq = line.find('=');
+    if (line.empty() || line[0] == '#' || eq == std::string::npos) continue;
+    const auto key = line.substr(0, eq);
+    const auto value = line.substr(eq + 1);
+    const auto to_u64 = [&value]() { return (uint64_t) strtoull(value.c_str(), nullptr, 10); };
+    const auto to_double = [&value]() { return strtod(value.c_str(), nullptr); };
+    if (key == "main") prior.main = value;
+    else if (key == "options") {
+      size_t opt_pos = 0;
+      while ((opt_pos = value.find_first_not_of(' ', opt_pos)) != std::string::npos) {
+        const auto end = std::min(value.find(' ', opt_pos), value.size());
+        prior.options.push_back(value.substr(opt_pos, end - opt_pos));
+        opt_pos = end;
+      }
+    }
+    else if (key == "uptime_ms") prior.uptime_ms = (int64_t) to_u64();
+    else if (key == "exit_status") prior.exit_status = (int) to_u64();
+    else if (key == "oom_killed") prior.is_oom_killed = value == "1";
+    else if (key == "gc_count") prior.gc_count = to_u64();
+    else if (key == "gc_ms") prior.gc_ms = to_double();
+    else if (key == "full_gc_count") prior.full_gc_count = to_u64();
+    else if (key == "pauses") {
+      const char *p = value.c_str();
+      for (size_t i = 0; i < pause_buckets && *p != '\0'; i++) {
+        char *end = nullptr;
+        prior.pauses[i] = strtoull(p, &end, 10);
+        if (end == p) break;
+        p = end;
+      }
+    }
+    else if (key == "max_pause_ms") prior.max_pause_ms = to_double();
+    else if (key == "heap_max_kb") prior.heap_max_kb = to_u64();
+    else if (key == "heap_peak_kb") prior.heap_peak_kb = to_u64();
+    else if (key == "rss_peak_kb") prior.rss_peak_kb = to_u64();
+    else if (key == "native_peak_kb") prior.native_peak_kb = to_u64();
+    else if (key == "metaspace_peak_kb") prior.metaspace_peak_kb = to_u64();
+    else if (key == "compiles") prior.compiles = to_u64();
+    else if (key == "compile_ms") prior.compile_ms = to_double();
+    else if (key == "code_kb") prior.code_kb = to_u64();
+    else if (key == "code_cache_full") prior.is_code_cache_full = value == "1";
+    else if (key == "throttled_pct") prior.throttled_pct = to_double();
+  }
+  return true;
+}
+
+void jvm_tuner::write_profile() const {
+  std::string options;
+  for (const auto &option : run.options) {
+    if (!options.empty()) options += ' ';
+    options += option;
+  }
+  std::string pauses;
+  for (const auto count : run.pauses) {
+    format_append(pauses, pauses.empty() ? "%lu" : " %lu", (unsigned long) count);
+  }
+  const auto tmp_file = cfg.state_file + ".tmp";
+  FILE * const file = fopen(tmp_file.c_str(), "we");
+  bool is_written = file != nullptr && fprintf(file,
+      "# java-watchdog run profile: written when the JVM terminates, read by its next launch\n"
+      "main=%s\noptions=%s\nuptime_ms=%ld\nexit_status=%d\noom_killed=%d\n"
+      "gc_count=%lu\ngc_ms=%.1f\nfull_gc_count=%lu\npauses=%s\npause_p50_ms=%.0f\npause_p99_ms=%.0f\n"
+      "max_pause_ms=%.1f\nheap_max_kb=%lu\nheap_peak_kb=%lu\nrss_peak_kb=%lu\nnative_peak_kb=%lu\n"
+      "metaspace_peak_kb=%lu\ncompiles=%lu\ncompile_ms=%.1f\ncode_kb=%lu\ncode_cache_full=%d\nthrottled_pct=%.1f\n",
+      run.main.c_str(), options.c_str(), (long) run.uptime_ms, run.exit_status, run.is_oom_killed ? 1 : 0,
+      (unsigned long) run.gc_count, run.gc_ms, (unsigned long) run.full_gc_count, pauses.c_str(),
+      run.pause_pct(50), run.pause_pct(99), run.max_pause_ms, (unsigned long) run.heap_max_kb,
+      (unsigned long) run.heap_peak_kb, (unsigned long) run.rss_peak_kb, (unsigned long) run.native_peak_kb,
+      (unsigned long) run.metaspace_peak_kb, (unsigned long) run.compiles, run.compile_ms,
+      (unsigned long) run.code_kb, run.is_code_cache_full ? 1 : 0, run.throttled_pct) > 0;
+  if (file != nullptr) is_written = fclose(file) == 0 && is_written;
+  if (!is_written || rename(tmp_file.c_str(), cfg.state_file.c_str()) != 0) {
+    log(LL::WARN, "could not write the JVM run profile to \"%s\": %s", cfg.state_file.c_str(), strerror(errno));
+  }
+}
+
+bool jvm_tuner::prepare(jvm_args &args) {
+  if (!cfg.enabled) return false;
+  if (cfg.state_file.empty()) {
+    log(LL::WARN, "tuning requires a state_file - the JVM is not tuned");
+    return false;
+  }
+  if (run.main.empty()) {
+    // what the user sets is left alone (so is what a [rewrite.NAME] rule or another section sets)
+    const auto is_set = [&args](std::initializer_list<std::string_view> prefixes) {
+      return std::any_of(prefixes.begin(), prefixes.end(), [&args](std::string_view p) { return args.has_option(p); });
+    };
+    if (!is_set({ "-Xmx", "-XX:MaxHeapSize=", "-XX:MaxRAMPercentage=", "-XX:MaxRAMFraction=", "-XX:MaxRAM=" })) {
+      owned.emplace_back("-Xmx");
+    }
+    is_concurrent_gc = is_set({ "-XX:+UseZGC", "-XX:+UseShenandoahGC" });
+    is_g1 = args.has_option("-XX:+UseG1GC") || (jdk.feature != 8 && !is_concurrent_gc &&
+            !is_set({ "-XX:+UseParallelGC", "-XX:+UseSerialGC", "-XX:+UseEpsilonGC" }));
+    if (is_g1 && !args.has_option("-XX:G1HeapRegionSize=")) owned.emplace_back("-XX:G1HeapRegionSize");
+    is_tiered = !args.has_option("-XX:-TieredCompilation");
+    if (!args.has_option("-XX:ReservedCodeCacheSize=")) owned.emplace_back("-XX:ReservedCodeCacheSize");
+    if (!is_set({ "-XX:ParallelGCThreads=", "-XX:ConcGCThreads=", "-XX:ActiveProcessorCount=" })) {
+      owned.emplace_back("-XX:ParallelGCThreads");
+      owned.emplace_back("-XX:ConcGCThreads");
+    }
+    const auto main_index = args.main_index();
+    run.main = main_index < args.size() ? args[main_index] : std::string("-");
+  }
+
+  profile prior;
+  if (!read_profile(prior)) {
+    log(LL::DEBUG, "no JVM run profile in \"%s\" yet - launching untuned", cfg.state_file.c_str());
+    return false;
+  }
+  if (prior.main != run.main) {
+    log(LL::INFO, "JVM run profile \"%s\" is of \"%s\", not \"%s\" - launching untuned", cfg.state_file.c_str(),
+        prior.main.c_str(), run.main.c_str());
+    return false;
+  }
+
+  // the adjustments of earlier launches carry forward
+  std::vector<std::string> options;
+  for (const auto &option : prior.options) {
+    if (std::find(owned.begin(), owned.end(), jvm_option_name(option)) != owned.end()) options.push_back(option);
+  }
+  const auto is_owned = [this](const char *name) { return std::find(owned.begin(), owned.end(), name) != owned.end(); };
+  const auto set = [&options](const std::string &option) {
+    const auto name = jvm_option_name(option);
+    const auto it = std::find_if(options.begin(), options.end(),
+                                 [&name](const std::string &o) { return jvm_option_name(o) == name; });
+    if (it != options.end()) *it = option; else options.push_back(option);
+  };
+  std::string changes;
+  const auto change = [&](const char *name, const std::string &from, const std::string &to, const std::string &why) {
+    const auto value = to.substr(to[strlen(name)] == '=' ? strlen(name) + 1 : strlen(name));
+    log(LL::INFO, "tuning %s: %s -> %s (%s)", name, from.c_str(), value.c_str(), why.c_str());
+    changes += changes.empty() ? to : " " + to;
+  };
+
+  if (prior.uptime_ms < cfg.min_uptime.count()) {
+    log(LL::INFO, "previous run lasted %ld ms, under the tuning min_uptime - keeping its JVM options",
+        (long) prior.uptime_ms);
+  } else {
+    const double step = cfg.step_pct / 100.0;
+    const double p99 = prior.pause_pct(99);
+    const double gc_pct = prior.uptime_ms > 0 ? 100.0 * prior.gc_ms / (double) prior.uptime_ms : 0.0;
+    uint64_t limit = memory_limit_bytes();
+    if (limit == 0) limit = (uint64_t) sysconf(_SC_PHYS_PAGES) * (uint64_t) sysconf(_SC_PAGESIZE);
+
+    // heap: grown under GC pressure, shrunk when mostly idle, always within the guardrails
+    uint64_t heap = option_size(options, "-Xmx");
+    if (heap == 0) heap = prior.heap_max_kb > 0 ? prior.heap_max_kb * 1024 : limit / 4; // MaxRAMPercentage=25
+    uint64_t new_heap = heap;
+    if (is_owned("-Xmx")) {
+      const double used = heap > 0 ? (double) prior.heap_peak_kb * 1024 / (double) heap : 0.0;
+      std::string why;
+      if (prior.is_oom_killed) {
+        new_heap = (uint64_t) ((double) heap * (1.0 - step));
+        why = "the JVM was OOM killed";
+      } else if ((prior.full_gc_count > 0 && !is_concurrent_gc) || gc_pct > cfg.gc_overhead_pct ||
+                 (p99 > (double) cfg.pause_target.count() && used >= 0.7))
+      {
+        new_heap = (uint64_t) ((double) heap * (1.0 + step));
+        why = format2str("%lu full GCs, GC overhead %.1f%%, p99 pause %.0f ms, peak heap %.0f%% in use",
+                         (unsigned long) prior.full_gc_count, gc_pct, p99, used * 100.0);
+      } else if (prior.heap_peak_kb > 0 && used < 0.4 && p99 <= (double) cfg.pause_target.count()) {
+        new_heap = std::max((uint64_t) ((double) heap * (1.0 - step)), prior.heap_peak_kb * 1024 * 2);
+        why = format2str("peak heap %.0f%% in use", used * 100.0);
+      }
+      const uint64_t native = prior.native_peak_kb * 1024;
+      uint64_t ceiling = limit / 100 * cfg.memory_pct;
+      ceiling = ceiling > native ? ceiling - native : 0;
+      if (cfg.max_heap != 0) ceiling = std::min(ceiling, cfg.max_heap);
+      if (new_heap > ceiling) {
+        new_heap = ceiling;
+        why += format2str("%sbounded to %s by the guardrails (peak native memory %lu MB)", why.empty() ? "" : "; ",
+                          to_mb_str(ceiling).c_str(), (unsigned long) (native / mb));
+      }
+      new_heap = std::max(new_heap, cfg.min_heap) / mb * mb;
+      if (new_heap / mb != heap / mb) {
+        change("-Xmx", to_mb_str(heap), "-Xmx" + to_mb_str(new_heap), why);
+        set("-Xmx" + to_mb_str(new_heap));
+      }
+    }
+
+    // G1 region size: full GCs while much of the heap is free are the sign of humongous allocations
+    if (is_owned("-XX:G1HeapRegionSize")) {
+      const uint64_t region = option_size(options, "-XX:G1HeapRegionSize");
+      const uint64_t from = region != 0 ? region : default_region_size(new_heap);
+      const double used = (double) prior.heap_peak_kb * 1024 / (double) std::max(heap, mb);
+      if (prior.full_gc_count > 0 && used < 0.8 && from < 32 * mb) {
+        const auto option = "-XX:G1HeapRegionSize=" + to_mb_str(from * 2);
+        change("-XX:G1HeapRegionSize", to_mb_str(from), option,
+               format2str("%lu full GCs with %.0f%% of the heap in use", (unsigned long) prior.full_gc_count,
+                          used * 100.0));
+        set(option);
+      }
+    }
+
+    // code cache: grown once it filled up (the JVM then stops compiling)
+    if (is_owned("-XX:ReservedCodeCacheSize") && prior.is_code_cache_full) {
+      uint64_t size = option_size(options, "-XX:ReservedCodeCacheSize");
+      if (size == 0) size = is_tiered ? 240 * mb : 48 * mb;
+      const uint64_t new_size = std::min((uint64_t) ((double) size * (1.0 + step)), cfg.max_code_cache) / mb * mb;
+      if (new_size > size) {
+        const auto option = "-XX:ReservedCodeCacheSize=" + to_mb_str(new_size);
+        change("-XX:ReservedCodeCacheSize", to_mb_str(size), option,
+               format2str("the code cache filled up after %lu compilations", (unsigned long) prior.compiles));
+        set(option);
+      } else {
+        log(LL::WARN, "the JVM's code cache filled up, but it is at the tuning max_code_cache of %s already",
+            to_mb_str(cfg.max_code_cache).c_str());
+      }
+    }
+
+    // GC threads: cut while the CPU quota throttles, restored towards the default once pauses suffer
+    if (is_owned("-XX:ParallelGCThreads")) {
+      const auto cpus = (unsigned) std::ceil(effective_cpus(std::string()));
+      const unsigned max_threads = cfg.max_gc_threads != 0 ? cfg.max_gc_threads : cpus;
+      const unsigned initial = default_gc_threads(cpus);
+      const auto carried = (unsigned) option_size(options, "-XX:ParallelGCThreads");
+      const unsigned threads = carried != 0 ? carried : initial;
+      unsigned new_threads = threads;
+      std::string why;
+      if (prior.throttled_pct >= cfg.throttle_pct) {
+        new_threads = std::max(1U, std::min(threads - 1, (unsigned) ((double) threads * (1.0 - step))));
+        why = format2str("%.0f%% of CFS periods throttled", prior.throttled_pct);
+      } else if (carried != 0 && threads < initial && p99 > (double) cfg.pause_target.count()) {
+        new_threads = std::min(initial, std::max(threads + 1, (unsigned) ((double) threads * (1.0 + step))));
+        why = format2str("p99 pause %.0f ms without CFS throttling", p99);
+      }
+      if (new_threads > max_threads) {
+        new_threads = max_threads;
+        why += format2str("%sbounded to %u by the guardrails", why.empty() ? "" : "; ", max_threads);
+      }
+      if (new_threads != threads) {
+        const auto option = format2str("-XX:ParallelGCThreads=%u", new_threads);
+        change("-XX:ParallelGCThreads", std::to_string(threads), option, why);
+        set(option);
+        set(format2str("-XX:ConcGCThreads=%u", std::max(1U, (new_threads + 3) / 4)));
+      }
+    }
+  }
+
+  if (!cfg.apply) {
+    if (!changes.empty()) log(LL::INFO, "tuning recommends for the next launch: %s", changes.c_str());
+    return false;
+  }
+  // (a carried option already set by an earlier prepare() is replaced in place)
+  bool is_changed = false;
+  for (const auto &option : options) {
+    if (args.option_value(jvm_option_name(option)) == option.substr(jvm_option_name(option).size())) continue;
+    args.set_option(option);
+    is_changed = true;
+  }
+  run.options = std::move(options);
+  if (is_changed) {
+    std::string applied;
+    for (const auto &option : run.options) applied += " " + option;
+    log(LL::INFO, "JVM options tuned from the run profile \"%s\":%s", cfg.state_file.c_str(), applied.c_str());
+  }
+  return is_changed;
+}
+
+void jvm_tuner::attach(event_loop &event_loop, pid_t child_pid, output_relay *relay) {
+  if (!cfg.enabled || cfg.state_file.empty()) return;
+  pid = child_pid;
+  auto options = std::move(run.options);
+  auto main = std::move(run.main);
+  run = profile{};
+  run.options = std::move(options);
+  run.main = std::move(main);
+  samples = 0;
+  prev_gc_count = prev_gc_ticks = prev_safepoint_ticks = -1;
+  output_carry.clear();
+  attach_ns = monotonic_ns();
+  const auto stat = read_cpu_stat();
+  start_periods = stat_value(stat, "nr_periods ");
+  start_throttled = stat_value(stat, "nr_throttled ");
+  statm_fd = open(format2str("/proc/%d/statm", pid).c_str(), O_RDONLY | O_CLOEXEC);
+  loop = &event_loop;
+  sample_timer = loop->add_timer(cfg.sample_interval, [this]() { sample(); });
+  if (relay != nullptr) {
+    relay->add_listener([this](const std::string_view chunk) { on_output(chunk); });
+  }
+}
+
+void jvm_tuner::detach() {
+  if (loop != nullptr) {
+    if (sample_timer != -1) loop->cancel_timer(sample_timer);
+    loop = nullptr;
+  }
+  sample_timer = -1;
+  if (statm_fd != -1) {
+    close(statm_fd);
+    statm_fd = -1;
+  }
+  hsperf.detach();
+}
+
+void jvm_tuner::on_output(const std::string_view chunk) {
+  if (run.is_code_cache_full || loop == nullptr) return;
+  output_carry.append(chunk);
+  if (output_carry.find(code_cache_full) != std::string::npos) {
+    run.is_code_cache_full = true;
+    output_carry.clear();
+    log(LL::WARN, "child process (pid:%d) code cache is full - the JVM stopped compiling", pid);
+    return;
+  }
+  if (output_carry.size() >= code_cache_full.size()) {
+    output_carry.erase(0, output_carry.size() - (code_cache_full.size() - 1));
+  }
+}
+
+void jvm_tuner::sample() {
+  static const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+  uint64_t rss_kb = 0;
+  char buf[128];
+  const ssize_t n = statm_fd != -1 ? pread(statm_fd, buf, sizeof(buf) - 1, 0) : -1;
+  if (n > 0) {
+    buf[n] = '\0';
+    char *end = nullptr;
+    strtoull(buf, &end, 10); // size, then resident
+    rss_kb = strtoull(end, nullptr, 10) * (uint64_t) page_kb;
+    run.rss_peak_kb = std::max(run.rss_peak_kb, rss_kb);
+  }
+
+  // the hsperfdata file appears a while into JVM startup (retried less often once that is past)
+  samples++;
+  if (!hsperf.is_attached() && (samples < 30 || samples % 10 == 0)) {
+    hsperf.attach(pid);
+  }
+  if (!hsperf.is_attached()) return;
+
+  const int64_t gc_count = hsperf.sum("sun.gc.collector.", ".invocations");
+  const int64_t gc_ticks = hsperf.sum("sun.gc.collector.", ".time");
+  const int64_t safepoint_ticks = hsperf.get("sun.rt.safepointTime");
+  if (prev_gc_count >= 0 && gc_count > prev_gc_count) {
+    // the pauses of the sample all count as of their mean; a collector's time beyond the time spent
+    // in safepoints was concurrent (e.g. a ZGC cycle) rather than a pause
+    const auto count = (uint64_t) (gc_count - prev_gc_count);
+    double pause_ms = hsperf.ticks_to_ms(gc_ticks - prev_gc_ticks);
+    if (safepoint_ticks >= 0 && prev_safepoint_ticks >= 0) {
+      pause_ms = std::min(pause_ms, hsperf.ticks_to_ms(safepoint_ticks - prev_safepoint_ticks));
+    }
+    const double mean_ms = pause_ms / (double) count;
+    size_t bucket = 0;
+    while (mean_ms > pause_bounds_ms[bucket]) bucket++;
+    run.pauses[bucket] += count;
+    run.max_pause_ms = std::max(run.max_pause_ms, mean_ms);
+    run.gc_count += count;
+    run.gc_ms += pause_ms;
+  }
+  prev_gc_count = gc_count;
+  prev_gc_ticks = gc_ticks;
+  prev_safepoint_ticks = safepoint_ticks;
+  if (!is_concurrent_gc) {
+    run.full_gc_count = (uint64_t) std::max<int64_t>(0, hsperf.get("sun.gc.collector.1.invocations"));
+  }
+
+  const auto counter = [this](const std::string_view name) {
+    return (uint64_t) std::max<int64_t>(0, hsperf.get(name));
+  };
+  const uint64_t heap_used_kb = (uint64_t) std::max<int64_t>(0, hsperf.sum("sun.gc.generation.", ".used")) / 1024;
+  const uint64_t committed_kb = (counter("sun.gc.generation.0.capacity") + counter("sun.gc.generation.1.capacity")) / 1024;
+  // each G1 (and ZGC) generation may grow to the whole heap, whereas the others divide it up
+  const uint64_t young_max = counter("sun.gc.generation.0.maxCapacity");
+  const uint64_t old_max = counter("sun.gc.generation.1.maxCapacity");
+  run.heap_max_kb = (is_g1 || is_concurrent_gc ? std::max(young_max, old_max) : young_max + old_max) / 1024;
+  run.heap_peak_kb = std::max(run.heap_peak_kb, heap_used_kb);
+  if (rss_kb > committed_kb) run.native_peak_kb = std::max(run.native_peak_kb, rss_kb - committed_kb);
+  run.metaspace_peak_kb = std::max(run.metaspace_peak_kb, counter("sun.gc.metaspace.used") / 1024);
+  run.compiles = counter("sun.ci.totalCompiles");
+  run.compile_ms = hsperf.ticks_to_ms((int64_t) counter("java.ci.totalTime"));
+  run.code_kb = counter("sun.ci.nmethodCodeSize") / 1024;
+}
+
+void jvm_tuner::finish(int status, bool is_killed, long max_rss_kb) {
+  if (!cfg.enabled || cfg.state_file.empty() || attach_ns == 0) return;
+  run.uptime_ms = (monotonic_ns() - attach_ns) / 1000000;
+  attach_ns = 0;
+  run.exit_status = status;
+  run.is_oom_killed = WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL && !is_killed;
+  if (max_rss_kb > 0) run.rss_peak_kb = std::max(run.rss_peak_kb, (uint64_t) max_rss_kb);
+  const auto stat = read_cpu_stat();
+  const uint64_t periods = stat_value(stat, "nr_periods ") - start_periods;
+  const uint64_t throttled = stat_value(stat, "nr_throttled ") - start_throttled;
+  run.throttled_pct = periods > 0 ? 100.0 * (double) throttled / (double) periods : 0.0;
+  log(LL::INFO, "JVM run profile (pid:%d): %ld s, %lu GCs (%lu full) taking %.1f%%, p50/p99 pause %.0f/%.0f ms, "
+      "heap peak %lu of %lu MB, native peak %lu MB, %lu compilations%s, %.0f%% throttled", pid,
+      (long) (run.uptime_ms / 1000), (unsigned long) run.gc_count, (unsigned long) run.full_gc_count,
+      run.uptime_ms > 0 ? 100.0 * run.gc_ms / (double) run.uptime_ms : 0.0, run.pause_pct(50), run.pause_pct(99),
+      (unsigned long) (run.heap_peak_kb / 1024), (unsigned long) (run.heap_max_kb / 1024),
+      (unsigned long) (run.native_peak_kb / 1024), (unsigned long) run.compiles,
+      run.is_code_cache_full ? " (code cache full)" : "", run.throttled_pct);
+  write_profile();
+}
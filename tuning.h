@@ -0,0 +1,122 @@
+/* tuning.h
+
+Copyright 2026 Roger D. Voss
+
+Created by roger-dv on 10/18/2026.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#ifndef __TUNING_H__
+#define __TUNING_H__
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include "settings.h"
+#include "event-loop.h"
+#include "hsperf.h"
+#include "jdk-info.h"
+#include "jvm-args.h"
+#include "output-relay.h"
+
+/**
+ * Feedback-directed tuning of the JVM across launches. Each run of the child
+ * is profiled - its GC pause distribution and overhead, full GCs, peak heap
+ * occupancy, peak native memory (RSS beyond the committed heap), compilation
+ * counts and whether the code cache filled up, the share of CFS periods its
+ * cgroup was throttled - and the profile is written to state_file when the
+ * child terminates.
+ * <p>
+ * The next launch reads the profile back and adjusts -Xmx, G1HeapRegionSize,
+ * ReservedCodeCacheSize and the GC thread counts, each by at most step_pct
+ * (the region size by one power of two) and within the config.ini guardrails:
+ * the heap stays between min_heap and max_heap, and together with the peak
+ * native memory within memory_pct of the cgroup memory limit. Adjustments
+ * carry forward from launch to launch (the profile records the options they
+ * made), so a value moves towards what the application needs over successive
+ * runs. Options the command line sets are never touched, and a run shorter
+ * than min_uptime or of another main class is not tuned from.
+ */
+class jvm_tuner {
+private:
+  static constexpr size_t pause_buckets = 12;
+  // a run profile, as sampled and as persisted in the state file
+  struct profile {
+    std::string main;                 // main class, -jar file or main module of the JVM
+    std::vector<std::string> options; // options the tuner set for the run
+    int64_t uptime_ms{0};
+    int exit_status{0};
+    bool is_oom_killed{false};        // SIGKILLed without the watchdog having killed it
+    uint64_t gc_count{0};
+    double gc_ms{0.0};
+    uint64_t full_gc_count{0};
+    std::array<uint64_t, pause_buckets> pauses{}; // counts of pauses up to pause_bounds_ms[i]
+    double max_pause_ms{0.0};
+    uint64_t heap_max_kb{0};
+    uint64_t heap_peak_kb{0};         // peak occupancy
+    uint64_t rss_peak_kb{0};
+    uint64_t native_peak_kb{0};       // peak RSS beyond the committed heap
+    uint64_t metaspace_peak_kb{0};
+    uint64_t compiles{0};
+    double compile_ms{0.0};
+    uint64_t code_kb{0};              // size of the code compiled (cumulative)
+    bool is_code_cache_full{false};
+    double throttled_pct{0.0};
+    double pause_pct(double pct) const;
+  };
+  const tuning_settings &cfg;
+  const jdk_info &jdk;
+  std::vector<std::string> owned;     // names of the options the tuner may set (those the user doesn't)
+  bool is_g1{false};
+  bool is_concurrent_gc{false};       // ZGC or Shenandoah, whose collectors are not pauses
+  bool is_tiered{true};
+  profile run;
+  pid_t pid{0};
+  event_loop *loop{nullptr};
+  int sample_timer{-1};
+  int statm_fd{-1};
+  hsperf_reader hsperf;
+  int samples{0};
+  int64_t attach_ns{0};
+  int64_t prev_gc_count{-1};
+  int64_t prev_gc_ticks{-1};
+  int64_t prev_safepoint_ticks{-1};
+  uint64_t start_periods{0};
+  uint64_t start_throttled{0};
+  std::string output_carry;
+  void sample();
+  void on_output(const std::string_view chunk);
+  bool read_profile(profile &prior) const;
+  void write_profile() const;
+public:
+  jvm_tuner(const tuning_settings &cfg, const jdk_info &jdk) : cfg{cfg}, jdk{jdk} {}
+  jvm_tuner(const jvm_tuner &) = delete;
+  jvm_tuner& operator=(const jvm_tuner &) = delete;
+  ~jvm_tuner() { detach(); }
+
+  // sets the adjusted options per the profile of state_file; call prior to fork() of each launch
+  // (returns true if the options changed)
+  bool prepare(jvm_args &args);
+  // starts profiling the run; call in the parent after fork()
+  void attach(event_loop &loop, pid_t pid, output_relay *relay);
+  void detach();
+
+  // writes the profile of the terminated run to state_file
+  void finish(int status, bool is_killed, long max_rss_kb);
+};
+
+#endif //__TUNING_H__